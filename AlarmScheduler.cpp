@@ -0,0 +1,242 @@
+#include "AlarmScheduler.h"
+
+// Next time after 'after' that an alarm at hour:min on one of the 'wdays'
+// fires. 'wday' is the day of week of 'after', 1 (Monday) .. 7 (Sunday), so
+// week days follow the RTC day of week.
+static EPOCH_T next_fire(
+  uint8_t hour,
+  uint8_t min,
+  uint8_t wdays,
+  EPOCH_T after,
+  uint8_t wday
+  )
+{
+  EPOCH_T midnight = after - (after % EPOCH_DAY);
+  EPOCH_T fire = midnight + (hour * EPOCH_HOUR) + (min * EPOCH_MINUTE);
+
+  wday--;                             // 0 (Monday) .. 6 (Sunday).
+  if (!(wdays & ALARM_EVERY_DAY))
+  {
+    wdays = ALARM_EVERY_DAY;
+  }
+
+  if (fire <= after)
+  {
+    fire += EPOCH_DAY;
+    wday = (wday + 1) % 7;
+  }
+
+  while (!(wdays & (1 << wday)))
+  {
+    fire += EPOCH_DAY;
+    wday = (wday + 1) % 7;
+  }
+
+  return fire;
+}
+
+AlarmScheduler::AlarmScheduler(ALARM_HANDLER_T alarm_handler)
+: count(0), last_id(0), programmed(0), reprogram(false),
+  handler(alarm_handler)
+{ }
+
+void AlarmScheduler::swap(uint8_t a, uint8_t b)
+{
+  SOFT_ALARM_T temp = heap[a];
+  heap[a] = heap[b];
+  heap[b] = temp;
+}
+
+void AlarmScheduler::siftUp(uint8_t idx)
+{
+  while (idx > 0)
+  {
+    uint8_t parent = (idx - 1) / 2;
+
+    if (heap[parent].next <= heap[idx].next)
+      break;
+    swap(parent, idx);
+    idx = parent;
+  }
+}
+
+void AlarmScheduler::siftDown(uint8_t idx)
+{
+  while (true)
+  {
+    uint8_t smallest = idx;
+    uint8_t left = (2 * idx) + 1;
+    uint8_t right = left + 1;
+
+    if (left < count && heap[left].next < heap[smallest].next)
+      smallest = left;
+    if (right < count && heap[right].next < heap[smallest].next)
+      smallest = right;
+    if (smallest == idx)
+      break;
+    swap(smallest, idx);
+    idx = smallest;
+  }
+}
+
+// Program the top of the heap into the DS3231 Alarm 1, if it has changed.
+// Queued, so the I2C writes don't hold up the caller, unless the queue is
+// full. Then the queue is finished first and the write is made directly, so
+// it still lands after the older queued writes and after the alarm time.
+void AlarmScheduler::program()
+{
+  uint8_t top = count ? heap[0].id : 0;
+  RTC_OP_T op;
+
+  if (top == programmed && !reprogram)
+    return;
+  programmed = top;
+  reprogram = false;
+
+  op.alarm_id = ALARM1;
+  if (count)
+  {
+    TM_T fire;
+
+    // Match the date too, so the DS3231 only triggers on the day it is due.
+    epoch_to_tm(heap[0].next, &fire);
+    op.op = RTC_OP_SET_ALARM_TIME;
+    op.alarm_time.tm_sec = 0;
+    op.alarm_time.tm_min = heap[0].min;
+    op.alarm_time.tm_hour = heap[0].hour;
+    op.alarm_time.tm_day = fire.tm_mday;
+    op.alarm_time.mode = ALARM_MATCH_DATE;
+    if (!rtc_submit(&op, NULL))
+    {
+      while (rtc_service());
+      set_alarm_time(ALARM1, &op.alarm_time);
+    }
+  }
+
+  op.op = RTC_OP_SET_ALARM;
+  op.enable = (count != 0);
+  if (!rtc_submit(&op, NULL))
+  {
+    while (rtc_service());
+    set_alarm(ALARM1, op.enable);
+  }
+}
+
+uint8_t AlarmScheduler::add(
+  uint8_t hour,
+  uint8_t min,
+  uint8_t wdays,
+  bool repeat,
+  const TM_T *now
+  )
+{
+  SOFT_ALARM_T *alarm;
+
+  if (count == ALARM_SCHED_SIZE)
+    return 0;
+
+  if (++last_id == 0)
+    last_id = 1;
+
+  alarm = &heap[count];
+  alarm->id = last_id;
+  alarm->hour = hour;
+  alarm->min = min;
+  alarm->wdays = wdays;
+  alarm->repeat = repeat;
+  alarm->next = next_fire(hour, min, wdays, tm_to_epoch(now), now->tm_wday);
+  siftUp(count++);
+
+  program();
+  return last_id;
+}
+
+bool AlarmScheduler::remove(uint8_t id)
+{
+  for (uint8_t idx=0; idx < count; idx++)
+  {
+    if (heap[idx].id == id)
+    {
+      // Move the last alarm into the gap and restore the heap order.
+      heap[idx] = heap[--count];
+      if (idx < count)
+      {
+        siftUp(idx);
+        siftDown(idx);
+      }
+      program();
+      return true;
+    }
+  }
+  return false;
+}
+
+// Clears A1F before the next alarm is programmed, queued like program()'s
+// writes so it lands before them.
+void AlarmScheduler::clearFlag()
+{
+  RTC_OP_T op;
+
+  op.op = RTC_OP_CLEAR_ALARM;
+  op.alarm_id = ALARM1;
+  if (!rtc_submit(&op, NULL))
+  {
+    while (rtc_service());
+    clear_alarm(ALARM1);
+  }
+}
+
+void AlarmScheduler::service(const TM_T *now)
+{
+  EPOCH_T now_epoch = tm_to_epoch(now);
+  EPOCH_T due = 0;
+  uint8_t enabled, triggered;
+
+  if (now_epoch >= ALARM_SCHED_GRACE_S)
+  {
+    due = now_epoch - ALARM_SCHED_GRACE_S;
+  }
+
+  // A1F is only for the top of the heap if it is due by now. The software
+  // clock may be a little behind the RTC, so allow a second.
+  get_alarm_status(&enabled, &triggered);
+  if ((triggered & ALARM1) && count && heap[0].next <= now_epoch + 1)
+  {
+    clearFlag();
+    due = max(heap[0].next, now_epoch);
+  }
+
+  while (count && heap[0].next <= due)
+  {
+    uint8_t id = heap[0].id;
+
+    if (heap[0].repeat)
+    {
+      EPOCH_T after = max(heap[0].next, now_epoch);
+      uint8_t wday = (now->tm_wday - 1 +
+        (uint8_t)((after / EPOCH_DAY) - (now_epoch / EPOCH_DAY))) % 7;
+
+      heap[0].next = next_fire(heap[0].hour, heap[0].min, heap[0].wdays,
+        after, wday + 1);
+    }
+    else
+    {
+      heap[0] = heap[--count];
+    }
+    siftDown(0);
+
+    // Force reprogramming as the same alarm could be at the top again, or
+    // none at all.
+    reprogram = true;
+
+    if (handler)
+      handler(id);
+  }
+
+  program();
+}
+
+const SOFT_ALARM_T *AlarmScheduler::next()
+{
+  return count ? &heap[0] : NULL;
+}
@@ -0,0 +1,144 @@
+#ifndef ALARM_SCHEDULER_
+#define ALARM_SCHEDULER_
+/*!
+ * \file
+ *
+ * \brief Software alarms, scheduled on the DS3231 Alarm 1.
+ *
+ * Any number of alarms (up to #ALARM_SCHED_SIZE) can be added, each for a
+ * time of day on a set of week days, either once or repeating. They are
+ * kept in a min-heap ordered by the next time they fire, so the nearest
+ * alarm is always at the top. Only that one is programmed into the DS3231
+ * as #ALARM1, matching the date as well as the time so the DS3231 only
+ * triggers on the day it is due, and reprogrammed each time the top of the
+ * heap changes.
+ *
+ * The alarms fire from the DS3231: service() reads the Alarm 1 flag (A1F),
+ * and when it is set clears it, fires the alarms due then and programs the
+ * next one. Call it when the INT/SQW line falls, and once a second.
+ *
+ * NOTES:
+ *      - The scheduler owns #ALARM1, it should not be set by anything else.
+ *      - With the 1Hz square wave on (see set_square_wave) INTCN is clear,
+ *        so Alarm 1 can't pull INT/SQW low. A1F is still set, so the once a
+ *        second call on the square wave edge finds it.
+ *      - As a fallback an alarm also fires if the software clock is
+ *        #ALARM_SCHED_GRACE_S past it and A1F hasn't been seen. e.g. if the
+ *        time was set past it, or it was programmed after the time passed.
+ *      - service() reads A1F from the register shadow (see rtc_refresh) and
+ *        only compares the time with the top of the heap, so it is O(1)
+ *        unless an alarm fires, when it is O(log n).
+ */
+
+#include <Arduino.h>
+
+#include "DS3231_RTC.h"
+#include "Epoch.h"
+
+/*!
+ * \defgroup ALARM_SCHED definitions
+ * \{
+ */
+#define ALARM_SCHED_SIZE (16)       /*!< Max number of software alarms. */
+#define ALARM_MONDAY (0x01)         /*!< Week day mask bit for Monday. */
+#define ALARM_SUNDAY (0x40)         /*!< Week day mask bit for Sunday. */
+#define ALARM_WEEKDAYS (0x1F)       /*!< Monday to Friday. */
+#define ALARM_WEEKEND (0x60)        /*!< Saturday and Sunday. */
+#define ALARM_EVERY_DAY (0x7F)      /*!< Every day of the week. */
+#define ALARM_SCHED_GRACE_S (2)     /*!< Seconds late before the fallback. */
+/*! \} */
+
+/*!
+ * \brief Function called when a software alarm fires.
+ *
+ * \param id The id returned when the alarm was added.
+ */
+typedef void (*ALARM_HANDLER_T)(uint8_t id);
+
+/*!
+ * \brief SOFT_ALARM_T struct for a software alarm.
+ */
+typedef struct _soft_alarm {
+  EPOCH_T next;         /*!< When the alarm next fires. */
+  uint8_t id;           /*!< Alarm id, 1..255. */
+  uint8_t hour;         /*!< Hour in the day - range 0..23 */
+  uint8_t min;          /*!< Minute in the hour - range 0..59 */
+  uint8_t wdays;        /*!< Week days mask, bit 0 (Monday) .. 6 (Sunday). */
+  bool repeat;          /*!< Repeat every week day, or fire once. */
+} SOFT_ALARM_T;
+
+/*!
+ * \brief AlarmScheduler class
+ */
+class AlarmScheduler
+{
+  SOFT_ALARM_T heap[ALARM_SCHED_SIZE];
+  uint8_t count;
+  uint8_t last_id;
+  uint8_t programmed;       // Id of the alarm programmed in the DS3231.
+  bool reprogram;           // Program it even if the id is the same.
+  ALARM_HANDLER_T handler;
+
+  void swap(uint8_t a, uint8_t b);
+  void siftUp(uint8_t idx);
+  void siftDown(uint8_t idx);
+  void program();
+  void clearFlag();
+public:
+  /*!
+   * \brief Constructor.
+   *
+   * \param alarm_handler Function to call when an alarm fires.
+   */
+  AlarmScheduler(ALARM_HANDLER_T alarm_handler = NULL);
+
+  /*!
+   * \brief Add an alarm.
+   *
+   * \param hour Hour the alarm fires - range 0..23.
+   * \param min Minute the alarm fires - range 0..59.
+   * \param wdays Week days the alarm fires e.g. #ALARM_WEEKDAYS.
+   * \param repeat True to repeat every week, False to fire once and remove.
+   * \param now The current date and time.
+   *
+   * \result The alarm id, or 0 if there are already #ALARM_SCHED_SIZE.
+   */
+  uint8_t add(
+    uint8_t hour,
+    uint8_t min,
+    uint8_t wdays,
+    bool repeat,
+    const TM_T *now
+    );
+
+  /*!
+   * \brief Remove an alarm.
+   *
+   * \param id The id returned when the alarm was added.
+   *
+   * \result True if the alarm was found and removed.
+   */
+  bool remove(uint8_t id);
+
+  /*!
+   * \brief Fire any alarms that are due.
+   *
+   * Call when the INT/SQW line falls and once a second. If the DS3231 has
+   * set A1F, clears it and calls the alarm handler for each alarm due at
+   * that time, reschedules those that repeat and programs the next alarm
+   * into the DS3231. Alarms #ALARM_SCHED_GRACE_S or more overdue are fired
+   * without A1F.
+   *
+   * \param now The current date and time.
+   */
+  void service(const TM_T *now);
+
+  /*!
+   * \brief The next alarm to fire.
+   *
+   * \result Pointer to the alarm, or NULL if there are none.
+   */
+  const SOFT_ALARM_T *next();
+};
+
+#endif // ALARM_SCHEDULER_
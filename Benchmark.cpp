@@ -0,0 +1,123 @@
+#include "Benchmark.h"
+#include "DS3231_RTC.h"
+#include "DateTime.h"
+#include "DisplayList.h"
+#include "Epoch.h"
+#include "Glyph.h"
+
+static const int GLYPH_UPDATES = 600;  // 10 minutes of seconds.
+
+// Time GLYPH_UPDATES one second updates from 23:55:00, so that every digit
+// changes, and print the average time and glyph traffic per update.
+static void time_updates(const char *name, DisplayTime &dt)
+{
+  EPOCH_T epoch = EPOCH_DAY - (5 * EPOCH_MINUTE);
+  unsigned long elapsed = 0;
+  GLYPH_STATS_T stats;
+  TM_T now;
+
+  dt.Display(*epoch_to_tm(epoch, &now));
+  glyph_get_stats(&stats, true);
+  for (int idx=0; idx < GLYPH_UPDATES; idx++)
+  {
+    unsigned long start;
+
+    epoch_to_tm(++epoch, &now);
+    start = micros();
+    dt.Update(now);
+    elapsed += micros() - start;
+  }
+  glyph_get_stats(&stats, true);
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(elapsed / GLYPH_UPDATES);
+  Serial.print("us, ");
+  Serial.print(stats.pixels / GLYPH_UPDATES);
+  Serial.print(" pixels, ");
+  Serial.print((float)stats.windows / GLYPH_UPDATES);
+  Serial.println(" windows per update");
+}
+
+void bench_glyphs(Adafruit_ILI9341_STM* tft)
+{
+  DisplayTime dt(tft, 44, 36);
+
+  Serial.println("DisplayTime::Update benchmark");
+  glyph_enable(false);
+  time_updates("drawChar", dt);
+  glyph_enable(true);
+  glyph_enable_delta(false);
+  time_updates("glyph_draw", dt);
+  glyph_enable_delta(true);
+  time_updates("glyph_draw_delta", dt);
+}
+
+static unsigned long cost_start;
+
+void bench_cost_start(void)
+{
+  DL_COST_T cost;
+
+  displaylist.getCost(&cost, true);
+  cost_start = micros();
+}
+
+void bench_cost_print(const char *name)
+{
+  unsigned long elapsed = micros() - cost_start;
+  DL_COST_T cost;
+
+  displaylist.getCost(&cost, true);
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(cost.recorded);
+  Serial.print(" ops, ");
+  Serial.print(cost.executed);
+  Serial.print(" executed, ");
+  Serial.print(cost.windows);
+  Serial.print(" windows, ");
+  Serial.print(cost.pixels);
+  Serial.print(" pixels, ");
+  Serial.print(cost.bytes);
+  Serial.print(" bytes, ");
+  Serial.print(dl_bus_time_us(&cost, TFT_SPI_HZ));
+  Serial.print("us on the bus, measured ");
+  Serial.print(elapsed);
+  Serial.println("us");
+}
+
+// Print the size of a class, in bytes of RAM per instance.
+static void print_size(const char *name, size_t size)
+{
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print((unsigned long)size);
+  Serial.println(" bytes");
+}
+
+#define PRINT_SIZE(type) print_size(#type, sizeof(type))
+
+void bench_sizes(void)
+{
+  Serial.println("Class sizes");
+  PRINT_SIZE(Component);
+  PRINT_SIZE(Digit);
+  PRINT_SIZE(Colon);
+  PRINT_SIZE(Fullstop);
+  PRINT_SIZE(DoubleDigit);
+  PRINT_SIZE(MonthString);
+  PRINT_SIZE(OrdinalString);
+  PRINT_SIZE(WeekDay);
+  PRINT_SIZE(Button);
+  PRINT_SIZE(Label);
+  PRINT_SIZE(DisplayTimeWidget);
+  PRINT_SIZE(DisplayDateFullWidget);
+  PRINT_SIZE(DisplayDateWidget);
+  PRINT_SIZE(DisplayTempWidget);
+  PRINT_SIZE(DisplayAlarmWidget);
+  PRINT_SIZE(SetTime);
+  PRINT_SIZE(SetDate);
+  PRINT_SIZE(SetDayOfWeek);
+}
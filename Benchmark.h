@@ -0,0 +1,59 @@
+#ifndef BENCHMARK_
+#define BENCHMARK_
+/*!
+ * \file
+ *
+ * \brief On target benchmarks, results are printed on the Serial port.
+ *
+ * These are only run if BENCHMARK is defined in DigitalClock.ino, once at
+ * the end of setup(). Serial must already be initialised. The DS3231 driver,
+ * its BCD codecs and the widgets are benchmarked on the host instead, see
+ * host/bench_rtc.cpp, host/bench_bcd.cpp and host/bench_widgets.cpp.
+ */
+
+#include <Arduino.h>
+#include <Adafruit_ILI9341_STM.h>   // STM32 DMA Hardware-specific library
+
+/*!
+ * \brief Benchmark drawing the clock digits.
+ *
+ * Times DisplayTime::Update once a second over 10 minutes of time, including
+ * an hour and day rollover, with the digits drawn by drawChar(), glyph_draw()
+ * and glyph_draw_delta(). Prints the average time and pixels sent per update
+ * of each (drawChar() pixels aren't counted). Draws over the top half of the
+ * screen.
+ *
+ * \param tft Pointer to ILI9341 screen instance.
+ */
+void bench_glyphs(Adafruit_ILI9341_STM* tft);
+
+/*!
+ * \brief Start measuring what drawing costs on the display SPI bus.
+ *
+ * Resets the display list costs, see DisplayList::getCost(), and the
+ * timer for bench_cost_print().
+ */
+void bench_cost_start(void);
+
+/*!
+ * \brief Print what was drawn since bench_cost_start().
+ *
+ * Prints the display list ops recorded and executed, address windows,
+ * pixels and SPI bytes, the bus time that takes at #TFT_SPI_HZ and the time
+ * measured with micros(). Drawing done directly on the display rather than
+ * through a display list isn't counted.
+ *
+ * \param name Name to print the costs under.
+ */
+void bench_cost_print(const char *name);
+
+/*!
+ * \brief Print the size of each GUI component and widget class.
+ *
+ * The RAM each instance takes, so changes to the class layouts can be
+ * compared. Constant tables shared by all the instances are in flash and
+ * aren't included.
+ */
+void bench_sizes(void);
+
+#endif // BENCHMARK_
@@ -3,6 +3,34 @@
 // This is the hardcoded RTC module I2C address.
 static const uint8_t DS3231_I2C_ADDRESS = 0x68;
 
+// Shadow copy of registers 0x00 to 0x10, and when it was last read. The
+// temperature registers 0x11-0x12 are cached at the end, read separately.
+static uint8_t shadow[0x13];
+static bool shadow_valid = false;
+static unsigned long shadow_millis;
+
+// Temperature cache - when converted, if a conversion is in progress and if
+// it is an automatic one, and if temp_millis is on the automatic cycle.
+static bool temp_valid = false;
+static bool temp_converting = false;
+static bool temp_auto = false;
+static bool temp_locked = false;
+static unsigned long temp_millis;
+
+// I2C bus usage.
+static RTC_BUS_STATS_T bus_stats;
+
+// Queue of asynchronous operations, and the progress of the one at the head.
+static const uint8_t STEP_DONE = 0xFF;
+static struct {
+  RTC_OP_T op;
+  RTC_CALLBACK_T callback;
+} queue[RTC_QUEUE_SIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_count = 0;
+static uint8_t queue_step = 0;
+static uint8_t queue_reg;
+
 // Helper function that converts char Binary Coded Decimal (BCD) value into decimal.
 static uint8_t bcd2dec(char mask, char val)
 {
@@ -16,236 +44,531 @@ static char dec2bcd(uint8_t val)
   return (char)(((val/10) << 4) | val % 10);
 }
 
-// Reads the date/time from DS2321 Registers 0x00 to 0x06 (7 bytes), directly 
-// into the TM_T structure. The values are converted from BCD into decimal.
-TM_T *get_date_time(TM_T *date_time)
+// Per register masks of the date/time BCD digits, Registers 0x00 to 0x03 and
+// 0x04 to 0x06. The Month Register Century bit is masked out.
+static const uint32_t TIME_MASK = 0x073F7F7FUL;
+static const uint32_t DATE_MASK = 0x00FF1F3FUL;
+
+// Converts 4 packed BCD bytes into decimal. Each byte is at most 99 so it
+// can't carry into the next.
+static uint32_t bcd2dec_x4(uint32_t val)
+{
+  return (val & 0x0F0F0F0FUL) + ((val >> 4) & 0x0F0F0F0FUL) * 10;
+}
+
+// Converts 4 packed decimal bytes (0..99) into BCD: bcd = val + 6 * tens.
+// The tens are (val * 103) >> 10, done on alternate bytes in 16-bit lanes.
+static uint32_t dec2bcd_x4(uint32_t val)
 {
-    uint8_t *ptr = (uint8_t *)date_time;
+  uint32_t even = ((( val       & 0x00FF00FFUL) * 103) >> 10) & 0x000F000FUL;
+  uint32_t odd  = ((((val >> 8) & 0x00FF00FFUL) * 103) >> 10) & 0x000F000FUL;
+
+  return val + (even | (odd << 8)) * 6;
+}
+
+// Packs 4 bytes, little endian.
+static uint32_t pack4(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3)
+{
+  return (uint32_t)b0 | ((uint32_t)b1 << 8) | 
+         ((uint32_t)b2 << 16) | ((uint32_t)b3 << 24);
+}
 
-    // Set I2C to the DS3231 address and the register to read from, register 0x00.
+// Writes 'len' bytes to the DS3231 starting at register 'reg'. A 'len' of 0
+// only sets the register pointer, ready for a read.
+static void rtc_write(uint8_t reg, const uint8_t *data, uint8_t len)
+{
     Wire.beginTransmission(DS3231_I2C_ADDRESS);
-    Wire.write(0x00);
+    Wire.write(reg);
+    for (uint8_t idx=0; idx < len; idx++)
+    {
+      Wire.write(data[idx]);
+    }
     Wire.endTransmission();
 
-    // Read the 7 bytes from register 0x00 to 0x06.
-    Wire.requestFrom(DS3231_I2C_ADDRESS, 7);
-    while(Wire.available())
+    bus_stats.transactions += 1;
+    bus_stats.bytes += 2 + len;     // I2C address, register and data.
+}
+
+// Reads 'len' bytes from the DS3231 starting at register 'reg'.
+static void rtc_read(uint8_t reg, uint8_t *data, uint8_t len)
+{
+    uint8_t count = 0;
+
+    rtc_write(reg, NULL, 0);
+
+    Wire.requestFrom(DS3231_I2C_ADDRESS, len);
+    while(Wire.available() && count < len)
     {
-      *ptr++ = bcd2dec( 0x7F, Wire.read() );
+      data[count++] = Wire.read();
     }
-    
-    return date_time;
+
+    bus_stats.transactions += 1;
+    bus_stats.bytes += 1 + len;     // I2C address and data.
 }
 
-// Reads the temperature from registers 0x11 (whole) and 0x12 (fraction).
-// For the temp, only interested in 0.5 degree changes, whereas the register
-// used the top two bits  to represent 0.0, 0,25, 0.5 and 0,75. By only reading 
-// the top bit and checking for that, give the 0.5 degree step. 
-TEMP_T *get_temp(TEMP_T *temp)
+// Returns the shadow registers, burst reading them again if they are stale.
+// 'reads' and 'len' describe the I2C access the caller would have made
+// without the shadow: number of register reads and total bytes read.
+static const uint8_t *shadow_regs(uint8_t reads, uint8_t len)
 {
-    uint8_t *ptr = (uint8_t *)temp;
-    
-    Wire.beginTransmission(DS3231_I2C_ADDRESS);
-    Wire.write(0x11);
-    Wire.endTransmission();
+    if (!shadow_valid || (millis() - shadow_millis) >= RTC_SHADOW_TTL_MS)
+    {
+        rtc_refresh();
+    }
+    bus_stats.saved_transactions += 2 * reads;
+    bus_stats.saved_bytes += (3 * reads) + len;
+    return shadow;
+}
 
-    // Read 2 bytes from register 0x11 to 0x12.
-    Wire.requestFrom(DS3231_I2C_ADDRESS, 2);
-    while(Wire.available())
+void rtc_refresh(void)
+{
+    rtc_read(0x00, shadow, RTC_SHADOW_SIZE);
+    shadow_valid = true;
+    shadow_millis = millis();
+}
+
+void rtc_get_bus_stats(RTC_BUS_STATS_T *stats, bool reset)
+{
+    *stats = bus_stats;
+    if (reset)
     {
-      *ptr++ = Wire.read();  // Temp is NOT BCD encoded.
-      *ptr = (0x80 & Wire.read()) ? 5 : 0;
+        memset(&bus_stats, 0, sizeof(bus_stats));
     }
+}
 
-    return temp;
+uint32_t rtc_bus_time_us(const RTC_BUS_STATS_T *stats, uint32_t clock_hz)
+{
+    uint64_t clocks = (9ULL * stats->bytes) + (2ULL * stats->transactions);
+
+    return (uint32_t)((clocks * 1000000ULL) / clock_hz);
 }
 
-void set_date_time(TM_T *date_time)
+void rtc_decode_date_time(const uint8_t *regs, TM_T *date_time)
 {
-    // Set I2C to the DS3231 address and the register to read from, register 0x00.
-    Wire.beginTransmission(DS3231_I2C_ADDRESS);
-    Wire.write(0x00); // register 0x00
-    Wire.write( dec2bcd(date_time->tm_sec) ); 
-    Wire.write( dec2bcd(date_time->tm_min) ); 
-    Wire.write( dec2bcd(date_time->tm_hour) );
-    Wire.write( date_time->tm_wday );
-    Wire.write( dec2bcd(date_time->tm_mday) );
-    Wire.write( dec2bcd(date_time->tm_mon) );
-    Wire.write( dec2bcd(date_time->tm_year) );
-    Wire.endTransmission();
+    uint32_t time = pack4(regs[0], regs[1], regs[2], regs[3]);
+    uint32_t date = pack4(regs[4], regs[5], regs[6], 0);
+
+    time = bcd2dec_x4(time & TIME_MASK);
+    date = bcd2dec_x4(date & DATE_MASK);
+
+    date_time->tm_sec = (uint8_t)time;
+    date_time->tm_min = (uint8_t)(time >> 8);
+    date_time->tm_hour = (uint8_t)(time >> 16);
+    date_time->tm_wday = (uint8_t)(time >> 24);
+    date_time->tm_mday = (uint8_t)date;
+    date_time->tm_mon = (uint8_t)(date >> 8);
+    date_time->tm_year = (uint8_t)(date >> 16);
+    date_time->tm_century = regs[5] >> 7;
 }
 
-// Reads registers 0x08-0x09 (AL1M2-AL1M3) for Alarm1 - Seconds is always 0
-// Reads registers 0x0B-0x0C (AL1M2-AL2M3) for Alarm2 
-uint8_t get_alarm_time(uint8_t alarm_id, ALARM_T *alarm_time)
+void rtc_encode_date_time(const TM_T *date_time, uint8_t *regs)
 {
-    int result = 0;
+    uint32_t time = dec2bcd_x4(pack4(date_time->tm_sec, date_time->tm_min,
+                                     date_time->tm_hour, date_time->tm_wday));
+    uint32_t date = dec2bcd_x4(pack4(date_time->tm_mday, date_time->tm_mon,
+                                     date_time->tm_year, 0));
+
+    regs[0] = (uint8_t)time;
+    regs[1] = (uint8_t)(time >> 8);
+    regs[2] = (uint8_t)(time >> 16);
+    regs[3] = (uint8_t)(time >> 24);
+    regs[4] = (uint8_t)date;
+    regs[5] = (uint8_t)(date >> 8) | (date_time->tm_century ? 0x80 : 0x00);
+    regs[6] = (uint8_t)(date >> 16);
+}
 
-    if (alarm_id == ALARM1 || alarm_id == ALARM2) {
-        uint8_t *ptr = (uint8_t *)alarm_time;
-        uint8_t alarm_reg = 0x08;           // Alarm 1 by default.
+// Writes a single register, keeping the shadow in step.
+static void write_reg(uint8_t reg, uint8_t val)
+{
+    rtc_write(reg, &val, 1);
+    shadow[reg] = val;
+}
 
-        if (alarm_id == ALARM2) {
-            alarm_reg = 0x0B;               // Alarm 2.
-        }
+// One step of a read-modify-write of register 'reg'. Step 0 reads the
+// register into 'val', step 1 clears the 'clear' bits, sets the 'set' bits
+// and writes it back.
+static uint8_t rmw_step(
+    uint8_t reg,
+    uint8_t clear,
+    uint8_t set,
+    uint8_t step,
+    uint8_t *val
+    )
+{
+    if (step == 0)
+    {
+        rtc_read(reg, val, 1);
+        return 1;
+    }
+    write_reg(reg, (*val & ~clear) | set);
+    return STEP_DONE;
+}
 
-        // set the register to read from - alarm1 or alarm2.
-        Wire.beginTransmission(DS3231_I2C_ADDRESS);
-        Wire.write(alarm_reg);
-        Wire.endTransmission();
+// Checks an alarm mode is one of the ALARM_MATCH_ combinations.
+static bool valid_mode(uint8_t mode)
+{
+    switch (mode)
+    {
+        case ALARM_MATCH_NONE:
+        case ALARM_MATCH_SECONDS:
+        case ALARM_MATCH_MINUTES:
+        case ALARM_MATCH_HOURS:
+        case ALARM_MATCH_DATE:
+        case ALARM_MATCH_DAY:
+            return true;
+        default:
+            return false;
+    }
+}
 
-        // read 2 bytes from the alarm registers - minutes & hours
-        Wire.requestFrom(DS3231_I2C_ADDRESS, 2);
-        while(Wire.available())
-        {
-          *ptr++ = bcd2dec( 0x7F, Wire.read() );
-        }
+// Checks the operation and its alarm id.
+static bool valid_op(const RTC_OP_T *op)
+{
+    switch (op->op)
+    {
+        case RTC_OP_SET_ALARM_TIME:
+            if (!valid_mode(op->alarm_time.mode))
+                return false;
+            // Fall through.
+        case RTC_OP_SET_ALARM:
+            return op->alarm_id == ALARM1 || op->alarm_id == ALARM2;
+        case RTC_OP_CLEAR_ALARM:
+            return (op->alarm_id & ALARM_MASK) != 0;
+        default:
+            return op->op <= RTC_OP_SQUARE_WAVE;
+    }
+}
 
-        result = 1;
+// Performs one register access of the operation 'op'. 'step' starts at 0
+// and 'val' carries a register read in one step to the next. Returns the
+// next step, or STEP_DONE when the operation is complete.
+static uint8_t op_step(const RTC_OP_T *op, uint8_t step, uint8_t *val)
+{
+    uint8_t regs[7];
+    uint8_t len = 0;
+    uint8_t alarm_reg;
+    uint8_t mode;
+
+    switch (op->op)
+    {
+        case RTC_OP_REFRESH:
+            rtc_refresh();
+            break;
+
+        // Write registers 0x00 to 0x06.
+        case RTC_OP_SET_DATE_TIME:
+            rtc_encode_date_time(&op->date_time, regs);
+            rtc_write(0x00, regs, 7);
+            memcpy(shadow, regs, 7);
+            break;
+
+        // Writes registers 0x07-0x0A for Alarm1 or 0x0B-0x0D for Alarm2, with
+        // the mode in the AxMx mask bits (bit 7) and DY/DT bit (bit 6 of the
+        // day/date register). Alarm2 has no seconds register.
+        case RTC_OP_SET_ALARM_TIME:
+            alarm_reg = 0x07;               // Alarm 1 by default.
+            mode = op->alarm_time.mode;
+            if (op->alarm_id == ALARM2) {
+                alarm_reg = 0x0B;           // Alarm 2.
+                mode >>= 1;                 // No A2M1.
+            }
+            else {
+                regs[len++] = dec2bcd(op->alarm_time.tm_sec) | ((mode & 1) << 7);
+                mode >>= 1;
+            }
+            regs[len++] = dec2bcd(op->alarm_time.tm_min) | ((mode & 1) << 7);
+            regs[len++] = dec2bcd(op->alarm_time.tm_hour) | ((mode & 2) << 6);
+            regs[len++] = dec2bcd(op->alarm_time.tm_day) | ((mode & 4) << 5) |
+                          ((mode & 8) << 3);
+            rtc_write(alarm_reg, regs, len);
+            memcpy(&shadow[alarm_reg], regs, len);
+            break;
+
+        // Sets the appropriate bit in the Control register (after reading
+        // it). If enabling, clears the appropriate bit in the Status register
+        // (after reading it).
+        case RTC_OP_SET_ALARM:
+            switch (step)
+            {
+                case 0:
+                    rtc_read(0x0E, val, 1);
+                    return 1;
+                case 1:
+                    *val &= ~0x20;      // Don't restart a conversion (CONV).
+                    if (op->enable)
+                        write_reg(0x0E, *val | op->alarm_id);
+                    else
+                        write_reg(0x0E, *val & ~op->alarm_id);
+                    return op->enable ? 2 : STEP_DONE;
+                case 2:
+                    rtc_read(0x0F, val, 1);
+                    return 3;
+                default:
+                    write_reg(0x0F, *val & ~op->alarm_id);
+                    return STEP_DONE;
+            }
+
+        // Clears the alarm bit(s) in the Status register.
+        case RTC_OP_CLEAR_ALARM:
+            return rmw_step(0x0F, op->alarm_id, 0, step, val);
+
+        // Control register INTCN (bit 2), RS1 and RS2 (bits 3 and 4).
+        // RS1 = RS2 = 0 selects a 1Hz square wave. CONV (bit 5) is cleared
+        // so as not to restart a conversion.
+        case RTC_OP_SQUARE_WAVE:
+            return rmw_step(0x0E, 0x3C, op->enable ? 0x00 : 0x04, step, val);
     }
-    return result;
+
+    return STEP_DONE;
 }
 
-// Writes registers 0x07-0x09 (AL1M1-AL1M3) for Alarm1 - Seconds is always 0
-// Writes registers 0x0B-0x0C (AL1M2-AL2M3) for Alarm2 
-int set_alarm_time(uint8_t alarm_id, const ALARM_T *alarm_time)
+// Performs all the steps of an operation, blocking until it is complete.
+static int run_op(const RTC_OP_T *op)
 {
-    int result = 0;
+    uint8_t step = 0;
+    uint8_t val;
 
-    if (alarm_id == ALARM1 || alarm_id == ALARM2) {
-        uint8_t alarm_reg = 0x07;       // Alarm 1 by default.
+    if (!valid_op(op))
+    {
+        return 0;
+    }
 
-        if (alarm_id == ALARM2) {
-            alarm_reg = 0x0B;               // Alarm 2.
-        }
+    do
+    {
+        step = op_step(op, step, &val);
+    } while (step != STEP_DONE);
 
-        // Set the register to write to - alarm1 or alarm2.
-        Wire.beginTransmission(DS3231_I2C_ADDRESS);
-        Wire.write( alarm_reg );
-        
-        if (alarm_id == ALARM1) {   // Only required for ALARM1
-          Wire.write( 0 );          // Set seconds to 0.
-        }
-        
-        Wire.write( dec2bcd(alarm_time->tm_min) );
-        Wire.write( dec2bcd(alarm_time->tm_hour) );
-        Wire.endTransmission();
-        
-        result = 1;
+    return 1;
+}
+
+// Decodes the date/time from the shadow of DS2321 Registers 0x00 to 0x06
+// (7 bytes), directly into the TM_T structure. The values are converted from
+// BCD into decimal.
+TM_T *get_date_time(TM_T *date_time)
+{
+    rtc_decode_date_time(shadow_regs(1, 7), date_time);
+
+    return date_time;
+}
+
+// Reads registers 0x0E (Control) to 0x12 in one go and caches them. The
+// temperature registers always hold the last completed conversion, so they
+// are good to use even while the CONV (bit 5) or BSY (bit 2) bits show one
+// is in progress. It is then read again next time, for the new result.
+//
+// temp_millis is when the cached result was converted, as near as is known.
+// An automatic conversion (BSY without CONV) seen running and then finished
+// puts it on the DS3231's 64 second cycle, which is kept from then on by
+// moving it on a whole number of periods. Otherwise it is when it was read,
+// and the result could be from any time in the last period.
+static void read_temp(void)
+{
+    uint8_t regs[5];
+    unsigned long ms;
+
+    rtc_read(0x0E, regs, 5);
+    memcpy(&shadow[0x0E], regs, 5);
+    temp_valid = true;
+
+    if ((regs[0] & 0x20) || (regs[1] & 0x04))
+    {
+        temp_converting = true;
+        temp_auto = !(regs[0] & 0x20);
+        return;
     }
-    
-    return result;
+
+    ms = millis();
+    if (temp_converting && temp_auto)
+    {
+        temp_millis = ms;
+        temp_locked = true;
+    }
+    else if (temp_locked)
+    {
+        temp_millis += ((ms - temp_millis) / RTC_TEMP_PERIOD_MS) *
+            RTC_TEMP_PERIOD_MS;
+    }
+    else
+    {
+        temp_millis = ms;
+    }
+    temp_converting = false;
+    temp_auto = false;
 }
 
-// Sets the A1M4/A2M4 bit 7 to alarm when hours, minutes (and seconds) match.
-// Sets the appropriate bit in the Control register (after reading it).
-// Clears the appropriate bit in the Status register (after readint it).
-int set_alarm(uint8_t alarm_id, bool enable)
+// Decodes the temperature from registers 0x11 (whole) and 0x12 (fraction).
+// The top two bits of the fraction represent 0.0, 0.25, 0.5 and 0.75.
+// For the half degree step, only the top bit is checked.
+TEMP_T *get_temp(TEMP_T *temp)
 {
-    uint8_t temp_reg;
+    if (!temp_valid || temp_converting ||
+        (millis() - temp_millis) >= RTC_TEMP_PERIOD_MS)
+    {
+        read_temp();
+    }
+    else
+    {
+        bus_stats.saved_transactions += 2;
+        bus_stats.saved_bytes += 5;
+    }
+
+    temp->temp_degrees = shadow[0x11];  // Temp is NOT BCD encoded.
+    temp->temp_half = (0x80 & shadow[0x12]) ? 5 : 0;
+    temp->temp_quarters = shadow[0x12] >> 6;
 
+    return temp;
+}
+
+int rtc_convert_temp(void)
+{
+    uint8_t val;
+
+    // Not while the Status BSY bit shows a conversion is in progress.
+    rtc_read(0x0F, &val, 1);
+    if (val & 0x04)
+    {
+        return 0;
+    }
+
+    // Set the Control register CONV bit.
+    rtc_read(0x0E, &val, 1);
+    write_reg(0x0E, val | 0x20);
+    temp_converting = true;
+
+    return 1;
+}
+
+void set_date_time(TM_T *date_time)
+{
+    RTC_OP_T op;
+
+    op.op = RTC_OP_SET_DATE_TIME;
+    op.date_time = *date_time;
+    run_op(&op);
+}
+
+// Decodes registers 0x07-0x0A for Alarm1 or 0x0B-0x0D for Alarm2. The mode
+// is rebuilt from the AxMx mask bits (bit 7) and DY/DT bit.
+uint8_t get_alarm_time(uint8_t alarm_id, ALARM_T *alarm_time)
+{
     int result = 0;
 
     if (alarm_id == ALARM1 || alarm_id == ALARM2) {
-        uint8_t alarm_reg = 0x0A;       // A1M4 by default.
+        const uint8_t *regs = shadow_regs(1, (alarm_id == ALARM2) ? 3 : 4);
+        uint8_t mode;
 
         if (alarm_id == ALARM2) {
-            alarm_reg = 0x0D;               // A2M4.
+            regs += 0x0B;                   // Alarm 2.
+            alarm_time->tm_sec = 0;
+            mode = regs[0] >> 7;            // No A2M1, it follows A2M2.
         }
-
-        // Set the register to write to - A1M4 or A2M4.
-        Wire.beginTransmission(DS3231_I2C_ADDRESS);
-        Wire.write( alarm_reg );
-        if (enable)
-            Wire.write( 0x80 );                 // Set bit 7 - alarm on hours/mins.
-        else 
-            Wire.write( 0x00 );
-        Wire.endTransmission();
-
-        // Read the Control register and then set the appropriate alarm bit.
-        Wire.beginTransmission(DS3231_I2C_ADDRESS);
-        Wire.write( 0x0E );
-        Wire.endTransmission();
-
-        Wire.requestFrom(DS3231_I2C_ADDRESS, 1);
-        while(Wire.available())
-        {
-          temp_reg = Wire.read();
+        else {
+            regs += 0x07;                   // Alarm 1.
+            alarm_time->tm_sec = bcd2dec( 0x7F, *regs );
+            mode = *regs++ >> 7;
         }
 
-        // Now write it back with the appropriate bit set or unset.
-        Wire.beginTransmission(DS3231_I2C_ADDRESS);
-        Wire.write( 0x0E );
-        if (enable)
-            Wire.write( temp_reg | alarm_id );
-        else
-            Wire.write( temp_reg & (~alarm_id) );
-        Wire.endTransmission();
-
-        // If enabling an alarm...
-        // Read the Status register and then clear the alarm bit.
-        if (enable) {
-            clear_alarm(alarm_id);
-        }
-        
+        alarm_time->tm_min = bcd2dec( 0x7F, regs[0] );
+        alarm_time->tm_hour = bcd2dec( 0x3F, regs[1] );
+        alarm_time->tm_day = bcd2dec( (regs[2] & 0x40) ? 0x0F : 0x3F, regs[2] );
+        mode |= ((regs[0] >> 7) << 1) | ((regs[1] >> 7) << 2) |
+                ((regs[2] >> 7) << 3) | ((regs[2] & 0x40) >> 2);
+        alarm_time->mode = mode;
+
         result = 1;
     }
-    
     return result;
 }
 
-// Read the Control and Status registers basically.
-void get_alarm_status(uint8_t *enabled, uint8_t *triggered)
+int set_alarm_time(uint8_t alarm_id, const ALARM_T *alarm_time)
 {
-    int result = 0;
+    RTC_OP_T op;
 
-    // Read the Control register and  mask out all but the Alarm bits.
-    Wire.beginTransmission(DS3231_I2C_ADDRESS);
-    Wire.write( 0x0E );
-    Wire.endTransmission();
+    op.op = RTC_OP_SET_ALARM_TIME;
+    op.alarm_id = alarm_id;
+    op.alarm_time = *alarm_time;
+    return run_op(&op);
+}
 
-    Wire.requestFrom(DS3231_I2C_ADDRESS, 1);
-    while(Wire.available())
-    {
-      *enabled = ALARM_MASK & Wire.read();
-    }
+int set_alarm(uint8_t alarm_id, bool enable)
+{
+    RTC_OP_T op;
 
-    // Read the Status register alarm bits
-    Wire.beginTransmission(DS3231_I2C_ADDRESS);
-    Wire.write( 0x0F );
-    Wire.endTransmission();
+    op.op = RTC_OP_SET_ALARM;
+    op.alarm_id = alarm_id;
+    op.enable = enable;
+    return run_op(&op);
+}
 
-    Wire.requestFrom(DS3231_I2C_ADDRESS, 1);
-    while(Wire.available())
-    {
-      *triggered = ALARM_MASK & Wire.read();
-    }
+// Decode the Control and Status registers basically.
+void get_alarm_status(uint8_t *enabled, uint8_t *triggered)
+{
+    const uint8_t *regs = shadow_regs(2, 2);
+
+    // The Control register alarm bits.
+    *enabled = ALARM_MASK & regs[0x0E];
+
+    // The Status register alarm bits.
+    *triggered = ALARM_MASK & regs[0x0F];
 }
 
 int clear_alarm(uint8_t alarm_id)
 {
-    int result = 0;
+    RTC_OP_T op;
 
-    if (alarm_id & ALARM_MASK) {
-        uint8_t temp_reg;
+    op.op = RTC_OP_CLEAR_ALARM;
+    op.alarm_id = alarm_id;
+    return run_op(&op);
+}
 
-        // Read the Status register.
-        Wire.beginTransmission(DS3231_I2C_ADDRESS);
-        Wire.write( 0x0F );
-        Wire.endTransmission();
+int set_square_wave(bool enable)
+{
+    RTC_OP_T op;
 
-        Wire.requestFrom(DS3231_I2C_ADDRESS, 1);
-        while(Wire.available())
-        {
-          temp_reg = Wire.read();
-        }
+    op.op = RTC_OP_SQUARE_WAVE;
+    op.enable = enable;
+    return run_op(&op);
+}
 
-        // Now write it back with the appropriate bit cleared.
-        Wire.beginTransmission(DS3231_I2C_ADDRESS);
-        Wire.write( 0x0F );
-        Wire.write( temp_reg & (~alarm_id) );
-        Wire.endTransmission();
+int rtc_submit(const RTC_OP_T *op, RTC_CALLBACK_T callback)
+{
+    uint8_t tail;
 
-        result = 1;
+    if (!valid_op(op) || queue_count == RTC_QUEUE_SIZE)
+    {
+        return 0;
+    }
+
+    tail = (queue_head + queue_count) % RTC_QUEUE_SIZE;
+    queue[tail].op = *op;
+    queue[tail].callback = callback;
+    queue_count++;
+
+    return 1;
+}
+
+bool rtc_service(void)
+{
+    if (queue_count)
+    {
+        queue_step = op_step(&queue[queue_head].op, queue_step, &queue_reg);
+
+        if (queue_step == STEP_DONE)
+        {
+            RTC_OP_T op = queue[queue_head].op;
+            RTC_CALLBACK_T callback = queue[queue_head].callback;
+
+            // Remove it from the queue first, so the callback can submit.
+            queue_head = (queue_head + 1) % RTC_QUEUE_SIZE;
+            queue_count--;
+            queue_step = 0;
+
+            if (callback)
+            {
+                callback(&op, 1);
+            }
+        }
     }
+
+    return queue_count != 0;
 }
@@ -13,7 +13,7 @@
  *      - Date: Year, month, day of month, day of week. Automatically days of 
  *        month and for leap years.
  *      - Time: Hours, minutes, seconds - 24/12 hour format.
- *      - Two programmable time of day alarms.
+ *      - Two programmable alarms, from once a second to once a month.
  *      - Programmable square wave output.
  *      - Battery-backup for continuous time-keeping. 
  *      - 3.3v operation.
@@ -29,6 +29,16 @@
  *        has been triggered can be determined by reading the Status Register.
  *        (get_alarm_status) but getting the interrupt (I/O input) is outside
  *        the scope of this API.      
+ *      - Alternatively the INT/SQW pin can output a 1Hz square wave 
+ *        (set_square_wave) to interrupt on every second. The alarm flags are
+ *        still set in the Status Register but no longer drive the pin.
+ *      - Registers 0x00 to 0x10 are mirrored in a shadow copy which is filled
+ *        with a single burst read (rtc_refresh). The get_* functions decode
+ *        from the shadow, so several calls in the same display pass cost one
+ *        I2C read between them rather than one or two each.
+ *      - The temperature registers (0x11-0x12) are only updated by the DS3231
+ *        every 64 seconds, so they are cached separately and only read again
+ *        when a new conversion can have completed (get_temp).
  */
 
 /*!
@@ -44,6 +54,66 @@
 #define ALARM_MASK (0x03)   /*!< Bit mask for #ALARM1 and #ALARM2. */
 /*! \} */
 
+/*!
+ * \defgroup ALARM_MATCH definitions
+ *
+ * Which fields of an ALARM_T must match the time for the alarm to trigger.
+ * Bits 0 to 3 are the A1M1-A1M4 (A2M2-A2M4 for Alarm 2) mask bits and bit 4
+ * is the DY/DT bit. Alarm 2 has no seconds and always triggers at 00
+ * seconds, so for it #ALARM_MATCH_NONE and #ALARM_MATCH_SECONDS both trigger
+ * once per minute.
+ *
+ * \{
+ */
+#define ALARM_MATCH_NONE (0x0F)     /*!< Every second (Alarm 2 - minute). */
+#define ALARM_MATCH_SECONDS (0x0E)  /*!< Seconds (Alarm 2 - every minute). */
+#define ALARM_MATCH_MINUTES (0x0C)  /*!< Minutes and seconds. */
+#define ALARM_MATCH_HOURS (0x08)    /*!< Hours, minutes and seconds. */
+#define ALARM_MATCH_DATE (0x00)     /*!< Date, hours, minutes and seconds. */
+#define ALARM_MATCH_DAY (0x10)      /*!< Day, hours, minutes and seconds. */
+/*! \} */
+
+/*!
+ * \defgroup SHADOW definitions
+ *
+ * Size of the shadow register copy and how long it may be used before a
+ * get_* function will burst read it again.
+ *
+ * \{
+ */
+#define RTC_SHADOW_SIZE (0x11)      /*!< Registers 0x00 to 0x10. */
+#define RTC_SHADOW_TTL_MS (100)     /*!< Max age of the shadow copy in ms. */
+#define RTC_TEMP_PERIOD_MS (64000UL)   /*!< Temperature conversion period. */
+/*! \} */
+
+/*!
+ * \defgroup RTC_OP definitions
+ *
+ * Operations which can be queued with rtc_submit, each is the asynchronous
+ * equivalent of the function of the same name.
+ *
+ * \{
+ */
+#define RTC_OP_REFRESH (0)          /*!< rtc_refresh. */
+#define RTC_OP_SET_DATE_TIME (1)    /*!< set_date_time. */
+#define RTC_OP_SET_ALARM_TIME (2)   /*!< set_alarm_time. */
+#define RTC_OP_SET_ALARM (3)        /*!< set_alarm. */
+#define RTC_OP_CLEAR_ALARM (4)      /*!< clear_alarm. */
+#define RTC_OP_SQUARE_WAVE (5)      /*!< set_square_wave. */
+#define RTC_QUEUE_SIZE (4)          /*!< Max operations queued at once. */
+/*! \} */
+
+/*!
+ * \defgroup I2C_CLOCK definitions
+ *
+ * Standard and Fast mode I2C clock rates, for rtc_bus_time_us.
+ *
+ * \{
+ */
+#define I2C_STANDARD_HZ (100000UL)  /*!< Standard mode - 100kHz. */
+#define I2C_FAST_HZ (400000UL)      /*!< Fast mode - 400kHz. */
+/*! \} */
+
 #include <Wire.h>
 
 /*!
@@ -57,23 +127,28 @@
  * the time. Out of range values will cause the DS3231 module to malfunction.
  *
  * The field order matches the order of I2C Registers on the DS3231 module.
+ * The century is the Century bit (bit 7) of the Month Register (0x05).
  */
 typedef struct _tm {
   uint8_t tm_sec;       /*!< Seconds in the minute - range 0..59 */
   uint8_t tm_min;       /*!< Minutes in the hour - range 0..59 */
   uint8_t tm_hour;      /*!< Hours in the day - range 0..23 */
-  uint8_t tm_wday;      /*!< Day of week - range 0 (Monday) .. 6 (Sunday) */
+  uint8_t tm_wday;      /*!< Day of week - range 1 (Monday) .. 7 (Sunday) */
   uint8_t tm_mday;      /*!< Day in month - range 1..31 */
   uint8_t tm_mon;       /*!< Month in year - range 1..12 */
   uint8_t tm_year;      /*!< Year in century - range 0..99 */
+  uint8_t tm_century;   /*!< Century - 0 (20xx) or 1 (21xx) */
 } TM_T;
 
 /*!
- * \brief Alarm time - hour (24-hour format) and minute for the Alarm.
+ * \brief Alarm time - the fields to match and which of them are used.
  */
 typedef struct _alarm {
   uint8_t tm_min;       /*!< Minute in the hour - range 0..59 */
   uint8_t tm_hour;      /*!< Hour in the day - range 0..23 */
+  uint8_t tm_sec;       /*!< Seconds (Alarm 1 only) - range 0..59 */
+  uint8_t tm_day;       /*!< Date 1..31, or day of week 1..7 */
+  uint8_t mode;         /*!< Fields to match, #ALARM_MATCH_HOURS etc. */
 } ALARM_T;
 
 /*!
@@ -82,8 +157,103 @@ typedef struct _alarm {
 typedef struct _temperature {
   uint8_t temp_degrees;         /*!< Temperature in degrees centigrade. */
   uint8_t temp_half;            /*!< Temperature half degree: 0 or 5 (.5) */
+  uint8_t temp_quarters;        /*!< Fraction in quarter degrees: 0..3 */
 } TEMP_T;
 
+/*!
+ * \brief RTC_OP_T struct for an operation queued with rtc_submit.
+ *
+ * Only the fields used by the operation need to be set.
+ */
+typedef struct _rtc_op {
+  uint8_t op;               /*!< Operation - RTC_OP_REFRESH etc. */
+  uint8_t alarm_id;         /*!< #ALARM1 and/or #ALARM2 for alarm ops. */
+  bool enable;              /*!< For RTC_OP_SET_ALARM, RTC_OP_SQUARE_WAVE. */
+  union {
+    TM_T date_time;         /*!< For RTC_OP_SET_DATE_TIME. */
+    ALARM_T alarm_time;     /*!< For RTC_OP_SET_ALARM_TIME. */
+  };
+} RTC_OP_T;
+
+/*!
+ * \brief Callback made from rtc_service when a queued operation completes.
+ *
+ * \param op The operation that completed.
+ * \param result 1 if successful or 0 otherwise.
+ */
+typedef void (*RTC_CALLBACK_T)(const RTC_OP_T *op, int result);
+
+/*!
+ * \brief RTC_BUS_STATS_T struct for the I2C bus usage of this API.
+ *
+ * A transaction is one addressed I2C transfer, either a write (register
+ * pointer and data) or a read. Bytes include the I2C address byte of each
+ * transaction. The 'saved' counters are what the get_* functions would have
+ * cost had they each read the DS3231 directly instead of the shadow copy.
+ */
+typedef struct _bus_stats {
+  uint32_t transactions;        /*!< I2C transactions performed. */
+  uint32_t bytes;               /*!< Bytes transferred on the bus. */
+  uint32_t saved_transactions;  /*!< Transactions avoided by the shadow. */
+  uint32_t saved_bytes;         /*!< Bytes avoided by the shadow. */
+} RTC_BUS_STATS_T;
+
+/*!
+ * \brief Refresh the shadow copy of the DS3231 registers.
+ *
+ * Burst reads registers 0x00 to 0x10 in a single I2C read. Call once at the
+ * start of a display pass so that every get_* function in that pass is 
+ * served from the same snapshot. The get_* functions will also refresh the 
+ * shadow themselves if it is older than #RTC_SHADOW_TTL_MS.
+ */
+void rtc_refresh(void);
+
+/*!
+ * \brief Read the I2C bus statistics.
+ *
+ * \param stats Pointer to the RTC_BUS_STATS_T struct which will contain the
+ *        statistics accumulated since they were last reset.
+ * \param reset True to reset the statistics once they have been read.
+ */
+void rtc_get_bus_stats(RTC_BUS_STATS_T *stats, bool reset);
+
+/*!
+ * \brief Estimate the time the bus was busy for some statistics.
+ *
+ * Each byte takes 9 clocks (8 data and ACK/NACK) and each transaction adds 
+ * a START and a STOP condition, about a clock each. Clock stretching and the
+ * time between transactions are not included.
+ *
+ * \param stats Statistics read with rtc_get_bus_stats.
+ * \param clock_hz The I2C clock rate e.g. #I2C_STANDARD_HZ or #I2C_FAST_HZ.
+ *
+ * \result Bus time in microseconds.
+ */
+uint32_t rtc_bus_time_us(const RTC_BUS_STATS_T *stats, uint32_t clock_hz);
+
+/*!
+ * \brief Decode the date and time registers.
+ *
+ * Converts the BCD of Registers 0x00 to 0x06, masking each with the bits 
+ * that register uses for its value, in two 32-bit operations rather than 
+ * byte by byte.
+ *
+ * \param regs The 7 register values, 0x00 to 0x06.
+ * \param date_time Pointer to the TM_T struct which will contain the date
+ *        and time.
+ */
+void rtc_decode_date_time(const uint8_t *regs, TM_T *date_time);
+
+/*!
+ * \brief Encode the date and time registers.
+ *
+ * The reverse of rtc_decode_date_time.
+ *
+ * \param date_time Pointer to the TM_T struct containing the date and time.
+ * \param regs The 7 register values, 0x00 to 0x06.
+ */
+void rtc_encode_date_time(const TM_T *date_time, uint8_t *regs);
+
 /*!
  * \brief Read and return the date and time from the RTC.
  *
@@ -99,8 +269,22 @@ TM_T *get_date_time(TM_T *date_time);
  * \brief Read and return the temperature.
  *
  * The DS3231 represents the temperature with 10-bits across two registers
- * (11h-12h) to a resolution of 0.25h. However, only half-degree resolution is
- * represented in this API.
+ * (11h-12h) to a resolution of 0.25h. Both the half-degree and quarter
+ * degree resolution are represented in this API.
+ *
+ * The registers are only read if #RTC_TEMP_PERIOD_MS has passed since the
+ * cached temperature was converted, or a conversion is in progress.
+ * Otherwise the cached temperature is returned. While a conversion is
+ * running, started by rtc_convert_temp or the DS3231's own 64 second cycle,
+ * the registers are read on each call until it completes.
+ *
+ * Once an automatic conversion has been seen to complete, the registers are
+ * read on the first call after each of the following ones, so the cached
+ * temperature is at most a call interval old. An automatic conversion is
+ * only seen if a call falls in the 200ms or so that BSY is set. Until then
+ * the cached temperature was converted up to a period before it was read,
+ * so it can be up to 2 * #RTC_TEMP_PERIOD_MS (128 seconds) old. Call
+ * rtc_convert_temp to have a fresh one.
  *
  * \param temp Pointer to TEMP_T struct which will contain the temperature when
  *        it has been read.
@@ -111,6 +295,18 @@ TM_T *get_date_time(TM_T *date_time);
  */
 TEMP_T *get_temp(TEMP_T *temp);
 
+/*!
+ * \brief Start a temperature conversion now.
+ *
+ * Sets the CONV bit of the Control Register, unless a conversion is already
+ * in progress (BSY bit of the Status Register). Until the conversion
+ * completes, about 200ms later, get_temp returns the previous temperature
+ * and reads the registers again on each call to pick up the new one.
+ *
+ * \result Returns 1 if a conversion was started or 0 if busy.
+ */
+int rtc_convert_temp(void);
+
 /*! 
  * \brief Set the date and time.
  *
@@ -123,7 +319,8 @@ void set_date_time(TM_T *date_time);
  * \brief Get the alarm time.
  *
  * In this implementation, the Alarm 1/2 Interrupt Enable bits of the Control
- * Register are used to indicate if the alarm is active or not. 
+ * Register are used to indicate if the alarm is active or not. The mode is
+ * decoded from the mask and DY/DT bits, tm_sec is 0 for Alarm 2.
  *
  * \param alarm_id Which alarm to read the set time for - #ALARM1 or #ALARM2.
  * \param alarm_time Pointer to the ALARM_T struct which will contain the time
@@ -141,6 +338,10 @@ uint8_t get_alarm_time(uint8_t alarm_id, ALARM_T *alarm_time);
  * Automatically clears the appropriate alarm status bit in the status register
  * so that it will be set when the alarm time is reached. 
  *
+ * The mode selects which fields the DS3231 compares with the time, fields
+ * it doesn't use are ignored. e.g. #ALARM_MATCH_HOURS triggers every day at
+ * tm_hour:tm_min:tm_sec and #ALARM_MATCH_DAY only on the day of week tm_day.
+ *
  * \param alarm_id Which alarm is to be set - #ALARM1 or #ALARM2.
  * \param alarm_time Uses the ALARM_T struct.
  *
@@ -153,7 +354,7 @@ int set_alarm_time(uint8_t alarm_id, const ALARM_T *alarm_time);
  *
  * Enables or disables the alarm but setting the appropriate bit in the control
  * register. This will also clear the bit on the status register if the alarm
- * is Enabled.
+ * is Enabled. The alarm mode is left as set by set_alarm_time.
  *
  * \param alarm_id Which alarm is to be set - #ALARM1 or #ALARM2.
  * \param enable True to enable (set) the alarm, False to disable (unset).
@@ -176,6 +377,47 @@ int set_alarm(uint8_t alarm_id, bool enable);
  */
 void get_alarm_status(uint8_t *enabled, uint8_t *triggered);
 
+/*!
+ * \brief Enable or disable the 1Hz square wave on the INT/SQW pin.
+ *
+ * Clears the INTCN bit and the rate select bits (RS1, RS2) of the Control
+ * Register to output 1Hz. The falling edge of the square wave coincides with
+ * the seconds register incrementing. Disabling sets INTCN again, so the pin 
+ * is driven by the alarms.
+ *
+ * \param enable True to output the square wave, False for alarm interrupts.
+ *
+ * \result Returns 1 if successful or 0 otherwise.
+ */
+int set_square_wave(bool enable);
+
+/*!
+ * \brief Queue an operation to be performed asynchronously.
+ *
+ * The blocking functions perform up to five I2C transactions in a row (e.g.
+ * set_alarm). A queued operation is instead performed one register access
+ * per call of rtc_service, so the main loop can do other work, such as 
+ * drawing to the TFT, in between.
+ *
+ * \param op The operation to perform. It is copied into the queue.
+ * \param callback Function called when the operation completes, or NULL.
+ *
+ * \result Returns 1 if queued or 0 if the queue is full or the operation is
+ *         not valid.
+ */
+int rtc_submit(const RTC_OP_T *op, RTC_CALLBACK_T callback);
+
+/*!
+ * \brief Perform the next step of the queued operations.
+ *
+ * Performs at most one register access (one I2C write, or a register read)
+ * and makes the callback if that completes the operation. Call on every
+ * iteration of the main loop.
+ *
+ * \result True if there are still operations queued.
+ */
+bool rtc_service(void);
+
 /* \brief cancel_alarm
  *
  * Clears the specied alarm bit(s) in the control register.
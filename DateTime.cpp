@@ -1,4 +1,6 @@
 #include "DateTime.h"
+#include "Epoch.h"
+#include "SoftClock.h"
 #include "beep.h"
 
 /*
@@ -10,45 +12,22 @@ DisplayTime::DisplayTime(Adafruit_ILI9341_STM* screen, int x_pos, int y_pos)
   ox = x_pos;
   oy = y_pos;
 
-  comps[0] = &ht;
-  comps[1] = &hu;
-  comps[2] = &c1;
-  comps[3] = &mt;
-  comps[4] = &mu;
-  comps[5] = &c2;
-  comps[6] = &st;
-  comps[7] = &su;
-  
-  for (int idx=0; idx < DisplayTime::MAX_COMPS; idx++)
-  {
-    comps[idx]->setScreen(screen);
-  }
+  set_screen_all(screen, ht, hu, c1, mt, mu, c2, st, su);
 }
 
 void DisplayTime::Display(TM_T now)
 {
-    int x = ox;
-    int y = oy;
-
-    ht.setPosition(x, y);
+    Layout::place(ox, oy, ht, hu, c1, mt, mu, c2, st, su);
     ht.setValue(now.tm_hour / 10);
-    hu.setPosition(x+=DGT_W, y);
     hu.setValue(now.tm_hour % 10);
-    c1.setPosition(x+=DGT_W, y);
-    mt.setPosition(x+=CLN_W, y);
     mt.setValue(now.tm_min / 10);
-    mu.setPosition(x+=DGT_W, y);
     mu.setValue(now.tm_min % 10);
-    c2.setPosition(x+=DGT_W, y);
-    st.setPosition(x+=CLN_W, y);
     st.setValue(now.tm_sec / 10);
-    su.setPosition(x+=DGT_W, y);
     su.setValue(now.tm_sec % 10); 
 
-    for (int idx=0; idx < MAX_COMPS; idx++)
-    {
-      comps[idx]->Draw();
-    }
+    compositor.Begin();
+    invalidate_all(ht, hu, c1, mt, mu, c2, st, su);
+    compositor.Flush();
 }
 
 void DisplayTime::Update(TM_T now)
@@ -75,8 +54,10 @@ DisplayTimeWidget::DisplayTimeWidget(
 
 void DisplayTimeWidget::Display(TM_T now)
 {
-  tft->fillRect(ox+1, oy+1, 318, 118, ILI9341_BLACK);
+  compositor.Begin();
+  compositor.Fill(tft, ox+1, oy+1, 318, 118, ILI9341_BLACK);
   DisplayTime::Display(now);
+  compositor.Flush();
 }
 
 /*
@@ -92,17 +73,7 @@ DisplayDateFull::DisplayDateFull(
   ox = x_pos;
   oy = y_pos;
 
-  comps[0] = &dd;
-  comps[1] = &os;
-  comps[2] = &ms;
-  comps[3] = &yu;
-  comps[4] = &yl;
-  comps[5] = &wd;
-  
-  for (int idx=0; idx < DisplayDateFull::MAX_COMPS; idx++)
-  {
-    comps[idx]->setScreen(screen);
-  }
+  set_screen_all(screen, dd, os, ms, yu, yl, wd);
 }
 
 void DisplayDateFull::Display(TM_T now)
@@ -118,7 +89,7 @@ void DisplayDateFull::Display(TM_T now)
   ms.setPosition(ox+44, oy+70);
   ms.setMonth(now.tm_mon-1);
   yu.setPosition(ox+184, oy+70);
-  yu.setValue(20);
+  yu.setValue(20 + now.tm_century);
   yu.setFontSize(4);
   yl.setPosition(ox+212, oy+70);
   yl.setValue(now.tm_year);
@@ -126,16 +97,16 @@ void DisplayDateFull::Display(TM_T now)
   wd.setPosition(ox+50, oy+30);
   wd.setDay(now.tm_wday-1);
 
-  for (int idx=0; idx < DisplayDateFull::MAX_COMPS; idx++)
-    {
-      comps[idx]->Draw();
-    }
+  compositor.Begin();
+  invalidate_all(dd, os, ms, yu, yl, wd);
+  compositor.Flush();
 }
 
 void DisplayDateFull::Update(TM_T now){
   dd.Update(now.tm_mday);
   os.Update(now.tm_mday); 
   ms.Update(now.tm_mon-1);
+  yu.Update(20 + now.tm_century);
   yl.Update(now.tm_year);
   wd.Update(now.tm_wday-1);
 }
@@ -154,8 +125,10 @@ DisplayDateFullWidget::DisplayDateFullWidget(
 
 void DisplayDateFullWidget::Display(TM_T now)
 {
-  tft->fillRect(ox+1, oy+1, 318, 118, ILI9341_BLACK);
+  compositor.Begin();
+  compositor.Fill(tft, ox+1, oy+1, 318, 118, ILI9341_BLACK);
   DisplayDateFull::Display(now);
+  compositor.Flush();
 }
 
 /*
@@ -167,49 +140,31 @@ DisplayDate::DisplayDate(Adafruit_ILI9341_STM* screen, int x_pos, int y_pos)
   ox = x_pos;
   oy = y_pos;
 
-  comps[0] = &md;
-  comps[1] = &fs1;
-  comps[2] = &mn;
-  comps[3] = &fs2;
-  comps[4] = &yu;
-  comps[5] = &yl;
-  
-  for (int idx=0; idx < DisplayDate::MAX_COMPS; idx++)
-  {
-    comps[idx]->setScreen(screen);
-  }
+  set_screen_all(screen, md, fs1, mn, fs2, yu, yl);
 }
 
 void DisplayDate::Display(TM_T now)
 {
-  int x = ox;
-  int y = oy;
-  
-  md.setPosition(x, y);
+  Layout::place(ox, oy, md, fs1, mn, fs2, yu, yl);
   md.setValue(now.tm_mday);
   md.setFontSize(6);
-  fs1.setPosition(x+=(DGT6_W*2), y);
-  mn.setPosition(x+=FS6_W, y);
   mn.setValue(now.tm_mon);
   mn.setFontSize(6);
-  fs2.setPosition(x+=(DGT6_W*2), y);
-  yu.setPosition(x+=FS6_W, y);
-  yu.setValue(20);
+  yu.setValue(20 + now.tm_century);
   yu.setFontSize(6);
-  yl.setPosition(x+=(DGT6_W*2), y);
   yl.setValue(now.tm_year);
   yl.setFontSize(6);
 
-  for (int idx=0; idx < DisplayDate::MAX_COMPS; idx++)
-  {
-    comps[idx]->Draw();
-  }
+  compositor.Begin();
+  invalidate_all(md, fs1, mn, fs2, yu, yl);
+  compositor.Flush();
 }
 
 void DisplayDate::Update(TM_T now)
 {
     md.Update(now.tm_mday);
     mn.Update(now.tm_mon);
+    yu.Update(20 + now.tm_century);
     yl.Update(now.tm_year);
 }
 
@@ -217,63 +172,60 @@ void DisplayDate::Update(TM_T now)
  ***************************************************************************
  */
 
+// Lines up with the tm_wday value from the RTC. In flash, not per instance.
+Button DayOfWeek::* const DayOfWeek::days[7] = {
+  &DayOfWeek::mo,
+  &DayOfWeek::tu,
+  &DayOfWeek::we,
+  &DayOfWeek::th,
+  &DayOfWeek::fr,
+  &DayOfWeek::sa,
+  &DayOfWeek::su
+};
+
 DayOfWeek::DayOfWeek(Adafruit_ILI9341_STM* screen, int x_pos, int y_pos)
 : ox(x_pos), oy(y_pos), today(0)
 {
-  bttns[0] = &mo; // Lines up with the tm_wday value from the RTC
-  bttns[1] = &tu;
-  bttns[2] = &we;
-  bttns[3] = &th;
-  bttns[4] = &fr;
-  bttns[5] = &sa;
-  bttns[6] = &su;
-
-  for (int idx=0; idx < DayOfWeek::MAX_BTTNS; idx++)
+  set_screen_all(screen, mo, tu, we, th, fr, sa, su);
+  for (int idx=0; idx < 7; idx++)
   {
-    bttns[idx]->setScreen(screen);
-    bttns[idx]->setWidthHeight(20, 20);
-    bttns[idx]->setFontSize(2);
+    (this->*days[idx]).setWidthHeight(20, 20);
+    (this->*days[idx]).setFontSize(2);
   }
 }
 
 void DayOfWeek::Display(TM_T now)
 {
-  int x = ox;
-  int y = oy;
-
-  mo.setPosition(x, y);
+  Layout::place(ox, oy, mo, tu, we, th, fr, sa, su);
   mo.setText("Mo");
-  tu.setPosition(x+=40, y);
   tu.setText("Tu");
-  we.setPosition(x+=40, y);
   we.setText("We");
-  th.setPosition(x+=40, y);
   th.setText("Th");
-  fr.setPosition(x+=40, y);
   fr.setText("Fr");
-  sa.setPosition(x+=40, y);
   sa.setText("Sa");
-  su.setPosition(x+=40, y);
   su.setText("Su");
 
-  for (int idx=0; idx < DayOfWeek::MAX_BTTNS; idx++)
+  // Batched, so the highlighted day is only drawn once.
+  compositor.Begin();
+  for (int idx=0; idx < 7; idx++)
   {
-    bttns[idx]->setColor(ILI9341_BLACK, ILI9341_WHITE); 
-    bttns[idx]->Draw();  
+    (this->*days[idx]).setColor(ILI9341_BLACK, ILI9341_WHITE); 
   }
+  invalidate_all(mo, tu, we, th, fr, sa, su);
 
   // Highlight the actual day
   today = now.tm_wday;
-  bttns[today-1]->Release();
+  (this->*days[today-1]).Release();
+  compositor.Flush();
 }
 
 void DayOfWeek::Update(TM_T now)
 {
   if (today != now.tm_wday)
   {
-    bttns[today-1]->Release();  // Un-highlight the current day.
+    (this->*days[today-1]).Release();  // Un-highlight the current day.
     today = now.tm_wday;
-    bttns[today-1]->Release();  // Now highlight the new day.
+    (this->*days[today-1]).Release();  // Now highlight the new day.
   }
 }
 
@@ -293,9 +245,11 @@ DisplayDateWidget::DisplayDateWidget(
 
 void DisplayDateWidget::Display(TM_T now)
 {
-  tft->fillRect(ox+1, oy+1, 318, 118, ILI9341_BLACK);
+  compositor.Begin();
+  compositor.Fill(tft, ox+1, oy+1, 318, 118, ILI9341_BLACK);
   DisplayDate::Display(now);
   DayOfWeek::Display(now);
+  compositor.Flush();
 }
 
 void DisplayDateWidget::Update(TM_T now)
@@ -309,7 +263,8 @@ void DisplayDateWidget::Update(TM_T now)
  */
 
 DisplayTemp::DisplayTemp(Adafruit_ILI9341_STM* screen, int x_pos, int y_pos)
-: tft(screen), ox(x_pos), oy(y_pos)
+: tft(screen), ox(x_pos), oy(y_pos),
+  dgr(screen, 0, 0, "O", 2), cel(screen, 0, 0, "C", 4)
 {
   tmp.setScreen(screen);
   fs.setScreen(screen);
@@ -324,18 +279,22 @@ void DisplayTemp::Display(TEMP_T temperature)
   tmp.setPosition(x, oy);
   tmp.setFontSize(6);
   tmp.setValue(temperature.temp_degrees);
-  tmp.Draw();
   fs.setPosition(x+=(DGT6_W*2), oy);
-  fs.Draw();
   hlfdgr.setPosition(x+=FS6_W, oy);
   hlfdgr.setFontSize(6);
   hlfdgr.setValue(temperature.temp_half);
-  hlfdgr.Draw();
 
   // Text for degrees C
-  tft->setTextColor(ILI9341_WHITE, ILI9341_BLACK);
-  tft->drawString("O", x+=DGT6_W+11, oy, 2);
-  tft->drawString("C", x+=8, oy, 4);  
+  dgr.setPosition(x+=DGT6_W+11, oy);
+  cel.setPosition(x+=8, oy);
+
+  compositor.Begin();
+  tmp.Invalidate();
+  fs.Invalidate();
+  hlfdgr.Invalidate();
+  dgr.Invalidate();
+  cel.Invalidate();
+  compositor.Flush();
 }
 
 void DisplayTemp::Update(TEMP_T temperature)
@@ -358,85 +317,79 @@ DisplayTempWidget::DisplayTempWidget(
 
 void DisplayTempWidget::Display(TEMP_T temperature)
 {
-  tft->fillRect(ox+1, oy+1, 318, 118, ILI9341_BLACK);
+  compositor.Begin();
+  compositor.Fill(tft, ox+1, oy+1, 318, 118, ILI9341_BLACK);
   DisplayTemp::Display(temperature);
+  compositor.Flush();
 }
 
 /*
  ***************************************************************************
  */
 
-SetTime::SetTime(Adafruit_ILI9341_STM* screen, XPT2046* touch_screen)
-: dt(screen, 44, 96), tft(screen), touch(touch_screen)
+// Sets the text and size of each button, then draws it.
+static void draw_buttons(char*, int, int) { }
+
+template <class... Rest>
+static void draw_buttons(
+  char* text,
+  int width,
+  int height,
+  Button& first,
+  Rest&... rest
+  )
+{
+  first.setText(text);
+  first.setWidthHeight(width, height);
+  first.Draw();
+  draw_buttons(text, width, height, rest...);
+}
+
+// In the order the buttons were tried before, the ids are the indexes.
+const Control<SetTime> SetTime::controls[14] = {
+  { &SetTime::htu, &SetTime::HourTensUp },
+  { &SetTime::huu, &SetTime::HourUnitsUp },
+  { &SetTime::mtu, &SetTime::MinTensUp },
+  { &SetTime::muu, &SetTime::MinUnitsUp },
+  { &SetTime::stu, &SetTime::SecTensUp },
+  { &SetTime::suu, &SetTime::SecUnitsUp },
+  { &SetTime::htd, &SetTime::HourTensDown },
+  { &SetTime::hud, &SetTime::HourUnitsDown },
+  { &SetTime::mtd, &SetTime::MinTensDown },
+  { &SetTime::mud, &SetTime::MinUnitsDown },
+  { &SetTime::std, &SetTime::SecTensDown },
+  { &SetTime::sud, &SetTime::SecUnitsDown },
+  { &SetTime::bok, &SetTime::Ok },
+  { &SetTime::bcancel, &SetTime::Cancel }
+};
+
+SetTime::SetTime(Adafruit_ILI9341_STM* screen)
+: dt(screen, 44, 96), touching(NULL), tft(screen)
 {
   ox = 44;   // These are the positions of the Time display so 
   oy = 60;   // buttons & text must be laid out in relation.
   Serial.println("ST::ST:start"); Serial.flush();
   
-  bttns[0] = &htu; // plus buttons
-  bttns[1] = &huu;  
-  bttns[2] = &mtu;  
-  bttns[3] = &muu;  
-  bttns[4] = &stu; 
-  bttns[5] = &suu;  
-  
-  bttns[6] = &htd;  
-  bttns[7] = &hud;   
-  bttns[8] = &mtd; 
-  bttns[9] = &mud;  
-  bttns[10] = &std;  
-  bttns[11] = &sud; 
-
-  bttns[12] = &bok;
-  bttns[13] = &bcancel;
-
-  for (int idx=0; idx < MAX_BTTNS; idx++)
-  {
-    bttns[idx]->setScreen(screen);
-  }
+  set_screen_all(screen, htu, huu, mtu, muu, stu, suu,
+                 htd, hud, mtd, mud, std, sud, bok, bcancel);
   Serial.println("ST::ST:end"); Serial.flush();
 }
 
 void SetTime::Display(TM_T now)
 {
-  int x = ox;
-  int y = oy;
+  setting = now;
+  touching = NULL;
   Serial.println("ST::Display:Start"); Serial.flush();
   
   dt.Display(now);
   
   // 'Plus' buttons.
-  htu.setPosition(x, y);
-  huu.setPosition(x+=DGT_W, y);
-  mtu.setPosition(x+=DGT_W+CLN_W, y);
-  muu.setPosition(x+=DGT_W, y);
-  stu.setPosition(x+=DGT_W+CLN_W, y);
-  suu.setPosition(x+=DGT_W, y);
-
-  for (int idx=0; idx < 6; idx++)
-  {
-    bttns[idx]->setText("+");
-    bttns[idx]->setWidthHeight(34, 34);
-    bttns[idx]->Draw();
-  }
+  Layout::place(ox, oy, htu, huu, mtu, muu, stu, suu);
+  draw_buttons("+", 34, 34, htu, huu, mtu, muu, stu, suu);
 
-  x = ox;
-  y = oy + BTN_H + DGT_H + 2;
-  
   // 'Minus' buttons.
-  htd.setPosition(x, y);
-  hud.setPosition(x+=DGT_W, y);
-  mtd.setPosition(x+=DGT_W+CLN_W, y);
-  mud.setPosition(x+=DGT_W, y);
-  std.setPosition(x+=DGT_W+CLN_W, y);
-  sud.setPosition(x+=DGT_W, y);
-
-  for (int idx=6; idx < 12; idx++)
-  {
-    bttns[idx]->setText("-");
-    bttns[idx]->setWidthHeight(34, 34);
-    bttns[idx]->Draw();
-  }
+  Layout::place(ox, oy + BTN_H + DGT_H + 2, htd, hud, mtd, mud, std, sud);
+  draw_buttons("-", 34, 34, htd, hud, mtd, mud, std, sud);
 
   // Other buttons
   bok.setPosition(ox+4, oy+136);
@@ -451,6 +404,8 @@ void SetTime::Display(TM_T now)
 
   tft->setTextColor(ILI9341_WHITE, ILI9341_BLACK);
   tft->drawCentreString("SET TIME", 160, 10, 4);
+
+  hit_map.Build(this, controls, sizeof(controls) / sizeof(controls[0]));
   Serial.println("ST::Display:End"); Serial.flush();
 }
 
@@ -486,179 +441,168 @@ static void dec_units(uint8_t &val, uint8_t max_val)
   val = (tens * 10) + units;
 }
 
-// Doesn't release control until the 'OK' or 'Cancel' Button is pressed.
-void SetTime::Update(TM_T now)
+// Hours tens and units, keeping the hour below 24.
+static void limit_hour(uint8_t &hour)
 {
-  Button* touching = NULL;
-  while(true)
+  if ((hour/10) == 2  && (hour % 10) > 3)
   {
-    if (!touching && touch->isTouching())
-    {
-      uint16_t x, y, tens, units;
-      touch->getPosition(x, y);
-
-      // Which Button widget is being touched, if any.
-      for(int idx=0; idx < MAX_BTTNS; idx++)
-      {
-        if ( (touching = (Button *)bttns[idx]->Press(x, y)) )
-        {
-          beepDelay(50); // Beep to show button was pressed.
-          break;
-        }
-      }
-
-      if (touching == &htu)
-      {
-        inc_tens(now.tm_hour, 3); 
-        if ((now.tm_hour/10) == 2  && (now.tm_hour % 10) > 3)
-        {
-          now.tm_hour = 23;
-        }
-      }
-      else if (touching == &huu)
-      {
-        if ((now.tm_hour/10) == 2) {
-          inc_units(now.tm_hour, 4);
-        } 
-        else
-        {
-          inc_units(now.tm_hour, 10);
-        }
-      }
-      else if (touching == &mtu)
-      {
-        inc_tens(now.tm_min, 6);
-      }
-      else if (touching == &muu)
-      {
-        inc_units(now.tm_min, 10);
-      }
-      else if (touching == &stu)
-      {
-        inc_tens(now.tm_sec, 6);
-      }
-      else if (touching == &suu)
-      {
-        inc_units(now.tm_sec, 10);
-      }
-
-      else if (touching == &htd)
-      {
-        dec_tens(now.tm_hour, 3);
-        if ((now.tm_hour/10) == 2  && (now.tm_hour % 10) > 3)
-        {
-          now.tm_hour = 23;
-        }
-      }
-      else if (touching == &hud)
-      {
-        if ((now.tm_hour/10) == 2) 
-        {
-          dec_units(now.tm_hour, 4);
-        }
-        else
-        { 
-          dec_units(now.tm_hour, 10);
-        }
-      }
-      else if (touching == &mtd)
-      {
-        dec_tens(now.tm_min, 6);
-      }
-      else if (touching == &mud)
-      {
-        dec_units(now.tm_min, 10);
-      }
-      else if (touching == &std)
-      {
-        dec_tens(now.tm_sec, 6);
-      }
-      else if (touching == &sud)
-      {
-        dec_units(now.tm_sec, 10);
-      }   
-      else if (touching == &bok)
-      {
-        set_date_time(&now);
-        bok.Release();
-        return;
-      }
-      else if (touching == &bcancel)
-      {
-        // Exit without changing time.
-        bcancel.Release();
-        return;
-      }    
-    }
-    else if (touching && !touch->isTouching())
-    {
-      dt.Update(now);
-      touching->Release();
-      touching = NULL;
-    }
-    delay(100);
+    hour = 23;
+  }
+}
+
+bool SetTime::HourTensUp(uint8_t)
+{
+  inc_tens(setting.tm_hour, 3);
+  limit_hour(setting.tm_hour);
+  return true;
+}
+
+bool SetTime::HourUnitsUp(uint8_t)
+{
+  inc_units(setting.tm_hour, (setting.tm_hour/10) == 2 ? 4 : 10);
+  return true;
+}
+
+bool SetTime::MinTensUp(uint8_t)
+{
+  inc_tens(setting.tm_min, 6);
+  return true;
+}
+
+bool SetTime::MinUnitsUp(uint8_t)
+{
+  inc_units(setting.tm_min, 10);
+  return true;
+}
+
+bool SetTime::SecTensUp(uint8_t)
+{
+  inc_tens(setting.tm_sec, 6);
+  return true;
+}
+
+bool SetTime::SecUnitsUp(uint8_t)
+{
+  inc_units(setting.tm_sec, 10);
+  return true;
+}
+
+bool SetTime::HourTensDown(uint8_t)
+{
+  dec_tens(setting.tm_hour, 3);
+  limit_hour(setting.tm_hour);
+  return true;
+}
+
+bool SetTime::HourUnitsDown(uint8_t)
+{
+  dec_units(setting.tm_hour, (setting.tm_hour/10) == 2 ? 4 : 10);
+  return true;
+}
+
+bool SetTime::MinTensDown(uint8_t)
+{
+  dec_tens(setting.tm_min, 6);
+  return true;
+}
+
+bool SetTime::MinUnitsDown(uint8_t)
+{
+  dec_units(setting.tm_min, 10);
+  return true;
+}
+
+bool SetTime::SecTensDown(uint8_t)
+{
+  dec_tens(setting.tm_sec, 6);
+  return true;
+}
+
+bool SetTime::SecUnitsDown(uint8_t)
+{
+  dec_units(setting.tm_sec, 10);
+  return true;
+}
+
+bool SetTime::Ok(uint8_t)
+{
+  softclock.set(&setting);
+  bok.Release();
+  touching = NULL;
+  return false;
+}
+
+bool SetTime::Cancel(uint8_t)
+{
+  // Exit without changing time.
+  bcancel.Release();
+  touching = NULL;
+  return false;
+}
+
+// Changes the time being set, until the 'OK' or 'Cancel' Button is pressed.
+bool SetTime::Handle(const UI_EVENT_T &event)
+{
+  if (!touching && event.type == UI_TOUCH)
+  {
+    // Which Button widget is being touched, if any.
+    uint8_t id = hit_map.Press(event.x, event.y);
+
+    if (id == HIT_NONE)
+      return true;
+
+    beepPlay(beep_click); // Beep to show button was pressed.
+    touching = &(this->*controls[id].button);
+    return (this->*controls[id].handler)(id);
   }
+  else if (touching && event.type == UI_TICK)
+  {
+    dt.Update(setting);
+    touching->Release();
+    touching = NULL;
+  }
+  return true;
 }
 
 /*
  ***************************************************************************
  */
 
-SetDate::SetDate(Adafruit_ILI9341_STM* screen, XPT2046* touch_screen)
-: dd(screen, 37, 96), tft(screen), touch(touch_screen)
+// In the order the buttons were tried before, the ids are the indexes.
+const Control<SetDate> SetDate::controls[8] = {
+  { &SetDate::mdu, &SetDate::DayUp },
+  { &SetDate::mu, &SetDate::MonthUp },
+  { &SetDate::yu, &SetDate::YearUp },
+  { &SetDate::mdd, &SetDate::DayDown },
+  { &SetDate::md, &SetDate::MonthDown },
+  { &SetDate::yd, &SetDate::YearDown },
+  { &SetDate::bok, &SetDate::Ok },
+  { &SetDate::bcancel, &SetDate::Cancel }
+};
+
+SetDate::SetDate(Adafruit_ILI9341_STM* screen)
+: dd(screen, 37, 96), touching(NULL), tft(screen)
 {
   ox = 37;
   oy = 55;
 
-  bttns[0] = &mdu;
-  bttns[1] = &mu;
-  bttns[2] = &yu;
-  bttns[3] = &mdd;
-  bttns[4] = &md;
-  bttns[5] = &yd;
-
-  bttns[6] = &bok;
-  bttns[7] = &bcancel;
-
-  for (int idx=0; idx < MAX_BTTNS; idx++)
-  {
-    bttns[idx]->setScreen(screen);
-  }
+  set_screen_all(screen, mdu, mu, yu, mdd, md, yd, bok, bcancel);
 }
 
 void SetDate::Display(TM_T now)
 {
-  int x = ox;
-  int y = oy;
-  
+  setting = now;
+  touching = NULL;
+  month_days = days_in_month(now.tm_mon, now.tm_year, now.tm_century);
   dd.Display(now);
   
   // 'Plus' buttons.
-  mdu.setPosition(x, y);
-  mu.setPosition(x+=(DGT6_W*2)+FS6_W, y);
-  yu.setPosition(x+=(DGT6_W*4)+FS6_W, y);
-  
-  for (int idx=0; idx < 3; idx++)
-  {
-    bttns[idx]->setText("+");
-    bttns[idx]->setWidthHeight(DGT6_W*2, 35);
-    bttns[idx]->Draw();
-  }
+  Layout::place(ox, oy, mdu, mu, yu);
+  draw_buttons("+", DGT6_W*2, 35, mdu, mu, yu);
 
-  x = ox;
-  y = 150;
-  
   // 'Minus' buttons.
-  mdd.setPosition(x, y);
-  md.setPosition(x+=(DGT6_W*2)+FS6_W, y);
-  yd.setPosition(x+=(DGT6_W*4)+FS6_W, y);
-
-  for (int idx=3; idx < 6; idx++)
-  {
-    bttns[idx]->setText("-");
-    bttns[idx]->setWidthHeight(DGT6_W*2, 35);
-    bttns[idx]->Draw();
-  }
+  Layout::place(ox, 150, mdd, md, yd);
+  draw_buttons("-", DGT6_W*2, 35, mdd, md, yd);
 
   // Other buttons
   bok.setPosition(40, 196);
@@ -673,156 +617,141 @@ void SetDate::Display(TM_T now)
 
   tft->setTextColor(ILI9341_WHITE, ILI9341_BLACK);
   tft->drawCentreString("SET DATE", 160, 10, 4);  
+
+  hit_map.Build(this, controls, sizeof(controls) / sizeof(controls[0]));
 }
 
-void SetDate::Update(TM_T now)
+bool SetDate::DayUp(uint8_t)
 {
-  Button* touching = NULL;
+  setting.tm_mday = (setting.tm_mday == month_days) ? 1 : setting.tm_mday + 1;
+  return true;
+}
 
-  // Days in a given calender month;
-  int per_month[12] = { 31, 28, 31, 30,  31, 30, 31, 31,  30, 31, 30, 31 };
-  
-  if ((now.tm_year % 4) == 0)
-  { 
-    per_month[1] = 29;
-  }
+bool SetDate::MonthUp(uint8_t)
+{
+  setting.tm_mon = (setting.tm_mon == 12) ? 1 : setting.tm_mon + 1;
+  return true;
+}
+
+bool SetDate::YearUp(uint8_t)
+{
+  setting.tm_year = (setting.tm_year + 1) % 100;
+  return true;
+}
 
-  while(true)
+bool SetDate::DayDown(uint8_t)
+{
+  setting.tm_mday = (setting.tm_mday == 1) ? month_days : setting.tm_mday - 1;
+  return true;
+}
+
+bool SetDate::MonthDown(uint8_t)
+{
+  setting.tm_mon = (setting.tm_mon == 1) ? 12 : setting.tm_mon -1;
+  return true;
+}
+
+bool SetDate::YearDown(uint8_t)
+{
+  setting.tm_year = (setting.tm_year == 0) ? 99 : setting.tm_year - 1;
+  return true;
+}
+
+bool SetDate::Ok(uint8_t)
+{
+  TM_T delta;
+  softclock.get(&delta);
+  setting.tm_hour = delta.tm_hour;
+  setting.tm_min = delta.tm_min;
+  setting.tm_sec = delta.tm_sec;
+  softclock.set(&setting);
+  bok.Release();
+  touching = NULL;
+  return false;
+}
+
+bool SetDate::Cancel(uint8_t)
+{
+  // Exit without changing time.
+  bcancel.Release();
+  touching = NULL;
+  return false;
+}
+
+// Changes the date being set, until the 'OK' or 'Cancel' Button is pressed.
+bool SetDate::Handle(const UI_EVENT_T &event)
+{
+  TM_T &now = setting;
+
+  if (!touching && event.type == UI_TOUCH)
   {
-    if (!touching && touch->isTouching())
-    {
-      uint16_t x, y, tens, units;
-      touch->getPosition(x, y);
-
-      // Which Button widget is being touched, if any.
-      for(int idx=0; idx < MAX_BTTNS; idx++)
-      {
-        if ( (touching = (Button *)bttns[idx]->Press(x, y)) )
-        {
-          beepDelay(50);  // Beep to show a button was pressed.
-          break;
-        }
-      }  
-
-      if (touching == &mdu)
-      {
-        now.tm_mday = (now.tm_mday == per_month[now.tm_mon-1]) ? 1 : now.tm_mday + 1;
-      }
-      else if (touching == &mu)
-      {
-        now.tm_mon = (now.tm_mon == 12) ? 1 : now.tm_mon + 1;
-      }
-      else if (touching == &yu)
-      {
-        now.tm_year = (now.tm_year + 1) % 100;
-      }
-      
-      else if (touching == &mdd)
-      {
-        now.tm_mday = (now.tm_mday == 1) ? per_month[now.tm_mon-1] : now.tm_mday - 1;
-      }
-      else if (touching == &md)
-      {
-        now.tm_mon = (now.tm_mon == 1) ? 12 : now.tm_mon -1;
-       
-      }
-      else if (touching == &yd)
-      {
-        now.tm_year = (now.tm_year == 0) ? 99 : now.tm_year - 1;
-      }
-      else if (touching == &bok)
-      {
-        TM_T delta;
-        get_date_time(&delta);
-        now.tm_hour = delta.tm_hour;
-        now.tm_min = delta.tm_min;
-        now.tm_sec = delta.tm_sec;
-        set_date_time(&now);
-        bok.Release();
-        return;
-      }
-      else if (touching == &bcancel)
-      {
-        // Exit without changing time.
-        bcancel.Release();
-        return;
-      }    
-    }
-    else if (touching && !touch->isTouching())
+    // Which Button widget is being touched, if any.
+    uint8_t id = hit_map.Press(event.x, event.y);
+
+    if (id == HIT_NONE)
+      return true;
+
+    beepPlay(beep_click);  // Beep to show a button was pressed.
+    touching = &(this->*controls[id].button);
+    return (this->*controls[id].handler)(id);
+  }
+  else if (touching && event.type == UI_TICK)
+  {
+    // Adjust days of month if month (or February in a leap year) has 
+    // lower days per month.
+    month_days = days_in_month(now.tm_mon, now.tm_year, now.tm_century);
+    if (now.tm_mday > month_days)
     {
-      // Adjust February days if year is now a leap year.
-      if ((now.tm_year % 4) == 0)
-      { 
-        per_month[1] = 29;
-      }
-      else
-      {
-        per_month[1] = 28;
-      }
-      
-      // Adjust days of month if month has lower days per month.
-      if (now.tm_mday > per_month[now.tm_mon-1])
-      {
-        now.tm_mday = per_month[now.tm_mon-1];
-      } 
-
-      dd.Update(now);
-      touching->Release();
-      touching = NULL;
-    }
-    delay(50);
+      now.tm_mday = month_days;
+    } 
+
+    dd.Update(now);
+    touching->Release();
+    touching = NULL;
   }
+  return true;
 }
 
 /*
  ***************************************************************************
  */
  
-SetDayOfWeek::SetDayOfWeek(Adafruit_ILI9341_STM* screen, XPT2046* touch_screen) 
- : ox(15), oy(60), today (0), tft(screen), touch(touch_screen)
-{
-  bttns[0] = &mo; // Lines up with the tm_wday value from the RTC
-  bttns[1] = &tu;
-  bttns[2] = &we;
-  bttns[3] = &th;
-  bttns[4] = &fr;
-  bttns[5] = &sa;
-  bttns[6] = &su;
-  bttns[7] = &bok;
-  bttns[8] = &bcancel;
-
-  for (int idx=0; idx < MAX_BTTNS; idx++)
+// The days line up with the tm_wday value from the RTC, less one.
+const Control<SetDayOfWeek> SetDayOfWeek::controls[9] = {
+  { &SetDayOfWeek::mo, &SetDayOfWeek::SelectDay },
+  { &SetDayOfWeek::tu, &SetDayOfWeek::SelectDay },
+  { &SetDayOfWeek::we, &SetDayOfWeek::SelectDay },
+  { &SetDayOfWeek::th, &SetDayOfWeek::SelectDay },
+  { &SetDayOfWeek::fr, &SetDayOfWeek::SelectDay },
+  { &SetDayOfWeek::sa, &SetDayOfWeek::SelectDay },
+  { &SetDayOfWeek::su, &SetDayOfWeek::SelectDay },
+  { &SetDayOfWeek::bok, &SetDayOfWeek::Ok },
+  { &SetDayOfWeek::bcancel, &SetDayOfWeek::Cancel }
+};
+
+SetDayOfWeek::SetDayOfWeek(Adafruit_ILI9341_STM* screen) 
+ : ox(15), oy(60), today (0), touching(NULL), tft(screen)
+{
+  set_screen_all(screen, mo, tu, we, th, fr, sa, su, bok, bcancel);
+  for (int idx=0; idx < 7; idx++) // Only day of week buttons.
   {
-    bttns[idx]->setScreen(screen);
-    
-    if (idx <= 6) // Only day of week buttons.
-    {
-      bttns[idx]->setWidthHeight(50, 50);
-      bttns[idx]->setColor(ILI9341_BLACK, ILI9341_WHITE);
-      // bttns[idx]->setFontSize(2);
-    }
+    (this->*controls[idx].button).setWidthHeight(50, 50);
+    (this->*controls[idx].button).setColor(ILI9341_BLACK, ILI9341_WHITE);
+    // (this->*controls[idx].button).setFontSize(2);
   }
 }
 
 void SetDayOfWeek::Display(TM_T now)
 {
-  int x = ox;
-  int y = oy;
-
-  mo.setPosition(x, y);
+  touching = NULL;
+  Layout::place(ox, oy, mo, tu, we, th, fr);
   mo.setText("Mo");
-  tu.setPosition(x+=60, y);
   tu.setText("Tu");
-  we.setPosition(x+=60, y);
   we.setText("We");
-  th.setPosition(x+=60, y);
   th.setText("Th");
-  fr.setPosition(x+=60, y);
   fr.setText("Fr");
-  x = ox + 60;
-  sa.setPosition(x, y+=60);
+  Row<120, 60>::place(ox + 60, oy + 60, sa, su);
   sa.setText("Sa");
-  su.setPosition(x+=120, y);
   su.setText("Su");
 
   // Other buttons
@@ -834,191 +763,203 @@ void SetDayOfWeek::Display(TM_T now)
   bcancel.setWidthHeight(100, 34);
   bcancel.setText("Cancel");
 
-  for (int idx=0; idx < MAX_BTTNS; idx++)
-  {
-    bttns[idx]->Draw();  
-  }
+  draw_all(mo, tu, we, th, fr, sa, su, bok, bcancel);
 
   // Highlight the actual day
   today = now.tm_wday;
-  bttns[today-1]->Release();  
+  (this->*controls[today-1].button).Release();  
   
   tft->setTextColor(ILI9341_WHITE, ILI9341_BLACK);
   tft->drawCentreString("SET DAY OF WEEK", 160, 10, 4);  
+
+  hit_map.Build(this, controls, sizeof(controls) / sizeof(controls[0]));
 }
 
-void SetDayOfWeek::Update(TM_T now) 
+bool SetDayOfWeek::SelectDay(uint8_t id)
 {
-  Button* touching = NULL;
+  (this->*controls[today-1].button).Release();  // Un-highlight the current day.
+  today = id + 1;
+  return true;
+}
 
-  while(true)
+bool SetDayOfWeek::Ok(uint8_t)
+{
+  TM_T now;
+  softclock.get(&now);
+  now.tm_wday = today;
+  softclock.set(&now);
+  bok.Release();
+  touching = NULL;
+  return false;
+}
+
+bool SetDayOfWeek::Cancel(uint8_t)
+{
+  // Exit without changing day of week.
+  bcancel.Release();
+  touching = NULL;
+  return false;
+}
+
+// Changes the day being set, until the 'OK' or 'Cancel' Button is pressed.
+bool SetDayOfWeek::Handle(const UI_EVENT_T &event) 
+{
+  if (!touching && event.type == UI_TOUCH)
   {
-    // Set when a button is pressed.
-    int bttn_idx = 0xFF;
-    if (!touching && touch->isTouching())
-    {
-      uint16_t x, y, tens, units;
-      touch->getPosition(x, y);
-
-      // Which Button widget is being touched, if any.
-      for(int idx=0; idx < MAX_BTTNS; idx++)
-      {
-        if ( (touching = (Button *)bttns[idx]->Press(x, y)) )
-        {
-          bttn_idx = idx;
-          beepDelay(50);  // Beep to show a button was pressed.
-          break;
-        }
-      }  
-
-      // If a button was pressed.
-      if (bttn_idx != 0xFF) 
-      {
-        // If it was a 'day of week' button - 0 to 6.
-        if (bttn_idx <= 6) 
-        {
-          bttns[today-1]->Release();  // Un-highlight the current day.
-          today = bttn_idx + 1;
-          //bttns[bttn_idx]->Release();  // Now highlight the new day.  
-        }
-        else if (touching == &bok)
-        {
-          TM_T delta;
-          get_date_time(&delta);
-          now = delta;
-          now.tm_wday = today;
-          set_date_time(&now);
-          bok.Release();
-          return;
-        }
-        else if (touching == &bcancel)
-        {
-          // Exit without changing day of week.
-          bcancel.Release();
-          return;
-        }         
-      }
-    }
-    else if (touching && !touch->isTouching())
-    {
-      touching = NULL;
-    }
-    delay(50);
-  }  
+    // Which Button widget is being touched, if any.
+    uint8_t id = hit_map.Press(event.x, event.y);
+
+    if (id == HIT_NONE)
+      return true;
+
+    beepPlay(beep_click);  // Beep to show a button was pressed.
+    touching = &(this->*controls[id].button);
+    return (this->*controls[id].handler)(id);
+  }
+  else if (touching && event.type == UI_TICK)
+  {
+    touching = NULL;
+  }
+  return true;
 }
 
 /**
  * Full screen display of SetUp options as buttons.
  */
-void SetUpScreen(Adafruit_ILI9341_STM& tft, XPT2046& touch)
-{
-  enum EButton {
-    bttn_set_time,
-    bttn_set_date,
-    bttn_set_week_day,
-    bttn_done,
-    bttn_max    // Always the last enum.
-  };
-
-  bool Done = false;
-  Button* touching = NULL;
-  
-  Button* bttns[bttn_max];
-  //Button stb(&tft, 20, 40, 130, 40, "Time");
-  Button stb(&tft, 95, 40, 130, 40, "Time");
-  Button sdb(&tft, 95, 90, 130, 40, "Date");
-  Button swdb(&tft, 95, 140, 130, 40, "Week Day");
-  //Button sdb(&tft, 170, 40, 130, 40, "Date");
-  Button dnb(&tft, 95, 190, 130, 40, "Done");
-
-  EButton pressed;
-
-  bttns[bttn_set_time]      = &stb;
-  bttns[bttn_set_date]      = &sdb;
-  bttns[bttn_set_week_day]  = &swdb;
-  bttns[bttn_done]          = &dnb;
-
-  tft.fillScreen(ILI9341_BLACK);
-  tft.setTextColor(ILI9341_WHITE, ILI9341_BLACK);
-  tft.drawCentreString("SET", 160, 10, 4); 
-  for(int idx=0; idx < (int)bttn_max; idx++) bttns[idx]->Draw();
-
-  while(!Done)
+const Control<SetUpScreen> SetUpScreen::menu[4] = {
+  { &SetUpScreen::stb, &SetUpScreen::ShowTime },
+  { &SetUpScreen::sdb, &SetUpScreen::ShowDate },
+  { &SetUpScreen::swdb, &SetUpScreen::ShowWeekDay },
+  { &SetUpScreen::dnb, &SetUpScreen::Close }
+};
+
+SetUpScreen::SetUpScreen(Adafruit_ILI9341_STM* screen)
+: state(setup_closed), wait_release(false),
+  stb(screen, 95, 40, 130, 40, "Time"),
+  sdb(screen, 95, 90, 130, 40, "Date"),
+  swdb(screen, 95, 140, 130, 40, "Week Day"),
+  dnb(screen, 95, 190, 130, 40, "Done"),
+  st_ctrl(screen), sd_ctrl(screen), sdow_ctrl(screen),
+  tft(screen)
+{ }
+
+void SetUpScreen::ShowMenu()
+{
+  tft->fillScreen(ILI9341_BLACK);
+  tft->setTextColor(ILI9341_WHITE, ILI9341_BLACK);
+  tft->drawCentreString("SET", 160, 10, 4); 
+  draw_all(stb, sdb, swdb, dnb);
+  hit_map.Build(this, menu, sizeof(menu) / sizeof(menu[0]));
+  state = setup_menu;
+}
+
+void SetUpScreen::Open()
+{
+  ShowMenu();
+  wait_release = true;      // The long press is still down.
+}
+
+bool SetUpScreen::Active()
+{
+  return state != setup_closed;
+}
+
+bool SetUpScreen::ShowTime(uint8_t)
+{
+  TM_T now;
+
+  softclock.get(&now); 
+  tft->fillScreen(ILI9341_BLACK);
+  st_ctrl.Display(now); 
+  state = setup_time;
+  return true;
+}
+
+bool SetUpScreen::ShowDate(uint8_t)
+{
+  TM_T now;
+
+  softclock.get(&now); 
+  tft->fillScreen(ILI9341_BLACK);
+  sd_ctrl.Display(now);
+  state = setup_date;
+  return true;
+}
+
+bool SetUpScreen::ShowWeekDay(uint8_t)
+{
+  TM_T now;
+
+  softclock.get(&now); 
+  tft->fillScreen(ILI9341_BLACK);
+  sdow_ctrl.Display(now);
+  state = setup_week_day;
+  return true;
+}
+
+bool SetUpScreen::Close(uint8_t)
+{
+  state = setup_closed;
+  return false;
+}
+
+void SetUpScreen::HandleMenu(const UI_EVENT_T &event)
+{
+  uint8_t id;
+
+  if (event.type != UI_TOUCH)
+    return;
+
+  // Which Button widget is being touched, if any.
+  id = hit_map.Press(event.x, event.y);
+  if (id == HIT_NONE)
+    return;
+
+  beepPlay(beep_click);  // Beep to show a button was pressed.
+  (this->*menu[id].button).Release();
+  (this->*menu[id].handler)(id);
+  wait_release = true;
+}
+
+bool SetUpScreen::Dispatch(const UI_EVENT_T &event)
+{
+  bool open = true;
+
+  if (state == setup_closed)
+    return false;
+
+  // Wait for the touch that opened the screen to end.
+  if (wait_release)
   {
-    if (!touching && touch.isTouching())
-    {
-      uint16_t x, y, tens, units;
-      touch.getPosition(x, y);
-      pressed = bttn_max;
-
-      // Which Button widget is being touched, if any.
-      for(int idx=0; idx < (int)bttn_max; idx++)
-      {
-        if ( (touching = (Button *)bttns[idx]->Press(x, y)) )
-        {
-          beepDelay(50);  // Beep to show a button was pressed.
-          pressed = (EButton)idx;
-          touching->Release();
-          touching = NULL;
-          break;
-        }
-      }  
-
-      if (bttn_max != pressed) 
-      {
-        TM_T now;
-        get_date_time(&now); 
-        
-        switch (pressed) 
-        {
-          case bttn_set_time:
-          {
-            SetTime st_ctrl(&tft, &touch);
-            tft.fillScreen(ILI9341_BLACK);
-            st_ctrl.Display(now); 
-            st_ctrl.Update(now);
-            break;
-          }
-          case bttn_set_date:
-          {
-            SetDate sd_ctrl(&tft, &touch);
-            tft.fillScreen(ILI9341_BLACK);
-            sd_ctrl.Display(now);
-            sd_ctrl.Update(now); 
-            break;
-          }
-          case bttn_set_week_day:
-          {
-            SetDayOfWeek sdow_ctrl(&tft, &touch);
-            tft.fillScreen(ILI9341_BLACK);
-            sdow_ctrl.Display(now);
-            sdow_ctrl.Update(now); 
-            break;
-          }
-          case bttn_done:
-            Done = true;
-            break;
-          default:
-            // Shouldn't happen
-            break;
-        }
-
-        // redraw if returning from setup screen.
-        if (pressed != bttn_done) {
-          tft.fillScreen(ILI9341_BLACK);
-          tft.setTextColor(ILI9341_WHITE, ILI9341_BLACK);
-          tft.drawCentreString("SET", 160, 10, 4); 
-          for(int idx=0; idx < (int)bttn_max; idx++) bttns[idx]->Draw();
-        }
-      }
-    }
-    else if (touching && !touch.isTouching())
-    {
-      touching->Release();
-      touching = NULL;
-    }
-    delay(50);
+    wait_release = (event.type == UI_TOUCH);
+    return true;
   }
+
+  switch (state)
+  {
+    case setup_menu:
+      HandleMenu(event);
+      break;
+    case setup_time:
+      open = st_ctrl.Handle(event);
+      break;
+    case setup_date:
+      open = sd_ctrl.Handle(event);
+      break;
+    case setup_week_day:
+      open = sdow_ctrl.Handle(event);
+      break;
+    default:
+      break;
+  }
+
+  // Back to the menu when an option's screen is closed.
+  if (!open)
+  {
+    ShowMenu();
+    wait_release = true;
+  }
+  return state != setup_closed;
 }
 
 /*
@@ -1030,39 +971,20 @@ DisplayAlarm::DisplayAlarm(Adafruit_ILI9341_STM* screen, int x_pos, int y_pos)
   ox = x_pos;
   oy = y_pos;
 
-  comps[0] = &ht;
-  comps[1] = &hu;
-  comps[2] = &c1;
-  comps[3] = &mt;
-  comps[4] = &mu;
-  comps[5] = (Component *)&on;
-  comps[6] = (Component *)&off;
-  
-  for (int idx=0; idx < DisplayAlarm::MAX_COMPS; idx++)
-  {
-    comps[idx]->setScreen(screen);
-  }
+  set_screen_all(screen, ht, hu, c1, mt, mu, on, off);
 }
 
 void DisplayAlarm::Display(ALARM_T alarm)
 {
-    int x = ox;
-    int y = oy;
-
-    ht.setPosition(x, y);
+    Layout::place(ox, oy, ht, hu, c1, mt, mu);
     ht.setValue(alarm.tm_hour / 10);
-    hu.setPosition(x+=DGT_W, y);
     hu.setValue(alarm.tm_hour % 10);
-    c1.setPosition(x+=DGT_W, y);
-    mt.setPosition(x+=CLN_W, y);
     mt.setValue(alarm.tm_min / 10);
-    mu.setPosition(x+=DGT_W, y);
     mu.setValue(alarm.tm_min % 10);
 
-    for (int idx=0; idx < MAX_COMPS; idx++)
-    {
-      comps[idx]->Draw();
-    }
+    compositor.Begin();
+    invalidate_all(ht, hu, c1, mt, mu, on, off);
+    compositor.Flush();
 }
 
 void DisplayAlarm::Update(ALARM_T alarm)
@@ -1083,7 +1005,9 @@ DisplayAlarmWidget::DisplayAlarmWidget(
   int y_pos
   )
 : DisplayAlarm(screen, x_pos+44, y_pos+36),
-  tft(screen), ox(x_pos), oy(y_pos)
+  tft(screen), ox(x_pos), oy(y_pos),
+  name(screen, x_pos+242, y_pos+36, "", 4, true),
+  state(screen, x_pos+242, y_pos+60, "", 4, true)
 {}
 
 void DisplayAlarmWidget::Display(
@@ -1103,10 +1027,15 @@ void DisplayAlarmWidget::Display(
       alm_state[2] = '\0';
   }
 
-  tft->fillRect(ox+1, oy+1, 318, 118, ILI9341_BLACK);
+  name.setText(alm_str);
+  state.setText(alm_state);
+
+  compositor.Begin();
+  compositor.Fill(tft, ox+1, oy+1, 318, 118, ILI9341_BLACK);
   DisplayAlarm::Display(alarm);
-  tft->drawCentreString( alm_str, ox+242, oy+36, 4);
-  tft->drawCentreString( alm_state, ox+242, oy+60, 4);
+  name.Invalidate();
+  state.Invalidate();
+  compositor.Flush();
 }
 
 
@@ -8,8 +8,6 @@
  * Widgets are either full screen (320x240) or half screen (320x120)
  */
 
-#include <XPT2046.h>
-
 #include "DS3231_RTC.h"
 #include "GUI.h"
 
@@ -20,12 +18,12 @@
  */
 class DisplayTime 
 {
-  const static int MAX_COMPS=8;
-  int ox;
-  int oy;
+  // HH:MM:SS
+  typedef Row<DGT_W, DGT_W, CLN_W, DGT_W, DGT_W, CLN_W, DGT_W, DGT_W> Layout;
+  int16_t ox;
+  int16_t oy;
   Digit ht, hu, mt, mu, st, su;
   Colon c1, c2;
-  Component *comps[MAX_COMPS];
 public:
 
   /*!
@@ -65,8 +63,8 @@ public:
 class DisplayTimeWidget: public DisplayTime
 {
   Adafruit_ILI9341_STM* tft;
-  int ox;
-  int oy;
+  int16_t ox;
+  int16_t oy;
 public:
 
   /*!
@@ -98,16 +96,14 @@ public:
  */
 class DisplayDateFull
 {
-  const static int MAX_COMPS=6;
-  int ox;
-  int oy;
+  int16_t ox;
+  int16_t oy;
   DoubleDigit dd;
   OrdinalString os;
   MonthString ms;
   DoubleDigit yu;
   DoubleDigit yl;
   WeekDay wd;
-  Component *comps[MAX_COMPS];
 public:
 
   /*!
@@ -147,8 +143,8 @@ public:
 class DisplayDateFullWidget : public DisplayDateFull
 {
   Adafruit_ILI9341_STM* tft;
-  int ox;
-  int oy;
+  int16_t ox;
+  int16_t oy;
 public:
 
   /*!
@@ -179,15 +175,15 @@ public:
  */
 class DisplayDate
 {
-  const static int MAX_COMPS=6;
-  int ox;
-  int oy;
+  // DD.MM.YYYY
+  typedef Row<DGT6_W*2, FS6_W, DGT6_W*2, FS6_W, DGT6_W*2, DGT6_W*2> Layout;
+  int16_t ox;
+  int16_t oy;
   DoubleDigit md;
   DoubleDigit mn;
   DoubleDigit yu;
   DoubleDigit yl;
   Fullstop fs1, fs2;
-  Component *comps[MAX_COMPS];
 public:
 
   /*!
@@ -229,12 +225,12 @@ public:
  */
 class DayOfWeek
 {
-  const static int MAX_BTTNS = 7;
+  typedef Row<40, 40, 40, 40, 40, 40, 40> Layout;
+  static Button DayOfWeek::* const days[7];   // Indexed by tm_wday - 1.
   Button mo, tu, we, th, fr, sa, su;
-  int ox;
-  int oy;
-  Button *bttns[MAX_BTTNS];
-  int today;
+  int16_t ox;
+  int16_t oy;
+  uint8_t today;
 public:
 
   /*!
@@ -273,8 +269,8 @@ public:
 class DisplayDateWidget : public DisplayDate, DayOfWeek
 {
   Adafruit_ILI9341_STM* tft;
-  int ox;
-  int oy;
+  int16_t ox;
+  int16_t oy;
 public:
   /*!
    * \brief Constructor.
@@ -314,9 +310,10 @@ class DisplayTemp
   DoubleDigit tmp;
   Digit hlfdgr;
   Fullstop fs;
-  int ox;
-  int oy;
+  int16_t ox;
+  int16_t oy;
   Adafruit_ILI9341_STM* tft;
+  Label dgr, cel;
 public:
   /*!
    * \brief Constructor.
@@ -354,8 +351,8 @@ public:
 class DisplayTempWidget : public DisplayTemp
 {
   Adafruit_ILI9341_STM* tft;
-  int ox;
-  int oy;
+  int16_t ox;
+  int16_t oy;
 public:
 
   /*!
@@ -384,15 +381,32 @@ public:
  */
 class SetTime
 {
-  const static int MAX_BTTNS=14;
-  int ox;
-  int oy;
+  // A button over each digit of the DisplayTime.
+  typedef Row<DGT_W, DGT_W+CLN_W, DGT_W, DGT_W+CLN_W, DGT_W, DGT_W> Layout;
+  int16_t ox;
+  int16_t oy;
   DisplayTime dt;
   Button htu, htd, huu, hud, mtu, mtd, muu, mud, stu, std, suu, sud;
   Button bok, bcancel;
-  Button *bttns[MAX_BTTNS];
+  Button* touching;
+  TM_T setting;
   Adafruit_ILI9341_STM* tft;
-  XPT2046* touch;
+
+  static const Control<SetTime> controls[14];
+  bool HourTensUp(uint8_t id);
+  bool HourUnitsUp(uint8_t id);
+  bool MinTensUp(uint8_t id);
+  bool MinUnitsUp(uint8_t id);
+  bool SecTensUp(uint8_t id);
+  bool SecUnitsUp(uint8_t id);
+  bool HourTensDown(uint8_t id);
+  bool HourUnitsDown(uint8_t id);
+  bool MinTensDown(uint8_t id);
+  bool MinUnitsDown(uint8_t id);
+  bool SecTensDown(uint8_t id);
+  bool SecUnitsDown(uint8_t id);
+  bool Ok(uint8_t id);
+  bool Cancel(uint8_t id);
 public:
 
   /*!
@@ -401,26 +415,28 @@ public:
    * No need for X,Y coordinates as this is a full screen widget.
    *
    * \param screen Pointer to an ILI9341 display class for the TFT.
-   * \param touch_screen Pointer to the XPT2046 touch class.
    */
-  SetTime(Adafruit_ILI9341_STM* screen, XPT2046* touch_screen);
+  SetTime(Adafruit_ILI9341_STM* screen);
 
   /*!
    * \brief Display the SetTime widget, drawing it completely.
    *
-   * \param now TM_T structure containing the current date and time.
+   * \param now TM_T structure containing the current date and time, which
+   *        is the time being set.
    */
   void Display(TM_T now);
 
   /*!
-   * \brief Update the time widget display.
+   * \brief Handle one touch screen event.
    *
-   * Goes into a control loop, reading the touchscreen in a loop and only
-   * exits if the 'Ok' or 'Cancel' button are pressed. 
+   * A button acts when it is first touched and is released when the touch
+   * ends. Returns straight away, it doesn't wait for the user.
    *
-   * \param now TM_T structure containing the current date and time.
+   * \param event The touch screen event.
+   *
+   * \result False once the 'Ok' or 'Cancel' button has been pressed.
    */
-  void Update(TM_T now);
+  bool Handle(const UI_EVENT_T &event);
 };
 
 /*!
@@ -432,42 +448,56 @@ public:
  */
 class SetDate
 {
-  const static int MAX_BTTNS=8;
-  int ox;
-  int oy;
+  // A button over the day, month and year of the DisplayDate.
+  typedef Row<(DGT6_W*2)+FS6_W, (DGT6_W*4)+FS6_W, DGT6_W*2> Layout;
+  int16_t ox;
+  int16_t oy;
   DisplayDate dd;
   Button mdu, mdd, mu, md, yu, yd;
   Button bok, bcancel;
-  Button *bttns[MAX_BTTNS];
+  Button* touching;
+  TM_T setting;
+  uint8_t month_days;
   Adafruit_ILI9341_STM* tft;
-  XPT2046* touch;
+
+  static const Control<SetDate> controls[8];
+  bool DayUp(uint8_t id);
+  bool MonthUp(uint8_t id);
+  bool YearUp(uint8_t id);
+  bool DayDown(uint8_t id);
+  bool MonthDown(uint8_t id);
+  bool YearDown(uint8_t id);
+  bool Ok(uint8_t id);
+  bool Cancel(uint8_t id);
 public:
   /*!
-   * \brief Update the date widget display.
+   * \brief Constructor.
    *
-   * Goes into a control loop, reading the touchscreen in a loop and only
-   * exits if the 'Ok' or 'Cancel' button are pressed. 
+   * No need for X,Y coordinates as this is a full screen widget.
    *
-   * \param now TM_T structure containing the current date and time.
+   * \param screen Pointer to an ILI9341 display class for the TFT.
    */
-  SetDate(Adafruit_ILI9341_STM* screen, XPT2046* touch_screen);
+  SetDate(Adafruit_ILI9341_STM* screen);
   
   /*!
    * \brief Display the SetDate widget, drawing it completely.
    *
-   * \param now TM_T structure containing the current date and time.
+   * \param now TM_T structure containing the current date and time, which
+   *        is the date being set.
    */
   void Display(TM_T now);
 
   /*!
-   * \brief Update the SetDate widget display.
+   * \brief Handle one touch screen event.
    *
-   * Goes into a control loop, reading the touchscreen in a loop and only
-   * exits if the 'Ok' or 'Cancel' button are pressed. 
+   * A button acts when it is first touched and is released when the touch
+   * ends. Returns straight away, it doesn't wait for the user.
    *
-   * \param now TM_T structure containing the current date and time.
+   * \param event The touch screen event.
+   *
+   * \result False once the 'Ok' or 'Cancel' button has been pressed.
    */
-  void Update(TM_T now);
+  bool Handle(const UI_EVENT_T &event);
 };
 
 /*!
@@ -482,15 +512,20 @@ public:
  */
 class SetDayOfWeek
 {
-  const static int MAX_BTTNS = 9;
+  typedef Row<60, 60, 60, 60, 60> Layout;
   Button mo, tu, we, th, fr, sa, su;
-  int ox;
-  int oy;
-  int today;
+  int16_t ox;
+  int16_t oy;
+  uint8_t today;
   Button bok, bcancel;
-  Button *bttns[MAX_BTTNS];
+  Button* touching;
   Adafruit_ILI9341_STM* tft;
-  XPT2046* touch;
+
+  // The days first, so the id of a day is tm_wday - 1.
+  static const Control<SetDayOfWeek> controls[9];
+  bool SelectDay(uint8_t id);
+  bool Ok(uint8_t id);
+  bool Cancel(uint8_t id);
 public:
   /*!
    * \brief Constructor.
@@ -498,9 +533,8 @@ public:
    * No need for X,Y coordinates as this is a full screen widget.
    *
    * \param screen Pointer to an ILI9341 display class for the TFT.
-   * \param touch_screen Pointer to the XPT2046 touch class.
    */
-  SetDayOfWeek(Adafruit_ILI9341_STM* screen, XPT2046* touch_screen);
+  SetDayOfWeek(Adafruit_ILI9341_STM* screen);
 
   /*!
    * \brief Display the SetDayOfWeek widget, drawing it completely.
@@ -510,37 +544,104 @@ public:
   void Display(TM_T now);
 
   /*!
-   * \brief Update the SetDayOfWeek widget display.
+   * \brief Handle one touch screen event.
    *
-   * Goes into a control loop, reading the touchscreen in a loop and only
-   * exits if the 'Ok' or 'Cancel' button are pressed. 
+   * A button acts when it is first touched and is released when the touch
+   * ends. Returns straight away, it doesn't wait for the user.
    *
-   * \param now TM_T structure containing the current date and time.
+   * \param event The touch screen event.
+   *
+   * \result False once the 'Ok' or 'Cancel' button has been pressed.
    */
-  void Update(TM_T now);
+  bool Handle(const UI_EVENT_T &event);
 };
 
 /*!
- * \brief SetUpScreen Is the man menu screen for setup configuration.
+ * \brief SetUpScreen class, the main menu screen for setup configuration.
  *
- * Full screen display. This function displays buttons for each configuration
- * option and goes into a display loop until 'Done' is pressed, when it 
- * returns to the main 'display' functionality.
+ * Full screen display of a button for each configuration option, which opens
+ * that option's screen, and 'Done'. It is a state machine driven from loop():
+ * each Dispatch() passes one touch screen event to the menu or the open
+ * option screen, so the clock, alarms and RTC keep being serviced while the
+ * user is in setup.
  *
-* \param screen Pointer to an ILI9341 display class for the TFT.
-* \param touch_screen Pointer to the XPT2046 touch class.
+ * NOTES:
+ *      - After a screen is opened touches are ignored until the screen is
+ *        released, so the touch that opened it doesn't press its buttons.
+ *      - The main display mustn't be drawn while setup is active, it would
+ *        draw over the setup screens.
  */
-void SetUpScreen(Adafruit_ILI9341_STM& tft, XPT2046& touch);
+class SetUpScreen
+{
+  enum EState {
+    setup_closed,
+    setup_menu,
+    setup_time,
+    setup_date,
+    setup_week_day
+  };
+
+  uint8_t state;
+  bool wait_release;
+  Button stb, sdb, swdb, dnb;
+  SetTime st_ctrl;
+  SetDate sd_ctrl;
+  SetDayOfWeek sdow_ctrl;
+  Adafruit_ILI9341_STM* tft;
+
+  static const Control<SetUpScreen> menu[4];
+  void ShowMenu();
+  void HandleMenu(const UI_EVENT_T &event);
+  bool ShowTime(uint8_t id);
+  bool ShowDate(uint8_t id);
+  bool ShowWeekDay(uint8_t id);
+  bool Close(uint8_t id);
+public:
+  /*!
+   * \brief Constructor.
+   *
+   * \param screen Pointer to an ILI9341 display class for the TFT.
+   */
+  SetUpScreen(Adafruit_ILI9341_STM* screen);
+
+  /*!
+   * \brief Open the setup menu, drawing it completely.
+   *
+   * Called while the touch that opened it is still down, e.g. on a long
+   * press, so touches are ignored until it is released.
+   */
+  void Open();
+
+  /*!
+   * \brief Is the setup menu, or one of its screens, open.
+   *
+   * \result True if open.
+   */
+  bool Active();
+
+  /*!
+   * \brief Handle one touch screen event.
+   *
+   * Call for each touch screen event while Active(). Never waits for the
+   * user, the longest it takes is redrawing a screen.
+   *
+   * \param event The touch screen event.
+   *
+   * \result False once 'Done' has been pressed and setup has closed. The
+   *         main display should then be redrawn.
+   */
+  bool Dispatch(const UI_EVENT_T &event);
+};
 
 class DisplayAlarm
 {
-    const static int MAX_COMPS=7;
-    int ox;
-    int oy;
+    // HH:MM
+    typedef Row<DGT_W, DGT_W, CLN_W, DGT_W, DGT_W> Layout;
+    int16_t ox;
+    int16_t oy;
     Digit ht, hu, mt, mu;
     Colon c1;
     Button on, off;
-    Component *comps[MAX_COMPS];
 public:
 
     /*!
@@ -577,8 +678,9 @@ public:
 class DisplayAlarmWidget : public DisplayAlarm
 {
   Adafruit_ILI9341_STM* tft;
-  int ox;
-  int oy;
+  int16_t ox;
+  int16_t oy;
+  Label name, state;
 public:
   /*!
    * \brief Constructor.
@@ -13,7 +13,13 @@
 #include "DS3231_RTC.h"           // DS3231 Real Time Clock
 #include "GUI.h"                  // Graphical User Interface classes
 #include "DateTime.h"
+#include "SoftClock.h"            // Time keeping between RTC reads
+#include "AlarmScheduler.h"       // Software alarms on the DS3231 Alarm 1
+#include "TaskScheduler.h"        // Runs the work in loop()
+#include "TouchInput.h"           // Touch events from the PENIRQ interrupt
+#include "Gesture.h"              // Taps and swipes from the touch events
 #include "beep.h"
+#include "Benchmark.h"
 
 // The TFT Screen uses SPI 1 (default SPI port).
 #define tft_cs   7
@@ -25,12 +31,35 @@
 #define touch_irq 27
 #define touch_spiport 2
 
+// DS3231 INT/SQW output, open drain so it needs the pull-up.
+#define rtc_sqw 26
+
 #define display_alm1 0
 #define display_alm2 1
 #define display_date 2
 #define display_temp 3
 #define display_last 4
 
+// Uncomment to print the RTC I2C bus usage once a second, from ClockTask().
+//#define RTC_BUS_STATS
+
+// Uncomment to run the benchmarks at the end of setup().
+//#define BENCHMARK
+
+// Uncomment to update the clock on the DS3231 1Hz square wave rather than
+// by polling the software clock. The software clock is also aligned to it.
+// Alarm 1 can't pull the INT/SQW line low then, so its flag is read on each
+// tick instead.
+//#define SQW_TICK
+
+// Uncomment to print the run time and deadline misses of each task.
+//#define TASK_STATS
+
+// Task periods and deadlines in ms.
+#define CLOCK_POLL_MS 50        // Polls for the next second without SQW_TICK.
+#define RTC_STEP_MS 10          // Steps of the queued RTC operations.
+#define STATS_MS 10000         // Printing the task stats.
+
 #if 0
 #define PWM_VALUE 200
 #define PWM_PIN 25
@@ -56,16 +85,22 @@ DisplayTimeWidget dtw = DisplayTimeWidget(&tft, 0, 0);
 DisplayAlarmWidget almw = DisplayAlarmWidget(&tft, 0, 120);
 DisplayDateFullWidget ddw = DisplayDateFullWidget(&tft, 0, 120);
 DisplayTempWidget temp = DisplayTempWidget(&tft, 0, 120);
+SetUpScreen setup_screen = SetUpScreen(&tft);
+GestureRecogniser gestures;
 
 void DisplayMain(uint8_t mode, bool display_time=true)
 {
   TM_T now;
-  get_date_time(&now);
 
+  rtc_refresh();    // Alarm and temperature are read from this one snapshot.
+  softclock.get(&now);
+
+  // Batch the redraw so the screen is only cleared where the widgets don't
+  // draw over it anyway.
+  compositor.Begin();
   if (display_time)
   {
-    tft.fillScreen(ILI9341_BLACK);
-    tft.drawFastHLine(10, 120, 300, ILI9341_WHITE);  
+    compositor.Fill(&tft, 0, 0, 320, 240, ILI9341_BLACK);
     dtw.Display(now);
   }
   
@@ -91,18 +126,26 @@ void DisplayMain(uint8_t mode, bool display_time=true)
       {
         TEMP_T temp_now;
         
+        rtc_convert_temp();   // Updated with a fresh reading in ~200ms.
         get_temp(&temp_now);
         temp.Display(temp_now);
       }
       break;
   }
+  compositor.Flush();
+
+  if (display_time)
+  {
+    tft.drawFastHLine(10, 120, 300, ILI9341_WHITE);  
+  }
 }
 
 static void DisplayUpdate(uint8_t mode)
 {
   TM_T now;
 
-  get_date_time(&now);
+  softclock.get(&now);
+  compositor.Begin();
   dtw.Update(now);
   
   switch (mode)
@@ -123,9 +166,251 @@ static void DisplayUpdate(uint8_t mode)
       }
       break;
   }
+  compositor.Flush();
+}
+
+TaskScheduler scheduler;
+
+// Task ids, in priority order.
+uint8_t touch_task = TASK_NONE;
+uint8_t clock_task = TASK_NONE;
+uint8_t render_task = TASK_NONE;
+uint8_t rtc_task = TASK_NONE;
+#ifdef TASK_STATS
+uint8_t stats_task = TASK_NONE;
+#endif
+
+#ifdef SQW_TICK
+/**
+ * The 1Hz SQW interrupt, the RTC second has just started.
+ */
+static void SqwTick()
+{
+  scheduler.signal(clock_task);
+}
+#endif
+
+/**
+ * Called by the alarm scheduler when a software alarm fires.
+ */
+static void AlarmFired(uint8_t id)
+{
+  Serial.print("Alarm ");
+  Serial.print(id);
+  Serial.println(" fired");
+  beepPlay(beep_alarm);
+}
+
+AlarmScheduler alarms = AlarmScheduler(AlarmFired);
+
+/**
+ * Fire any software alarms that are due.
+ */
+static void ServiceAlarms()
+{
+  TM_T now;
+
+  alarms.service(softclock.get(&now));
 }
 
-int count;
+#ifndef SQW_TICK
+volatile bool alarm_int = false;
+
+/**
+ * The DS3231 INT line fell, Alarm 1 has triggered.
+ */
+static void RtcAlarm()
+{
+  alarm_int = true;
+  scheduler.signal(rtc_task);
+}
+#endif
+
+/**
+ * Steps the queued RTC operations. Without SQW_TICK, also fires the alarms
+ * when the INT line has fallen, from a fresh read of A1F.
+ */
+static void RtcTask()
+{
+#ifndef SQW_TICK
+  if (alarm_int)
+  {
+    alarm_int = false;
+    rtc_refresh();
+    ServiceAlarms();
+  }
+#endif
+  rtc_service();
+}
+
+/**
+ * Called from the touch interrupts when an event is queued.
+ */
+static void TouchNotify()
+{
+  scheduler.signal(touch_task);
+}
+
+/**
+ * Acts on a gesture on the main display. Swipes and taps move through the
+ * bottom part of the display, a double tap goes back to the date and a long
+ * press opens the setup screens.
+ */
+static void HandleGesture(const GESTURE_T &gesture)
+{
+  switch (gesture.type)
+  {
+    case GESTURE_TAP:
+    /* Deliberate drop-through. */
+    case GESTURE_SWIPE_LEFT:
+      dm = (dm + 1) % display_last;
+      DisplayMain(dm, false);
+      break;
+
+    case GESTURE_SWIPE_RIGHT:
+      dm = (dm + display_last - 1) % display_last;
+      DisplayMain(dm, false);
+      break;
+
+    case GESTURE_DOUBLE_TAP:
+      if (dm != display_date)
+      {
+        dm = display_date;
+        DisplayMain(dm, false);
+      }
+      break;
+
+    case GESTURE_LONG_PRESS:
+      setup_screen.Open();
+      break;
+  }
+}
+
+/**
+ * Handles the queued touch events. On the main display they go through the
+ * gesture recogniser, the setup screens are passed them directly.
+ */
+static void TouchTask()
+{
+  TOUCH_EVENT_T event;
+  GESTURE_T gesture;
+  uint32_t due_ms;
+
+  while (touch_input_read(&event))
+  {
+    if (setup_screen.Active())
+    {
+      UI_EVENT_T ui_event;
+
+      ui_event.type = (event.type == TOUCH_RELEASE) ? UI_TICK : UI_TOUCH;
+      ui_event.x = event.x;
+      ui_event.y = event.y;
+      if (!setup_screen.Dispatch(ui_event))
+      {
+        gestures.reset();
+        DisplayMain(dm);
+      }
+      continue;
+    }
+
+    if (event.type == TOUCH_PRESS)
+    {
+      beepPlay(beep_click);
+    }
+    if (gestures.feed(event, &gesture))
+    {
+      HandleGesture(gesture);
+    }
+  }
+
+  // A long press or a tap that can no longer be a double tap.
+  if (!setup_screen.Active())
+  {
+    if (gestures.poll(millis(), &gesture))
+    {
+      HandleGesture(gesture);
+    }
+    if (!setup_screen.Active() && gestures.due(&due_ms))
+    {
+      int32_t delay_ms = (int32_t)(due_ms - millis());
+
+      scheduler.wake(touch_task, delay_ms > 0 ? delay_ms : 0);
+    }
+  }
+}
+
+/**
+ * Once a second, when the software clock second changes or on the SQW tick,
+ * fires any alarms that are due and has the display updated.
+ */
+static void ClockTask()
+{
+  static uint8_t last_sec = 0xFF;
+  TM_T now;
+
+#ifdef SQW_TICK
+  softclock.align();
+#endif
+  softclock.get(&now);
+  if (now.tm_sec == last_sec)
+    return;
+  last_sec = now.tm_sec;
+
+  ServiceAlarms();
+  scheduler.signal(render_task);
+
+#ifdef RTC_BUS_STATS
+  {
+    RTC_BUS_STATS_T stats;
+
+    rtc_get_bus_stats(&stats, true);
+    Serial.print("RTC bus: ");
+    Serial.print(stats.transactions);
+    Serial.print(" trans, ");
+    Serial.print(stats.bytes);
+    Serial.print(" bytes. Saved: ");
+    Serial.print((long)stats.saved_transactions - (long)stats.transactions);
+    Serial.print(" trans, ");
+    Serial.print((long)stats.saved_bytes - (long)stats.bytes);
+    Serial.println(" bytes");
+  }
+#endif
+}
+
+/**
+ * Updates the main display. The setup screens cover it, so it isn't updated
+ * while they are open.
+ */
+static void RenderTask()
+{
+  if (!setup_screen.Active())
+  {
+    DisplayUpdate(dm);
+  }
+}
+
+#ifdef TASK_STATS
+static void StatsTask()
+{
+  TOUCH_STATS_T touch_stats;
+
+  scheduler.printStats();
+  Serial.print("Touch events dropped: ");
+  Serial.println(touch_input_dropped(true));
+
+  touch_input_stats(&touch_stats, true);
+  Serial.print("Touch positions: ");
+  Serial.print(touch_stats.positions);
+  Serial.print(", ");
+  Serial.print(touch_stats.rejected);
+  Serial.print(" rejected, ");
+  Serial.print(touch_stats.positions ?
+    touch_stats.total_us / touch_stats.positions : 0);
+  Serial.print("us average, ");
+  Serial.print(touch_stats.worst_us);
+  Serial.println("us worst");
+}
+#endif
 
 /** 
  * setup
@@ -137,6 +422,9 @@ void setup() {
   tft.fillScreen(ILI9341_DARKGREEN);
   Serial.begin(9600);
 
+  // Beeps play in the background from now on.
+  beepBegin();
+
   // Initialise the touch panel.
   touch.begin(240, 320);
   touch.setCalibration(248, 1700, 1743, 309);
@@ -145,6 +433,17 @@ void setup() {
 
   // I2C initialisation for the RTC.
   Wire.begin();
+  softclock.begin();
+
+  // The INT/SQW line is the 1Hz tick, or falls when Alarm 1 triggers.
+  pinMode(rtc_sqw, INPUT_PULLUP);
+#ifdef SQW_TICK
+  set_square_wave(true);
+  attachInterrupt(rtc_sqw, SqwTick, FALLING);
+#else
+  set_square_wave(false);
+  attachInterrupt(rtc_sqw, RtcAlarm, FALLING);
+#endif
 
   // Just pause for a bit.
   tft.drawCentreString("Intialising...", 160, 103, 4);
@@ -159,7 +458,7 @@ void setup() {
     ALARM_T alarm;
     TM_T now;
 
-    get_date_time(&now);
+    softclock.get(&now);
     
     get_alarm_status(&enabled, &triggered);
     Serial.print("Enabled: ");
@@ -179,53 +478,38 @@ void setup() {
     Serial.print(":");
     Serial.println(alarm.tm_min);
 
-    alarm.tm_hour=now.tm_hour;
-    alarm.tm_min=(now.tm_min + 2) % 60;
-    set_alarm_time(ALARM1, &alarm);
-    set_alarm(ALARM1, true);
+    // A one-shot test alarm in 2 minutes. Alarm 1 is programmed from
+    // loop() via rtc_service.
+    alarms.add(now.tm_hour, (now.tm_min + 2) % 60, ALARM_EVERY_DAY, false, &now);
+  }
 
-    get_alarm_time(ALARM1, &alarm);
-    Serial.print("Alarm 1: ");
-    Serial.print(alarm.tm_hour);
-    Serial.print(":");
-    Serial.println(alarm.tm_min);
+#ifdef BENCHMARK
+  while (rtc_service());  // Let the queued alarm complete first.
+  bench_sizes();
+  bench_glyphs(&tft);
+  bench_cost_start();
+  DisplayMain(dm);
+  bench_cost_print("DisplayMain");
+#endif
 
-    get_alarm_status(&enabled, &triggered);
-    Serial.print("Enabled: ");
-    Serial.print(enabled, 16);
-    Serial.print(", Triggered: ");
-    Serial.println(triggered, 16);
-  }
-  delay(50);
-  count = 0;
+  touch_task = scheduler.add(TouchTask, "touch", TASK_ON_DEMAND, 20);
+#ifdef SQW_TICK
+  clock_task = scheduler.add(ClockTask, "clock", TASK_ON_DEMAND, 20);
+#else
+  clock_task = scheduler.add(ClockTask, "clock", CLOCK_POLL_MS, 20);
+#endif
+  render_task = scheduler.add(RenderTask, "render", TASK_ON_DEMAND, 100);
+  rtc_task = scheduler.add(RtcTask, "rtc", RTC_STEP_MS, 50);
+#ifdef TASK_STATS
+  stats_task = scheduler.add(StatsTask, "stats", STATS_MS, 1000);
+#endif
+
+  // The touch panel is only read from its interrupts from now on. More reads
+  // per position are steadier but slower, see TASK_STATS.
+  touch_input_set_filter(TOUCH_READS, TOUCH_FILTER_SHIFT);
+  touch_input_begin(&touch, touch_irq, TouchNotify);
 }
 
 void loop() {
-  DisplayUpdate(dm);
-
-  if (touch.isTouching())
-  {
-    if (count == 0)
-      beepOn();
-    else if (count >= 1)
-      beepOff();
-    count +=1;
-  }
-  else
-  { 
-    beepOff();
-    if (count >= 20 ) // More than a second before release.
-    {  
-      SetUpScreen(tft, touch);
-      DisplayMain(dm);
-    }
-    else if (count > 0) // Less then a second, rotate the bottom part of the main display.
-    {
-      dm = (dm + 1) % display_last;
-      DisplayMain(dm, false);
-    }
-    count = 0;
-  }
-  
-  delay(50);
+  scheduler.run();
 }
@@ -0,0 +1,481 @@
+#include "DisplayList.h"
+
+DisplayList displaylist;
+
+// Op code of ops the optimiser has dropped.
+#define DL_DROPPED (0xFF)
+
+// Font heights - only font size 2, 4, 6 and 7 are valid.
+static const int font_height[8] = { 0, 0, 16, 0, 26, 0, 48, 48 };
+
+uint32_t dl_bus_time_us(const DL_COST_T *cost, uint32_t clock_hz)
+{
+  return (uint32_t)(((uint64_t)cost->bytes * 8 * 1000000UL) / clock_hz);
+}
+
+RECT_T rect_intersect(const RECT_T &a, const RECT_T &b)
+{
+  RECT_T r;
+  int x1 = min(a.x + a.w, b.x + b.w);
+  int y1 = min(a.y + a.h, b.y + b.h);
+
+  r.x = max(a.x, b.x);
+  r.y = max(a.y, b.y);
+  r.w = x1 - r.x;
+  r.h = y1 - r.y;
+  return r;
+}
+
+bool rect_empty(const RECT_T &r)
+{
+  return (r.w <= 0) || (r.h <= 0);
+}
+
+bool rect_contains(const RECT_T &outer, const RECT_T &inner)
+{
+  return (inner.x >= outer.x) && (inner.y >= outer.y) &&
+         (inner.x + inner.w <= outer.x + outer.w) &&
+         (inner.y + inner.h <= outer.y + outer.h);
+}
+
+int rect_subtract(const RECT_T &a, const RECT_T &b, RECT_T *out)
+{
+  RECT_T i = rect_intersect(a, b);
+  int n = 0;
+
+  if (rect_empty(i))
+  {
+    out[n++] = a;
+    return n;
+  }
+  if (i.y > a.y)
+  {
+    RECT_T above = { a.x, a.y, a.w, i.y - a.y };
+    out[n++] = above;
+  }
+  if (i.y + i.h < a.y + a.h)
+  {
+    RECT_T below = { a.x, i.y + i.h, a.w, (a.y + a.h) - (i.y + i.h) };
+    out[n++] = below;
+  }
+  if (i.x > a.x)
+  {
+    RECT_T left = { a.x, i.y, i.x - a.x, i.h };
+    out[n++] = left;
+  }
+  if (i.x + i.w < a.x + a.w)
+  {
+    RECT_T right = { i.x + i.w, i.y, (a.x + a.w) - (i.x + i.w), i.h };
+    out[n++] = right;
+  }
+  return n;
+}
+
+bool rect_merge(RECT_T &a, const RECT_T &b)
+{
+  if (a.y == b.y && a.h == b.h && (a.x + a.w == b.x || b.x + b.w == a.x))
+  {
+    a.x = min(a.x, b.x);
+    a.w += b.w;
+    return true;
+  }
+  if (a.x == b.x && a.w == b.w && (a.y + a.h == b.y || b.y + b.h == a.y))
+  {
+    a.y = min(a.y, b.y);
+    a.h += b.h;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * TftBackend class - draws the ops on the ILI9341.
+ */
+TftBackend::TftBackend(Adafruit_ILI9341_STM* screen)
+: tft(screen)
+{ }
+
+void TftBackend::setScreen(Adafruit_ILI9341_STM* screen)
+{
+  tft = screen;
+}
+
+void TftBackend::Execute(const DL_OP_T &op)
+{
+  const RECT_T &r = op.rect;
+
+  if (!tft)
+    return;
+
+  switch (op.op)
+  {
+    case DL_FILL:
+      tft->fillRect(r.x, r.y, r.w, r.h, op.fg);
+      break;
+    case DL_RECT:
+      tft->drawRect(r.x, r.y, r.w, r.h, op.fg);
+      break;
+    case DL_GLYPH_DELTA:
+      if (glyph_draw_delta(tft, op.from, op.c, r.x, r.y, op.font, op.fg, op.bg))
+        break;
+      // Otherwise draw it in full.
+      // Fall through.
+    case DL_GLYPH:
+      if (!glyph_draw(tft, op.c, r.x, r.y, op.font, op.fg, op.bg))
+      {
+        tft->setTextColor(op.fg, op.bg);
+        tft->drawChar(op.c, r.x, r.y, op.font);
+      }
+      break;
+    case DL_STRING:
+      tft->setTextColor(op.fg, op.bg);
+      tft->drawString((char *)op.str, r.x, r.y, op.font);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * DisplayList class - records, optimises and executes drawing.
+ */
+DisplayList::DisplayList()
+: nops(0), depth(0), tft(NULL), backend(&tft_backend)
+{
+  memset(&cost, 0, sizeof(cost));
+}
+
+void DisplayList::setBackend(DisplayBackend* display_backend)
+{
+  backend = display_backend ? display_backend : &tft_backend;
+}
+
+void DisplayList::getCost(DL_COST_T *cost_out, bool reset)
+{
+  *cost_out = cost;
+  if (reset)
+  {
+    memset(&cost, 0, sizeof(cost));
+  }
+}
+
+void DisplayList::Begin(Adafruit_ILI9341_STM* screen)
+{
+  if (screen)
+  {
+    tft = screen;
+    tft_backend.setScreen(screen);
+  }
+  depth++;
+}
+
+void DisplayList::End()
+{
+  if (depth && --depth == 0)
+  {
+    Execute();
+  }
+}
+
+// Adds an op for the rectangle, or returns NULL if it is empty. If the list
+// is full what there is so far is executed first.
+DL_OP_T* DisplayList::Add(int op, int x, int y, int w, int h)
+{
+  DL_OP_T* dl_op;
+
+  if (w <= 0 || h <= 0)
+    return NULL;
+
+  if (nops == DL_SIZE)
+  {
+    Execute();
+  }
+
+  dl_op = &ops[nops++];
+  dl_op->rect.x = x;
+  dl_op->rect.y = y;
+  dl_op->rect.w = w;
+  dl_op->rect.h = h;
+  dl_op->op = op;
+  dl_op->str = NULL;
+  cost.recorded++;
+  return dl_op;
+}
+
+void DisplayList::Fill(int x_pos, int y_pos, int width, int height, int colour)
+{
+  DL_OP_T* op = Add(DL_FILL, x_pos, y_pos, width, height);
+
+  if (op)
+  {
+    op->fg = colour;
+  }
+}
+
+void DisplayList::Rect(int x_pos, int y_pos, int width, int height, int colour)
+{
+  DL_OP_T* op = Add(DL_RECT, x_pos, y_pos, width, height);
+
+  if (op)
+  {
+    op->fg = colour;
+  }
+}
+
+void DisplayList::Glyph(
+  char c,
+  int x_pos,
+  int y_pos,
+  int font_size,
+  int fg,
+  int bg
+  )
+{
+  char str[2] = { c, '\0' };
+  DL_OP_T* op;
+
+  if (!tft)
+    return;
+
+  op = Add(DL_GLYPH, x_pos, y_pos, tft->textWidth(str, font_size),
+           font_height[font_size & 7]);
+  if (op)
+  {
+    op->c = c;
+    op->font = font_size;
+    op->fg = fg;
+    op->bg = bg;
+  }
+}
+
+void DisplayList::GlyphDelta(
+  char from,
+  char to,
+  int x_pos,
+  int y_pos,
+  int font_size,
+  int fg,
+  int bg
+  )
+{
+  DL_OP_T* op;
+
+  Glyph(to, x_pos, y_pos, font_size, fg, bg);
+  op = nops ? &ops[nops-1] : NULL;
+  if (op && op->op == DL_GLYPH && op->c == to)
+  {
+    op->op = DL_GLYPH_DELTA;
+    op->from = from;
+  }
+}
+
+void DisplayList::String(
+  const char* str,
+  int x_pos,
+  int y_pos,
+  int font_size,
+  int fg,
+  int bg,
+  bool centred
+  )
+{
+  int width;
+  DL_OP_T* op;
+
+  if (!tft || !str)
+    return;
+
+  // Centred the same way as drawCentreString().
+  width = tft->textWidth((char *)str, font_size);
+  if (centred)
+  {
+    x_pos = max(x_pos - (width / 2), 0);
+  }
+
+  op = Add(DL_STRING, x_pos, y_pos, width, font_height[font_size & 7]);
+  if (op)
+  {
+    op->str = str;
+    op->font = font_size;
+    op->fg = fg;
+    op->bg = bg;
+  }
+}
+
+// Does the op draw every pixel of its rectangle.
+static bool covers(const DL_OP_T &op)
+{
+  return (op.op == DL_FILL) || (op.op == DL_GLYPH && op.fg != op.bg);
+}
+
+// Drops ops that later ones draw over, and trims fills a later op covers
+// one side of or draws an outline round.
+void DisplayList::Hide()
+{
+  for (int idx=0; idx < nops; idx++)
+  {
+    DL_OP_T &op = ops[idx];
+
+    for (int later=idx+1; later < nops && op.op != DL_DROPPED; later++)
+    {
+      const DL_OP_T &over = ops[later];
+
+      if (covers(over))
+      {
+        RECT_T split[4];
+
+        if (rect_contains(over.rect, op.rect))
+        {
+          op.op = DL_DROPPED;
+        }
+        else if (op.op == DL_FILL && rect_subtract(op.rect, over.rect, split) == 1)
+        {
+          op.rect = split[0];
+        }
+      }
+      else if (over.op == DL_RECT && op.op == DL_FILL &&
+               over.rect.x == op.rect.x && over.rect.y == op.rect.y &&
+               over.rect.w == op.rect.w && over.rect.h == op.rect.h)
+      {
+        op.rect.x++;
+        op.rect.y++;
+        op.rect.w -= 2;
+        op.rect.h -= 2;
+        if (rect_empty(op.rect))
+        {
+          op.op = DL_DROPPED;
+        }
+      }
+    }
+  }
+}
+
+// Merges fills of the same colour that line up. The later fill is moved back
+// to the earlier one, so only if nothing in between draws where it was.
+void DisplayList::MergeFills()
+{
+  for (int idx=0; idx < nops; idx++)
+  {
+    if (ops[idx].op != DL_FILL)
+      continue;
+
+    for (int later=idx+1; later < nops; later++)
+    {
+      DL_OP_T &op = ops[later];
+      bool clear = true;
+
+      if (op.op != DL_FILL || op.fg != ops[idx].fg)
+        continue;
+
+      for (int between=idx+1; between < later && clear; between++)
+      {
+        clear = (ops[between].op == DL_DROPPED) ||
+                rect_empty(rect_intersect(ops[between].rect, op.rect));
+      }
+
+      if (clear && rect_merge(ops[idx].rect, op.rect))
+      {
+        op.op = DL_DROPPED;
+        later = idx;            // Look again, the fill has grown.
+      }
+    }
+  }
+}
+
+// Removes the dropped ops, then sorts the rest top to bottom and left to
+// right. An op is only moved in front of another if they don't overlap.
+void DisplayList::Sort()
+{
+  int count = 0;
+
+  for (int idx=0; idx < nops; idx++)
+  {
+    if (ops[idx].op != DL_DROPPED)
+    {
+      ops[count++] = ops[idx];
+    }
+  }
+  nops = count;
+
+  for (int idx=1; idx < nops; idx++)
+  {
+    DL_OP_T op = ops[idx];
+    int pos = idx;
+
+    while (pos > 0)
+    {
+      const RECT_T &prev = ops[pos-1].rect;
+
+      if (prev.y < op.rect.y || (prev.y == op.rect.y && prev.x <= op.rect.x))
+        break;
+      if (!rect_empty(rect_intersect(prev, op.rect)))
+        break;
+      ops[pos] = ops[pos-1];
+      pos--;
+    }
+    ops[pos] = op;
+  }
+}
+
+// Adds what an op just executed cost. Glyphs the glyph functions drew are
+// in their stats, otherwise they went through drawChar(), which sets one
+// window for each character drawn with a background.
+void DisplayList::Count(const DL_OP_T &op, const GLYPH_STATS_T &before)
+{
+  const RECT_T &r = op.rect;
+  GLYPH_STATS_T after;
+  uint32_t windows = 0;
+  uint32_t pixels = 0;
+
+  switch (op.op)
+  {
+    case DL_FILL:
+      windows = 1;
+      pixels = r.w * r.h;
+      break;
+    case DL_RECT:
+      windows = 4;
+      pixels = 2 * (r.w + r.h);
+      break;
+    case DL_GLYPH:
+    case DL_GLYPH_DELTA:
+      glyph_get_stats(&after, false);
+      if (after.windows != before.windows)
+      {
+        windows = after.windows - before.windows;
+        pixels = after.pixels - before.pixels;
+        break;
+      }
+      windows = 1;
+      pixels = r.w * r.h;
+      break;
+    case DL_STRING:
+      windows = strlen(op.str);
+      pixels = r.w * r.h;
+      break;
+    default:
+      break;
+  }
+
+  cost.executed++;
+  cost.windows += windows;
+  cost.pixels += pixels;
+  cost.bytes += (windows * DL_WINDOW_BYTES) + (pixels * 2);
+}
+
+void DisplayList::Execute()
+{
+  Hide();
+  MergeFills();
+  Sort();
+
+  for (int idx=0; idx < nops; idx++)
+  {
+    GLYPH_STATS_T before;
+
+    glyph_get_stats(&before, false);
+    backend->Execute(ops[idx]);
+    Count(ops[idx], before);
+  }
+  nops = 0;
+}
@@ -0,0 +1,346 @@
+#ifndef DISPLAY_LIST_
+#define DISPLAY_LIST_
+/*!
+ * \file
+ *
+ * \brief Display list the GUI components draw into.
+ *
+ * Instead of drawing on the display straight away, components record what
+ * they draw as a list of small ops - fills, rectangle outlines, glyphs and
+ * strings. When the outermost End() is reached the list is optimised and
+ * then executed by a DisplayBackend, normally the ILI9341 display.
+ *
+ * The optimiser:
+ *      - drops ops that a later fill or glyph completely draws over, and
+ *        trims fills a later fill or glyph covers the whole of one side of,
+ *      - trims a fill by its outline when a rectangle is drawn round it, as
+ *        Button does,
+ *      - merges fills of the same colour that line up,
+ *      - sorts the ops top to bottom, left to right, so consecutive address
+ *        windows are near each other. Ops that overlap are never reordered.
+ *
+ * NOTES:
+ *      - Strings aren't copied, they must stay valid until End().
+ *      - Strings and outlines aren't assumed to cover anything, so they never
+ *        hide an op.
+ *      - If the list fills up what there is so far is executed, so nothing
+ *        is lost, just less is optimised.
+ *      - In the host build the same lists are drawn on the framebuffer
+ *        stand-in for the ILI9341, and host/test_display.cpp checks that
+ *        an optimised list draws the same screen as its ops drawn one by
+ *        one. Another DisplayBackend can be set with setBackend().
+ *      - What each executed op cost on the SPI bus is counted, see
+ *        DisplayList::getCost(). Glyphs drawn by glyph_draw() and
+ *        glyph_draw_delta() are counted exactly, those drawn by drawChar()
+ *        and strings are estimated as one address window per character.
+ *        host/bench_display.cpp compares the estimate with what the host
+ *        display counts.
+ */
+
+#include <Adafruit_ILI9341_STM.h>   // STM32 DMA Hardware-specific library
+
+#include "Glyph.h"
+
+/*!
+ * \defgroup DL definitions
+ * \{
+ */
+#define DL_SIZE 48          /*!< Max ops in the display list. */
+#define DL_WINDOW_BYTES 11  /*!< SPI bytes to set an address window. */
+#define TFT_SPI_HZ (36000000UL) /*!< ILI9341 SPI clock, 72MHz / 2. */
+/*! \} */
+
+/*!
+ * \brief A rectangle on the screen.
+ */
+typedef struct _rect {
+  int x;        /*!< X co-ord of top left corner. */
+  int y;        /*!< Y co-ord of top left corner. */
+  int w;        /*!< Width. */
+  int h;        /*!< Height. */
+} RECT_T;
+
+/*!
+ * \brief Display list op codes.
+ */
+typedef enum _dl_op_code {
+  DL_FILL,              /*!< Filled rectangle. */
+  DL_RECT,              /*!< Rectangle outline. */
+  DL_GLYPH,             /*!< Single character, background included. */
+  DL_GLYPH_DELTA,       /*!< Change one character on the display to another. */
+  DL_STRING             /*!< String of characters. */
+} DL_OP_CODE_T;
+
+/*!
+ * \brief DL_OP_T struct for a display list op.
+ */
+typedef struct _dl_op {
+  RECT_T rect;          /*!< Area of the screen drawn. */
+  const char* str;      /*!< String, for #DL_STRING. */
+  uint16_t fg;          /*!< Foreground colour, or fill colour. */
+  uint16_t bg;          /*!< Background colour. */
+  uint8_t op;           /*!< Op code, one of #DL_OP_CODE_T. */
+  uint8_t font;         /*!< Font size for glyphs and strings. */
+  char c;               /*!< Glyph character. */
+  char from;            /*!< Glyph on the display, for #DL_GLYPH_DELTA. */
+} DL_OP_T;
+
+/*!
+ * \brief DL_COST_T struct for what the display lists cost on the SPI bus.
+ *
+ * An address window is the column, row and memory write commands, 
+ * #DL_WINDOW_BYTES bytes. Each pixel is 2 bytes.
+ */
+typedef struct _dl_cost {
+  uint32_t recorded;    /*!< Ops recorded. */
+  uint32_t executed;    /*!< Ops executed, after optimising. */
+  uint32_t windows;     /*!< Address windows set. */
+  uint32_t pixels;      /*!< Pixels written. */
+  uint32_t bytes;       /*!< Bytes sent on the SPI bus. */
+} DL_COST_T;
+
+/*!
+ * \brief Estimate the time the SPI bus was busy for some costs.
+ *
+ * Each byte takes 8 clocks. The time between bytes and DMA transfers, and
+ * drawing done directly on the display rather than through a display list,
+ * are not included.
+ *
+ * \param cost Costs read with DisplayList::getCost().
+ * \param clock_hz The SPI clock rate e.g. #TFT_SPI_HZ.
+ *
+ * \result Bus time in microseconds.
+ */
+uint32_t dl_bus_time_us(const DL_COST_T *cost, uint32_t clock_hz);
+
+/*!
+ * \brief Intersection of two rectangles.
+ *
+ * \result The intersection, which is empty if they don't overlap.
+ */
+RECT_T rect_intersect(const RECT_T &a, const RECT_T &b);
+
+/*!
+ * \brief Is a rectangle empty.
+ *
+ * \result True if the width or height is zero or less.
+ */
+bool rect_empty(const RECT_T &r);
+
+/*!
+ * \brief Is one rectangle entirely inside another.
+ *
+ * \result True if 'inner' is inside 'outer'.
+ */
+bool rect_contains(const RECT_T &outer, const RECT_T &inner);
+
+/*!
+ * \brief Subtract one rectangle from another.
+ *
+ * Splits 'a' less 'b' into up to 4 rectangles: the full width bands above
+ * and below 'b', then the parts to the left and right of it.
+ *
+ * \param a Rectangle to subtract from.
+ * \param b Rectangle to subtract.
+ * \param out Array of 4 rectangles for the result.
+ *
+ * \result Number of rectangles in 'out', 1 and 'a' if they don't overlap.
+ */
+int rect_subtract(const RECT_T &a, const RECT_T &b, RECT_T *out);
+
+/*!
+ * \brief Join two rectangles if together they make one.
+ *
+ * \param a Rectangle, replaced by the joined rectangle.
+ * \param b Rectangle to join to it.
+ *
+ * \result True if they were joined.
+ */
+bool rect_merge(RECT_T &a, const RECT_T &b);
+
+/*!
+ * \brief DisplayBackend class - executes display list ops.
+ */
+class DisplayBackend
+{
+public:
+  /*!
+   * \brief Execute a display list op.
+   *
+   * \param op The op to execute.
+   */
+  virtual void Execute(const DL_OP_T &op) = 0;
+};
+
+/*!
+ * \brief TftBackend class - executes display list ops on the ILI9341.
+ *
+ * Glyphs are drawn with glyph_draw() and glyph_draw_delta() where they can
+ * be, otherwise with drawChar().
+ */
+class TftBackend : public DisplayBackend
+{
+  Adafruit_ILI9341_STM* tft;
+public:
+  /*!
+   * \brief TftBackend constructor.
+   *
+   * \param screen Pointer to ILI9341 screen instance.
+   */
+  TftBackend(Adafruit_ILI9341_STM* screen = NULL);
+
+  /*!
+   * \brief Sets the ILI9341 screen instance.
+   *
+   * \param screen Pointer to ILI9341 screen instance.
+   */
+  void setScreen(Adafruit_ILI9341_STM* screen);
+
+  /*!
+   * \brief Execute a display list op on the screen.
+   *
+   * \param op The op to execute.
+   */
+  void Execute(const DL_OP_T &op);
+};
+
+/*!
+ * \brief DisplayList class.
+ *
+ * Records the drawing between Begin() and End(). Like the Compositor these
+ * nest, the list is only optimised and executed by the outermost End().
+ */
+class DisplayList
+{
+  DL_OP_T ops[DL_SIZE];
+  int nops;
+  int depth;
+  Adafruit_ILI9341_STM* tft;
+  TftBackend tft_backend;
+  DisplayBackend* backend;
+  DL_COST_T cost;
+
+  DL_OP_T* Add(int op, int x, int y, int w, int h);
+  void Count(const DL_OP_T &op, const GLYPH_STATS_T &before);
+  void Hide();
+  void MergeFills();
+  void Sort();
+  void Execute();
+public:
+  /*!
+   * \brief DisplayList constructor.
+   */
+  DisplayList();
+
+  /*!
+   * \brief Set the backend that executes the list.
+   *
+   * \param display_backend The backend, or NULL for the ILI9341 display.
+   */
+  void setBackend(DisplayBackend* display_backend);
+
+  /*!
+   * \brief Read what the executed lists cost on the SPI bus.
+   *
+   * \param cost_out Pointer to the DL_COST_T struct which will contain the
+   *        costs accumulated since they were last reset.
+   * \param reset True to reset the costs once they have been read.
+   */
+  void getCost(DL_COST_T *cost_out, bool reset);
+
+  /*!
+   * \brief Start recording, or nest inside the current recording.
+   *
+   * \param screen Pointer to ILI9341 screen instance drawn on.
+   */
+  void Begin(Adafruit_ILI9341_STM* screen);
+
+  /*!
+   * \brief End recording, optimising and executing the list if this is the
+   * outermost End().
+   */
+  void End();
+
+  /*!
+   * \brief Record a filled rectangle.
+   *
+   * \param x_pos X position of the top left corner.
+   * \param y_pos Y position of the top left corner.
+   * \param width Width of the rectangle.
+   * \param height Height of the rectangle.
+   * \param colour Colour to fill it with.
+   */
+  void Fill(int x_pos, int y_pos, int width, int height, int colour);
+
+  /*!
+   * \brief Record a rectangle outline.
+   *
+   * \param x_pos X position of the top left corner.
+   * \param y_pos Y position of the top left corner.
+   * \param width Width of the rectangle.
+   * \param height Height of the rectangle.
+   * \param colour Colour of the outline.
+   */
+  void Rect(int x_pos, int y_pos, int width, int height, int colour);
+
+  /*!
+   * \brief Record a character, drawn with its background.
+   *
+   * \param c Character to draw.
+   * \param x_pos X position of the top left corner.
+   * \param y_pos Y position of the top left corner.
+   * \param font_size Font size, only 2, 4, 6 and 7 are supported.
+   * \param fg Foreground colour.
+   * \param bg Background colour.
+   */
+  void Glyph(char c, int x_pos, int y_pos, int font_size, int fg, int bg);
+
+  /*!
+   * \brief Record changing a character on the display into another.
+   *
+   * \param from Character on the display.
+   * \param to Character to change it to.
+   * \param x_pos X position of the top left corner.
+   * \param y_pos Y position of the top left corner.
+   * \param font_size Font size, only 2, 4, 6 and 7 are supported.
+   * \param fg Foreground colour.
+   * \param bg Background colour.
+   */
+  void GlyphDelta(
+    char from,
+    char to,
+    int x_pos,
+    int y_pos,
+    int font_size,
+    int fg,
+    int bg
+    );
+
+  /*!
+   * \brief Record a string.
+   *
+   * \param str Null terminated string, not copied.
+   * \param x_pos X position of the top left corner, or the centre.
+   * \param y_pos Y position of the top of the string.
+   * \param font_size Font size, only 2, 4, 6 and 7 are supported.
+   * \param fg Foreground colour.
+   * \param bg Background colour.
+   * \param centred True to centre the string on x_pos.
+   */
+  void String(
+    const char* str,
+    int x_pos,
+    int y_pos,
+    int font_size,
+    int fg,
+    int bg,
+    bool centred = false
+    );
+};
+
+/*!
+ * \brief The display list instance.
+ */
+extern DisplayList displaylist;
+
+#endif // DISPLAY_LIST_
@@ -0,0 +1,87 @@
+#include "Epoch.h"
+
+// Cumulative days before the start of each month, for normal and leap
+// years. The 13th entry is the days in the year.
+static constexpr uint16_t cum_days[2][13] = {
+  { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
+  { 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 }
+};
+
+// Days from 2000-01-01 to the start of year 'y' (0..199 from 2000). Every
+// 4th year is a leap year, except 2100.
+static constexpr uint32_t days_before_year(uint32_t y)
+{
+  return (y * 365UL) + ((y + 3) / 4) - ((y > 100) ? 1 : 0);
+}
+
+static_assert(days_before_year(1) == 366, "2000 is a leap year");
+static_assert(days_before_year(101) - days_before_year(100) == 365,
+              "2100 is not a leap year");
+static_assert(cum_days[1][12] == 366, "Leap year days");
+
+bool is_leap_year(uint8_t year, uint8_t century)
+{
+  return ((year % 4) == 0) && (year || !century);
+}
+
+uint8_t days_in_month(uint8_t month, uint8_t year, uint8_t century)
+{
+  const uint16_t *cum = cum_days[is_leap_year(year, century)];
+
+  return (uint8_t)(cum[month] - cum[month-1]);
+}
+
+EPOCH_T tm_to_epoch(const TM_T *date_time)
+{
+  uint32_t year = date_time->tm_year + (date_time->tm_century ? 100 : 0);
+  bool leap = is_leap_year(date_time->tm_year, date_time->tm_century);
+  uint32_t days;
+
+  days = days_before_year(year) 
+       + cum_days[leap][date_time->tm_mon-1] 
+       + (date_time->tm_mday - 1);
+
+  return ((EPOCH_T)days * EPOCH_DAY) 
+       + (date_time->tm_hour * EPOCH_HOUR)
+       + (date_time->tm_min * EPOCH_MINUTE)
+       + date_time->tm_sec;
+}
+
+TM_T *epoch_to_tm(EPOCH_T epoch, TM_T *date_time)
+{
+  uint32_t days = (uint32_t)(epoch / EPOCH_DAY);
+  uint32_t secs = (uint32_t)(epoch % EPOCH_DAY);
+  uint32_t year = days / 365;   // At most 2 years too many.
+  const uint16_t *cum;
+  uint16_t day_of_year;
+  uint8_t month;
+
+  while (days_before_year(year) > days)
+  {
+    year--;
+  }
+  day_of_year = days - days_before_year(year);
+
+  date_time->tm_century = (year >= 100) ? 1 : 0;
+  date_time->tm_year = year % 100;
+  cum = cum_days[is_leap_year(date_time->tm_year, date_time->tm_century)];
+
+  // Months are at most 31 days, so this is at most 2 months early.
+  month = day_of_year / 32;
+  while (cum[month+1] <= day_of_year)
+  {
+    month++;
+  }
+  date_time->tm_mon = month + 1;
+  date_time->tm_mday = (day_of_year - cum[month]) + 1;
+
+  // 2000-01-01 was a Saturday. 1 (Monday) .. 7 (Sunday).
+  date_time->tm_wday = ((days + 5) % 7) + 1;
+
+  date_time->tm_hour = secs / EPOCH_HOUR;
+  secs %= EPOCH_HOUR;
+  date_time->tm_min = secs / EPOCH_MINUTE;
+  date_time->tm_sec = secs % EPOCH_MINUTE;
+
+  return date_time;
+}
@@ -0,0 +1,110 @@
+#ifndef EPOCH_
+#define EPOCH_
+/*!
+ * \file
+ *
+ * \brief Seconds since an epoch, for date and time arithmetic.
+ *
+ * Converting a TM_T into seconds since 2000-01-01 00:00:00 means adding
+ * to, or finding the difference between, dates and times is integer maths
+ * rather than carrying field by field. Conversions in both directions are
+ * O(1), using tables of the cumulative days before each month.
+ *
+ * Only the years 2000 to 2199 are supported, the range of the DS3231 with
+ * its Century bit. 2000 is a leap year, 2100 is not.
+ */
+
+#include <Arduino.h>
+
+#include "DS3231_RTC.h"
+
+/*!
+ * \brief Seconds since 2000-01-01 00:00:00.
+ *
+ * 200 years of seconds needs 33 bits, so this is 64-bit. Differences are
+ * 32-bit.
+ */
+typedef uint64_t EPOCH_T;
+
+/*!
+ * \defgroup EPOCH definitions
+ * \{
+ */
+#define EPOCH_MINUTE (60UL)                 /*!< Seconds in a minute. */
+#define EPOCH_HOUR (3600UL)                 /*!< Seconds in an hour. */
+#define EPOCH_DAY (86400UL)                 /*!< Seconds in a day. */
+#define EPOCH_WEEK (604800UL)               /*!< Seconds in a week. */
+/*! \} */
+
+/*!
+ * \brief Is the year a leap year.
+ *
+ * \param year Year in the century 0..99.
+ * \param century 0 (20xx) or 1 (21xx).
+ *
+ * \result True if it is a leap year.
+ */
+bool is_leap_year(uint8_t year, uint8_t century);
+
+/*!
+ * \brief Days in a month.
+ *
+ * \param month Month in year 1..12.
+ * \param year Year in the century 0..99.
+ * \param century 0 (20xx) or 1 (21xx).
+ *
+ * \result Days in the month, 28..31.
+ */
+uint8_t days_in_month(uint8_t month, uint8_t year, uint8_t century);
+
+/*!
+ * \brief Convert a date and time to seconds since the epoch.
+ *
+ * The day of week (tm_wday) is ignored.
+ *
+ * \param date_time Pointer to the TM_T struct to convert.
+ *
+ * \result Seconds since 2000-01-01 00:00:00.
+ */
+EPOCH_T tm_to_epoch(const TM_T *date_time);
+
+/*!
+ * \brief Convert seconds since the epoch to a date and time.
+ *
+ * Sets all the fields of the TM_T, including the day of week.
+ *
+ * \param epoch Seconds since 2000-01-01 00:00:00.
+ * \param date_time Pointer to the TM_T struct which will contain the date
+ *        and time.
+ *
+ * \result The pointer passed as a parameter is returned.
+ */
+TM_T *epoch_to_tm(EPOCH_T epoch, TM_T *date_time);
+
+/*!
+ * \brief Add seconds, which may be negative, to a time.
+ *
+ * \param epoch Seconds since the epoch.
+ * \param seconds Seconds to add.
+ *
+ * \result The new seconds since the epoch.
+ */
+inline EPOCH_T epoch_add(EPOCH_T epoch, int32_t seconds)
+{
+  return epoch + seconds;
+}
+
+/*!
+ * \brief Difference between two times.
+ *
+ * \param later Seconds since the epoch.
+ * \param earlier Seconds since the epoch.
+ *
+ * \result later - earlier in seconds. Must be within +/- 68 years.
+ */
+inline int32_t epoch_diff(EPOCH_T later, EPOCH_T earlier)
+{
+  return (int32_t)(later - earlier);
+}
+
+#endif // EPOCH_
@@ -1,5 +1,52 @@
 #include "GUI.h"
 
+Compositor compositor;
+HitMap hit_map;
+
+// Constant tables, shared by every instance and kept in flash.
+const uint8_t Component::font_width[8] = { 0, 0, 8, 0, 14, 0, 27, 34 };
+const uint8_t Component::font_height[8] = { 0, 0, 16, 0, 26, 0, 48, 48 };
+
+const char MonthString::month_str[12][10] = {
+  "January",
+  "February",
+  "March",
+  "April",
+  "May",
+  "June",
+  "July",
+  "August",
+  "September",
+  "October",
+  "November",
+  "December"
+};
+
+const char OrdinalString::ord_str[4][3] = {
+  "th",
+  "st",
+  "nd",
+  "rd"
+};
+
+const char WeekDay::day_str[7][10] = {
+  "Monday",
+  "Tuesday",
+  "Wednesday",
+  "Thursday",
+  "Friday",
+  "Saturday",
+  "Sunday"
+};
+
+// Width of a single character in a font, as drawn by drawChar.
+static int char_width(Adafruit_ILI9341_STM* tft, char c, int font)
+{
+  char str[2] = { c, '\0' };
+
+  return tft ? tft->textWidth(str, font) : 0;
+}
+
 /**
  * Component class methods - this is the base class.
  */
@@ -37,6 +84,18 @@ void Component::setPosition(int x_pos, int y_pos)
   y = y_pos;  
 }
 
+void Component::Invalidate()
+{
+  if (compositor.Batching())
+  {
+    compositor.Damage(this);
+  }
+  else
+  {
+    this->Draw();
+  }
+}
+
 /**
  * Digit class methods.
  */
@@ -48,7 +107,8 @@ Digit::Digit(
     int font_size,
     int initial_value
     )
-  : Component(screen, x_pos, y_pos), fntsz(font_size), val(initial_value)
+  : Component(screen, x_pos, y_pos), fntsz(font_size), val(initial_value),
+    drawn(-1)
   {
   }
 
@@ -56,11 +116,13 @@ Digit::Digit(): Component()
 {
   fntsz = 7;
   val = 0;
+  drawn = -1;
 }
 
 void Digit::setValue(int value)
 {
   val = value;
+  drawn = -1;
 }
 
 void Digit::Update(int value) 
@@ -68,24 +130,42 @@ void Digit::Update(int value)
   if (value != val)
   {
     val = value;
-    this->Draw();
+    this->Invalidate();
   }
 }
 
 void Digit::setFontSize(int font_size)
 {
   fntsz = font_size;
+  drawn = -1;
 }
 
 void Digit::Draw()
 {
   if (tft)
   {
-    tft->setTextColor(fgc, bgc);
-    tft->drawChar( char(0x30 + val), x, y, fntsz);
+    displaylist.Begin(tft);
+    // Change the digit on the display if there is one, else draw it all.
+    if (drawn >= 0 && drawn != val)
+    {
+      displaylist.GlyphDelta(char(0x30 + drawn), char(0x30 + val), x, y,
+                             fntsz, fgc, bgc);
+    }
+    else
+    {
+      displaylist.Glyph(char(0x30 + val), x, y, fntsz, fgc, bgc);
+    }
+    displaylist.End();
+    drawn = val;
   }
 }
 
+RECT_T Digit::Bounds()
+{
+  RECT_T r = { x, y, font_width[fntsz], font_height[fntsz] };
+  return r;
+}
+
 /**
  * Colon class - only displays a colon - static.
  */
@@ -108,11 +188,18 @@ void Colon::Draw()
 {
   if (tft) 
   {
-    tft->setTextColor(fgc, bgc);
-    tft->drawChar(':', x, y, fntsz);
+    displaylist.Begin(tft);
+    displaylist.Glyph(':', x, y, fntsz, fgc, bgc);
+    displaylist.End();
   }
 }
 
+RECT_T Colon::Bounds()
+{
+  RECT_T r = { x, y, char_width(tft, ':', fntsz), font_height[fntsz] };
+  return r;
+}
+
 /**
  * Fullstop class - only displays a fullstop - static.
  */
@@ -135,10 +222,17 @@ void Fullstop::Draw()
 {
   if (tft) 
   {
-    tft->setTextColor(fgc, bgc);
-    tft->drawChar('.', x, y, fntsz);
+    displaylist.Begin(tft);
+    displaylist.Glyph('.', x, y, fntsz, fgc, bgc);
+    displaylist.End();
   }
 }
+
+RECT_T Fullstop::Bounds()
+{
+  RECT_T r = { x, y, char_width(tft, '.', fntsz), font_height[fntsz] };
+  return r;
+}
   
 /**
  * Digit class methods.
@@ -176,7 +270,7 @@ void DoubleDigit::Update(int value)
   if (value != val)
   {
     val = value;
-    this->Draw();
+    this->Invalidate();
   }
 }
 
@@ -196,19 +290,27 @@ void DoubleDigit::Draw()
   {
     int tens = (val / 10);
      
-    tft->setTextColor(fgc, bgc);
+    displaylist.Begin(tft);
     if (lz || tens )
     {
-      tft->drawChar( char(0x30 + tens), x, y, fntsz);
+      displaylist.Glyph(char(0x30 + tens), x, y, fntsz, fgc, bgc);
     }
     else // Blank out the previous digit with a rectangle.
     {
-      tft->fillRect(x, y, font_width[fntsz], font_height[fntsz], bgc);
+      displaylist.Fill(x, y, font_width[fntsz], font_height[fntsz], bgc);
     }
-    tft->drawChar( char(0x30 + (val % 10)), x+font_width[fntsz], y, fntsz);
+    displaylist.Glyph(char(0x30 + (val % 10)), x+font_width[fntsz], y, fntsz,
+                      fgc, bgc);
+    displaylist.End();
   }
 }
 
+RECT_T DoubleDigit::Bounds()
+{
+  RECT_T r = { x, y, font_width[fntsz] * 2, font_height[fntsz] };
+  return r;
+}
+
 /** 
  *  Month String class.
  */
@@ -237,7 +339,7 @@ void MonthString::Update(int new_month)
   if (month != new_month)
   {
     month = new_month;
-    this->Draw();
+    this->Invalidate();
   }
 
 }
@@ -246,15 +348,22 @@ void MonthString::Draw()
 {
   if (tft)
   {
-    tft->setTextColor(fgc, bgc); 
+    displaylist.Begin(tft);
     // Draw a rectangle to clear the previous month displayed (if there was one).
     // Font size is 4 - width is 14, height is 28.
-    tft->fillRect(x, y, 140, 26, bgc);
+    displaylist.Fill(x, y, 140, 26, bgc);
     // Assume max string length is 140 (font 4 width = 14 * 10 char) - mid point is 70.
-    tft->drawCentreString( (char *)month_str[month], x+70, y, 4);
+    displaylist.String(month_str[month], x+70, y, 4, fgc, bgc, true);
+    displaylist.End();
   }
 }
 
+RECT_T MonthString::Bounds()
+{
+  RECT_T r = { x, y, 140, 26 };
+  return r;
+}
+
 /**
  * Ordinal string class
  * Displays a the string "st", "nd", "rd" or "th" depending on the 'day', up to 31.
@@ -285,7 +394,7 @@ void OrdinalString::Update(int new_day)
   if (day != new_day)
   {
     day = new_day;
-    this->Draw();
+    this->Invalidate();
   }
 }
 
@@ -299,7 +408,6 @@ void OrdinalString::Draw()
   if (tft)
   {
     int index = 0;
-    tft->setTextColor(fgc, bgc); 
 
     switch(day)
     {
@@ -316,11 +424,19 @@ void OrdinalString::Draw()
         break;
     }
     // Draw a blank box to erase what ever was there before.
-    tft->fillRect(x, y, (font_width[fntsz]*2)+2, font_height[fntsz], bgc);
-    tft->drawString((char *)ord_str[index], x, y, fntsz);    
+    displaylist.Begin(tft);
+    displaylist.Fill(x, y, (font_width[fntsz]*2)+2, font_height[fntsz], bgc);
+    displaylist.String(ord_str[index], x, y, fntsz, fgc, bgc);
+    displaylist.End();
   }
 }
 
+RECT_T OrdinalString::Bounds()
+{
+  RECT_T r = { x, y, (font_width[fntsz] * 2) + 2, font_height[fntsz] };
+  return r;
+}
+
 /**
  * WeekDay class - displays day of week as a string.
  */
@@ -348,7 +464,7 @@ void WeekDay::Update(int new_day)
   if (day != new_day)
   {
     day = new_day;
-    this->Draw();
+    this->Invalidate();
   }
 }
 
@@ -356,15 +472,22 @@ void WeekDay::Draw()
 {
   if (tft)
   {
-    tft->setTextColor(fgc, bgc); 
+    displaylist.Begin(tft);
     // Draw a rectangle to clear the previous month displayed (if there was one).
     // Font size is 4 - width is 14, height is 26.
-    tft->fillRect(x, y, 140, 26, bgc);
+    displaylist.Fill(x, y, 140, 26, bgc);
     // Assume max string length is 140 (font 4 width = 10 * 10 + fudge - mid point is 70.
-    tft->drawCentreString( (char *)day_str[day], x+70, y, 4);
+    displaylist.String(day_str[day], x+70, y, 4, fgc, bgc, true);
+    displaylist.End();
   }
 }
 
+RECT_T WeekDay::Bounds()
+{
+  RECT_T r = { x, y, 140, 26 };
+  return r;
+}
+
 /**
  * Button class - simple button box with text. Ensure box is bigger than text.
  */
@@ -411,7 +534,7 @@ void Button::Release()
     fgc ^= bgc;
     bgc ^= fgc;
     fgc ^= bgc;
-    this->Draw();  
+    this->Invalidate();
 }
 
 void Button::setFontSize(int font_size)
@@ -437,14 +560,365 @@ void Button::Draw()
     int half_width = x+(bttnw/2);
 
     // By default - Button colours are inverted.
-    tft->setTextColor(bgc, fgc);
-    tft->fillRect(x, y, bttnw, bttnh, fgc);
-    tft->drawRect(x, y, bttnw, bttnh, bgc);
-    tft->drawCentreString(
-      bttntxt, x+(bttnw/2), 
+    displaylist.Begin(tft);
+    displaylist.Fill(x, y, bttnw, bttnh, fgc);
+    displaylist.Rect(x, y, bttnw, bttnh, bgc);
+    displaylist.String(
+      bttntxt, half_width, 
       y+(bttnh/2)-(font_height[fntsz]/2),
-      fntsz
+      fntsz, bgc, fgc, true
       );
+    displaylist.End();
+  }
+}
+
+RECT_T Button::Area()
+{
+  // Press() includes the right and bottom edges.
+  RECT_T r = { x, y, bttnw + 1, bttnh + 1 };
+  return r;
+}
+
+RECT_T Button::Bounds()
+{
+  RECT_T r = { x, y, bttnw, bttnh };
+
+  // Nothing is drawn without text.
+  if (!bttntxt)
+  {
+    r.w = 0;
+  }
+  return r;
+}
+
+/**
+ * Label class - a line of text.
+ */
+Label::Label(
+    Adafruit_ILI9341_STM* screen,
+    int x_pos,
+    int y_pos,
+    const char* text,
+    int font_size,
+    bool centred
+    )
+: Component(screen, x_pos, y_pos), fntsz(font_size), centre(centred)
+{
+  setText(text);
+}
+
+Label::Label() : Component()
+{
+  txt[0] = '\0';
+  fntsz = 4;
+  centre = false;
+}
+
+void Label::setText(const char* text)
+{
+  strncpy(txt, text, GUI_LABEL_LEN - 1);
+  txt[GUI_LABEL_LEN - 1] = '\0';
+}
+
+void Label::Update(const char* text)
+{
+  if (strncmp(txt, text, GUI_LABEL_LEN - 1))
+  {
+    setText(text);
+    this->Invalidate();
+  }
+}
+
+void Label::setFontSize(int font_size)
+{
+  fntsz = font_size;
+}
+
+void Label::setCentred(bool centred)
+{
+  centre = centred;
+}
+
+void Label::Draw()
+{
+  if (tft)
+  {
+    displaylist.Begin(tft);
+    displaylist.String(txt, x, y, fntsz, fgc, bgc, centre);
+    displaylist.End();
   }
 }
 
+RECT_T Label::Bounds()
+{
+  RECT_T r = { x, y, 0, font_height[fntsz] };
+
+  if (tft)
+  {
+    r.w = tft->textWidth(txt, fntsz);
+    if (centre)
+    {
+      r.x -= r.w / 2;
+    }
+  }
+  return r;
+}
+
+/**
+ * Compositor class - batches component drawing.
+ */
+Compositor::Compositor()
+: tft(NULL), depth(0), ndamage(0), nfill(0)
+{ }
+
+void Compositor::Begin()
+{
+  depth++;
+}
+
+bool Compositor::Batching()
+{
+  return depth > 0;
+}
+
+void Compositor::Fill(
+    Adafruit_ILI9341_STM* screen,
+    int x_pos,
+    int y_pos,
+    int width,
+    int height,
+    int colour
+    )
+{
+  RECT_T rect = { x_pos, y_pos, width, height };
+
+  if (!depth)
+  {
+    displaylist.Begin(screen);
+    displaylist.Fill(x_pos, y_pos, width, height, colour);
+    displaylist.End();
+    return;
+  }
+
+  // Fills are drawn before the components, so draw the fills so far rather
+  // than lose this one. The components are kept for the flush, so neither
+  // this fill nor any later one can cover them.
+  if (nfill == GUI_FILL_SIZE)
+  {
+    displaylist.Begin(tft);
+    EmitFills();
+    displaylist.End();
+  }
+
+  // Drop it if the last fill already covers it in the same colour.
+  if (nfill && fills[nfill-1].colour == colour &&
+      rect_contains(fills[nfill-1].rect, rect))
+  {
+    return;
+  }
+
+  tft = screen;
+  fills[nfill].rect = rect;
+  fills[nfill].colour = colour;
+  nfill++;
+}
+
+void Compositor::Damage(Component* comp)
+{
+  for (int idx=0; idx < ndamage; idx++)
+  {
+    if (damage[idx] == comp)
+    {
+      return;
+    }
+  }
+
+  if (ndamage == GUI_DAMAGE_SIZE)
+  {
+    Emit();
+  }
+  damage[ndamage++] = comp;
+}
+
+void Compositor::Flush()
+{
+  if (depth && --depth == 0)
+  {
+    Emit();
+  }
+}
+
+// Joins up pieces that line up, until none do. Returns the new count.
+static int merge_pieces(RECT_T *pieces, int npieces)
+{
+  for (bool merged = true; merged; )
+  {
+    merged = false;
+    for (int a=0; a < npieces; a++)
+    {
+      for (int b=a+1; b < npieces; b++)
+      {
+        if (rect_merge(pieces[a], pieces[b]))
+        {
+          pieces[b--] = pieces[--npieces];
+          merged = true;
+        }
+      }
+    }
+  }
+  return npieces;
+}
+
+// Fills 'rect' less the bounds of every damaged component, as they will draw
+// over it anyway. If there are too many pieces the rest are filled whole.
+void Compositor::FillPieces(RECT_T rect, int colour)
+{
+  RECT_T pieces[GUI_PIECE_SIZE];
+  RECT_T split[4];
+  int npieces = 1;
+
+  pieces[0] = rect;
+  for (int comp=0; comp < ndamage; comp++)
+  {
+    RECT_T bounds = damage[comp]->Bounds();
+
+    if (rect_empty(bounds))
+      continue;
+
+    for (int idx=npieces-1; idx >= 0; idx--)
+    {
+      int n = rect_subtract(pieces[idx], bounds, split);
+
+      if (n == 1 && split[0].w == pieces[idx].w && split[0].h == pieces[idx].h)
+        continue;                       // Not overlapped.
+      if (npieces - 1 + n > GUI_PIECE_SIZE)
+        continue;                       // No room, keep it whole.
+
+      // Replace the piece with what's left of it.
+      pieces[idx] = pieces[--npieces];
+      for (int s=0; s < n; s++)
+      {
+        pieces[npieces++] = split[s];
+      }
+    }
+    npieces = merge_pieces(pieces, npieces);
+  }
+
+  for (int idx=0; idx < npieces; idx++)
+  {
+    displaylist.Fill(pieces[idx].x, pieces[idx].y,
+                     pieces[idx].w, pieces[idx].h, colour);
+  }
+}
+
+// Records the fills, less the bounds of the components damaged so far.
+void Compositor::EmitFills()
+{
+  if (tft)
+  {
+    RECT_T screen = { 0, 0, tft->width(), tft->height() };
+
+    for (int idx=0; idx < nfill; idx++)
+    {
+      RECT_T rect = rect_intersect(fills[idx].rect, screen);
+
+      if (!rect_empty(rect))
+      {
+        FillPieces(rect, fills[idx].colour);
+      }
+    }
+  }
+  nfill = 0;
+}
+
+void Compositor::Emit()
+{
+  // Record the whole batch as one display list.
+  displaylist.Begin(tft);
+  EmitFills();
+  for (int idx=0; idx < ndamage; idx++)
+  {
+    damage[idx]->Draw();
+  }
+  displaylist.End();
+  ndamage = 0;
+}
+
+/**
+ * HitMap class - coarse grid for finding the button touched.
+ */
+HitMap::HitMap()
+{
+  Clear();
+}
+
+void HitMap::Clear()
+{
+  memset(cells, HIT_NONE, sizeof(cells));
+  count = 0;
+}
+
+uint8_t HitMap::Add(Button& button)
+{
+  RECT_T area = button.Area();
+  int left = max(area.x, 0);
+  int top = max(area.y, 0);
+  int right = min(area.x + area.w, HIT_COLS * HIT_CELL);
+  int bottom = min(area.y + area.h, HIT_ROWS * HIT_CELL);
+
+  if (count == HIT_MAX)
+    return HIT_NONE;
+
+  // Every cell the area overlaps.
+  for (int row=top / HIT_CELL; top < bottom && row <= (bottom-1) / HIT_CELL;
+       row++)
+  {
+    for (int col=left / HIT_CELL; left < right && col <= (right-1) / HIT_CELL;
+         col++)
+    {
+      uint8_t* cell = cells[row][col];
+
+      if (cell[0] == HIT_NONE)
+      {
+        cell[0] = count;
+      }
+      else if (cell[1] == HIT_NONE)
+      {
+        cell[1] = count;
+      }
+      else
+      {
+        cell[1] = HIT_SHARED;
+      }
+    }
+  }
+  buttons[count] = &button;
+  return count++;
+}
+
+uint8_t HitMap::Press(int x_pos, int y_pos)
+{
+  uint8_t* cell;
+
+  if (x_pos < 0 || x_pos >= HIT_COLS * HIT_CELL ||
+      y_pos < 0 || y_pos >= HIT_ROWS * HIT_CELL)
+    return HIT_NONE;
+
+  cell = cells[y_pos / HIT_CELL][x_pos / HIT_CELL];
+  for (int slot=0; slot < 2 && cell[slot] != HIT_NONE; slot++)
+  {
+    if (cell[slot] == HIT_SHARED)
+    {
+      for (uint8_t id=0; id < count; id++)
+      {
+        if (buttons[id]->Press(x_pos, y_pos))
+          return id;
+      }
+    }
+    else if (buttons[cell[slot]]->Press(x_pos, y_pos))
+    {
+      return cell[slot];
+    }
+  }
+  return HIT_NONE;
+}
@@ -8,11 +8,15 @@
  *
  * - It assumes the display is 320 by 240 pixels.
  * - There is little validation, to save code space.
+ * - Components draw into the display list (see DisplayList.h), which is
+ *   executed at the end of Draw() or of the Compositor flush.
  */
 
 #include <Adafruit_GFX_AS.h>        // Core graphics library, with extra fonts.
 #include <Adafruit_ILI9341_STM.h>   // STM32 DMA Hardware-specific library
 
+#include "DisplayList.h"
+
 /*!
  * \defgroup font_defines Font size definitions.
  *
@@ -32,6 +36,28 @@
 #define FS6_H 48    /*!< Font size 6 full stop height. */
 /*! \} */
 
+/*!
+ * \defgroup compositor_defines Compositor sizes.
+ * \{
+ */
+#define GUI_DAMAGE_SIZE 32  /*!< Max components damaged in one batch. */
+#define GUI_FILL_SIZE 8     /*!< Max background fills in one batch. */
+#define GUI_PIECE_SIZE 32   /*!< Max pieces a background fill is split into. */
+#define GUI_LABEL_LEN 16    /*!< Max Label text length, including the NUL. */
+/*! \} */
+
+/*!
+ * \defgroup hit_map_defines Hit map sizes.
+ * \{
+ */
+#define HIT_CELL 16         /*!< Hit map cell size in pixels. */
+#define HIT_COLS (320 / HIT_CELL)   /*!< Cells across the screen. */
+#define HIT_ROWS (240 / HIT_CELL)   /*!< Cells down the screen. */
+#define HIT_MAX 32          /*!< Max buttons in the hit map. */
+#define HIT_NONE 0xFF       /*!< No button. */
+#define HIT_SHARED 0xFE     /*!< More than two buttons, try them all. */
+/*! \} */
+
 /*!
  * Component GUI base class which provides a common interface and constant
  * defines for font widths. 
@@ -39,15 +65,15 @@
 class Component {
 protected:
   Adafruit_ILI9341_STM* tft;    /*!< Pointer to ILI9341 display class. */
-  int x;                        /*!< X co-ord of top left corner. */
-  int y;                        /*!< Y co-ord of top left corner. */
-  int fgc;                      /*!< Forground colour. */
-  int bgc;                      /*!< Background colour. */
+  int16_t x;                    /*!< X co-ord of top left corner. */
+  int16_t y;                    /*!< Y co-ord of top left corner. */
+  uint16_t fgc;                 /*!< Forground colour, RGB565. */
+  uint16_t bgc;                 /*!< Background colour, RGB565. */
 
   /*! Font widths - only font size 2, 4, 6 and 7 are valid - others are zero.*/
-  const int font_width[8] = { 0, 0, 8, 0, 14, 0, 27, 34 };
+  static const uint8_t font_width[8];
   /*! Font heights - only font size 2, 4, 6 and 7 are valid. */
-  const int font_height[8] = { 0, 0, 16, 0, 26, 0, 48, 48 };
+  static const uint8_t font_height[8];
 
 public: 
   /*!
@@ -68,6 +94,21 @@ public:
    * \brief Draws the graphics component on the display.
    */
   virtual void Draw() = 0;
+
+  /*!
+   * \brief The area of the screen the component covers when drawn.
+   *
+   * Every pixel in it is drawn, so nothing behind it needs to be drawn first.
+   */
+  virtual RECT_T Bounds() = 0;
+
+  /*!
+   * \brief Marks the component as needing to be drawn.
+   *
+   * Between Compositor::Begin() and Compositor::Flush() the component is
+   * drawn once by the flush, otherwise it is drawn straight away.
+   */
+  void Invalidate();
   
   /*!
    * \brief Sets the ILI9341 screen instance.
@@ -105,8 +146,9 @@ public:
  * digits too.
  */
 class Digit : public Component { 
-  int val;
-  int fntsz;
+  int8_t val;
+  uint8_t fntsz;
+  int8_t drawn; // Value on the display, or -1 if not known.
 public:
   /*! 
    * Digit class constructor.
@@ -134,7 +176,7 @@ public:
   Digit();
 
   /*! 
-   * Set the value of the digit. 
+   * Set the value of the digit. The next Draw() draws it in full.
    *
    * \param value Value to set the digit to in the range 0 to 9.
    */
@@ -142,7 +184,8 @@ public:
 
   /*! 
    * Draw the digit but only if the value passed is different than the current
-   * value.
+   * value. Only the pixels that differ from the digit on the display are
+   * drawn, where the font allows (see glyph_draw_delta).
    *
    * \param value New digit value in range 0 to 9.
    */
@@ -159,6 +202,11 @@ public:
    * Draw the digit on the screen.
    */
   void Draw();
+
+  /*!
+   * \brief The area of the screen drawn by Draw().
+   */
+  RECT_T Bounds();
 };
 
 /*!
@@ -167,7 +215,7 @@ public:
  * Literally only draws a colon ':'.
  */
 class Colon : public Component {
-  int fntsz;
+  uint8_t fntsz;
 public:
   /*! 
    * Colon class constructor.
@@ -201,14 +249,19 @@ public:
   /*! 
    * Draw the colon on the screen.
    */
-  void Draw();       
+  void Draw();
+
+  /*!
+   * \brief The area of the screen drawn by Draw().
+   */
+  RECT_T Bounds();       
 };
 
 /*!
  * \brief Fullstop class - literally just draws a full stop.
  */
 class Fullstop : public Component {
-  int fntsz;
+  uint8_t fntsz;
 public:
   /*! 
    * Fullstop class constructor.
@@ -242,7 +295,12 @@ public:
   /*! 
    * Draw the fullstop on the screen.
    */
-  void Draw();       
+  void Draw();
+
+  /*!
+   * \brief The area of the screen drawn by Draw().
+   */
+  RECT_T Bounds();       
 };
 
 /*!
@@ -252,8 +310,8 @@ public:
  * 0 or a space if the value is in the range 0 to 9.
  */
 class DoubleDigit : public Component {
-  int val;
-  int fntsz;
+  int8_t val;
+  uint8_t fntsz;
   bool lz;
 
 public:
@@ -320,6 +378,11 @@ public:
    * Draw the DoubleDigit on the screen.
    */
   void Draw();
+
+  /*!
+   * \brief The area of the screen drawn by Draw().
+   */
+  RECT_T Bounds();
 };
 
 /*!
@@ -329,21 +392,8 @@ public:
  * in the range 0 (January) through to 11 (December).
  */
 class MonthString: public Component {
-  int month;
-  const char month_str[12][12] = {
-    "January",
-    "February",
-    "March",
-    "April",
-    "May",
-    "June",
-    "July",
-    "August",
-    "September",
-    "October",
-    "November",
-    "December"
-  };
+  uint8_t month;
+  static const char month_str[12][10];
 
 public:
   /*!
@@ -392,6 +442,11 @@ public:
    * \brief Display the month string on the screen.
    */
   void Draw();
+
+  /*!
+   * \brief The area of the screen drawn by Draw().
+   */
+  RECT_T Bounds();
 };
 
 /*!
@@ -406,14 +461,9 @@ public:
  */
 class OrdinalString : public Component
 {
-  int day;
-  int fntsz;
-  const char ord_str[4][3] = {
-    "th",
-    "st",
-    "nd",
-    "rd"
-  };
+  uint8_t day;
+  uint8_t fntsz;
+  static const char ord_str[4][3];
 
 public:
    /*!
@@ -467,6 +517,11 @@ public:
    * \Brief Draw the ordinal string on the screen.
    */
   void Draw();
+
+  /*!
+   * \brief The area of the screen drawn by Draw().
+   */
+  RECT_T Bounds();
 };
 
 /*!
@@ -474,16 +529,8 @@ public:
  */
 class WeekDay : public Component
 {
-  int day;
-  const char day_str[7][10] = {
-    "Monday",
-    "Tuesday",
-    "Wednesday",
-    "Thursday",
-    "Friday",
-    "Saturday",
-    "Sunday"
-  };
+  uint8_t day;
+  static const char day_str[7][10];
 public:
   /*!
    * \brief
@@ -528,8 +575,33 @@ public:
    * \brief Draw the day of week string on the screen.
    */
   void Draw();
+
+  /*!
+   * \brief The area of the screen drawn by Draw().
+   */
+  RECT_T Bounds();
 };
 
+/*!
+ * \brief UI event types.
+ */
+typedef enum _ui_event_type {
+  UI_TICK,              /*!< Nothing is touching the screen. */
+  UI_TOUCH              /*!< The screen is being touched. */
+} UI_EVENT_TYPE_T;
+
+/*!
+ * \brief UI_EVENT_T struct for one poll of the touch screen.
+ *
+ * Screens that take events are passed them rather than reading the touch
+ * screen themselves, so they never wait for the user.
+ */
+typedef struct _ui_event {
+  uint8_t type;         /*!< One of #UI_EVENT_TYPE_T. */
+  uint16_t x;           /*!< X co-ord of the touch, for #UI_TOUCH. */
+  uint16_t y;           /*!< Y co-ord of the touch, for #UI_TOUCH. */
+} UI_EVENT_T;
+
 /*!
  * \brief Button class.
  *
@@ -541,10 +613,10 @@ public:
  */
 class Button: public Component 
 {
-  int fntsz;
+  uint8_t fntsz;
   char* bttntxt;
-  int bttnw;
-  int bttnh;
+  int16_t bttnw;
+  int16_t bttnh;
 public:
 
   /*!
@@ -620,7 +692,364 @@ public:
    * Draw the Button box and text to the screen.
    */
   void Draw();
+
+  /*!
+   * \brief The area of the screen drawn by Draw().
+   */
+  RECT_T Bounds();
+
+  /*!
+   * \brief The area of the screen Press() responds to, text or not.
+   */
+  RECT_T Area();
 };
 
+/*!
+ * \brief Label class.
+ *
+ * Draws a line of text, either from its top left corner or centred on its X
+ * position. The text is copied, so it can be built on the stack.
+ */
+class Label : public Component
+{
+  char txt[GUI_LABEL_LEN];
+  uint8_t fntsz;
+  bool centre;
+public:
+  /*!
+   * \brief Label constructor.
+   *
+   * \param screen Pointer to ILI9341 screen instance.
+   * \param x_pos X position of the top left corner, or the centre of the text.
+   * \param y_pos Y position of the top of the text.
+   * \param text Null terminated char string to be displayed.
+   * \param font_size Font size to use, only 2, 4, 6 and 7 are supported.
+   *        defaults to font size 4.
+   * \param centred True to centre the text on x_pos.
+   */
+  Label(
+    Adafruit_ILI9341_STM* screen,
+    int x_pos,
+    int y_pos,
+    const char* text,
+    int font_size = 4,
+    bool centred = false
+    );
+
+  /*!
+   * \brief Default Label constructor.
+   *
+   * Empty text in font size 4, not centred.
+   */
+  Label();
+
+  /*!
+   * \brief Set the text to be displayed.
+   *
+   * \param text Null terminated char string, truncated to fit.
+   */
+  void setText(const char* text);
+
+  /*!
+   * \brief Display the text but only if it is different than the current text.
+   *
+   * \param text Null terminated char string, truncated to fit.
+   */
+  void Update(const char* text);
+
+  /*!
+   * \brief Set the font size.
+   *
+   * \param font_size The new font size, valid font sizes are 2, 4, 6 and 7.
+   */
+  void setFontSize(int font_size);
+
+  /*!
+   * \brief Centre the text on the X position, or draw it from there.
+   *
+   * \param centred True to centre the text.
+   */
+  void setCentred(bool centred);
+
+  /*!
+   * \brief Draw the text on the screen.
+   */
+  void Draw();
+
+  /*!
+   * \brief The area of the screen drawn by Draw().
+   */
+  RECT_T Bounds();
+};
+
+/*!
+ * \defgroup compose_helpers Compile time composition.
+ *
+ * Helpers for widgets built from a fixed set of components. The components
+ * are passed as a parameter pack, so each call unrolls at compile time into
+ * direct calls on the concrete component types, rather than a loop over a
+ * table of Component pointers kept in RAM.
+ * \{
+ */
+
+/*!
+ * \brief Set the screen of each component.
+ *
+ * \param screen Pointer to ILI9341 screen instance.
+ * \param first, rest The components.
+ */
+inline void set_screen_all(Adafruit_ILI9341_STM*) { }
+
+template <class First, class... Rest>
+inline void set_screen_all(
+  Adafruit_ILI9341_STM* screen,
+  First& first,
+  Rest&... rest
+  )
+{
+  first.setScreen(screen);
+  set_screen_all(screen, rest...);
+}
+
+/*!
+ * \brief Invalidate each component, see Component::Invalidate().
+ *
+ * \param first, rest The components.
+ */
+inline void invalidate_all() { }
+
+template <class First, class... Rest>
+inline void invalidate_all(First& first, Rest&... rest)
+{
+  first.Invalidate();
+  invalidate_all(rest...);
+}
+
+/*!
+ * \brief Draw each component.
+ *
+ * \param first, rest The components.
+ */
+inline void draw_all() { }
+
+template <class First, class... Rest>
+inline void draw_all(First& first, Rest&... rest)
+{
+  first.Draw();
+  draw_all(rest...);
+}
+
+/*!
+ * \brief Row layout.
+ *
+ * The width each component takes up in the row is a template argument, so
+ * place() positions the components at offsets worked out at compile time.
+ * e.g. Row<DGT_W, DGT_W, CLN_W>::place(x, y, tens, units, colon).
+ */
+template <int... Widths> struct Row;
+
+template <> struct Row<>
+{
+  static const int width = 0;       /*!< Total width of the row. */
+
+  static void place(int, int) { }
+};
+
+template <int Width, int... Rest> struct Row<Width, Rest...>
+{
+  static const int width = Width + Row<Rest...>::width; /*!< Total width. */
+
+  /*!
+   * \brief Position the components along the row.
+   *
+   * \param x_pos X position of the left of the row.
+   * \param y_pos Y position of the top of the row.
+   * \param first, comps The components, one for each width.
+   */
+  template <class First, class... Comps>
+  static void place(int x_pos, int y_pos, First& first, Comps&... comps)
+  {
+    static_assert(sizeof...(Comps) == sizeof...(Rest),
+                  "Row needs one width per component");
+    first.setPosition(x_pos, y_pos);
+    Row<Rest...>::place(x_pos + Width, y_pos, comps...);
+  }
+};
+/*! \} */
+
+/*!
+ * \brief Compositor class.
+ *
+ * Batches the drawing of components so that each is drawn once, however many
+ * times it is invalidated, and background fills only cover the parts of the
+ * screen the components don't. Batches nest, only the outermost Flush()
+ * draws, so a widget can batch its own drawing and still be part of a
+ * bigger redraw.
+ *
+ * A flush first draws the background fills, less the bounds of the damaged
+ * components and with any fill already covered by the one before it
+ * dropped. The remaining pieces are merged where they line up, then the
+ * damaged components are drawn in the order they were first invalidated.
+ * If there are more than #GUI_FILL_SIZE fills, the fills so far are drawn
+ * early and the components still wait for the flush.
+ */
+class Compositor
+{
+  Adafruit_ILI9341_STM* tft;
+  int depth;
+  int ndamage;
+  int nfill;
+  Component* damage[GUI_DAMAGE_SIZE];
+  struct {
+    RECT_T rect;
+    int colour;
+  } fills[GUI_FILL_SIZE];
+
+  void FillPieces(RECT_T rect, int colour);
+  void EmitFills();
+  void Emit();
+public:
+  /*!
+   * \brief Compositor constructor.
+   */
+  Compositor();
+
+  /*!
+   * \brief Start a batch, or nest one inside the current batch.
+   */
+  void Begin();
+
+  /*!
+   * \brief Is a batch in progress.
+   *
+   * \returns True between Begin() and the outermost Flush().
+   */
+  bool Batching();
+
+  /*!
+   * \brief Fill a rectangle behind the components drawn in this batch.
+   *
+   * Outside a batch the rectangle is filled straight away.
+   *
+   * \param screen Pointer to ILI9341 screen instance.
+   * \param x_pos X position of the top left corner.
+   * \param y_pos Y position of the top left corner.
+   * \param width Width of the rectangle.
+   * \param height Height of the rectangle.
+   * \param colour Colour to fill it with.
+   */
+  void Fill(
+    Adafruit_ILI9341_STM* screen,
+    int x_pos,
+    int y_pos,
+    int width,
+    int height,
+    int colour
+    );
+
+  /*!
+   * \brief Add a component to be drawn by the flush.
+   *
+   * Used by Component::Invalidate(), a component is only added once.
+   *
+   * \param comp The component to draw.
+   */
+  void Damage(Component* comp);
+
+  /*!
+   * \brief End a batch, drawing it if this is the outermost one.
+   */
+  void Flush();
+};
+
+/*!
+ * \brief The compositor instance.
+ */
+extern Compositor compositor;
+
+/*!
+ * \brief A button and the method that handles it being pressed.
+ *
+ * A screen keeps a constant table of these, the index of the button in the
+ * table is its id in the HitMap and is passed to the handler.
+ */
+template <class Owner>
+struct Control
+{
+  Button Owner::*button;              /*!< The button. */
+  bool (Owner::*handler)(uint8_t id); /*!< Returns False to close the screen. */
+};
+
+/*!
+ * \brief HitMap class.
+ *
+ * A coarse grid over the screen mapping each cell to the buttons that
+ * overlap it, so a touch is resolved with one lookup however many buttons
+ * the screen has. A cell holds up to two buttons, which are pressed in the
+ * order they were added, each checking its exact area. A cell more than two
+ * buttons overlap tries them all, which only happens where buttons are
+ * closer than a cell apart both ways.
+ *
+ * Only one screen is touched at a time, so they share the one instance and
+ * build it when they are displayed.
+ */
+class HitMap
+{
+  uint8_t cells[HIT_ROWS][HIT_COLS][2];
+  Button* buttons[HIT_MAX];
+  uint8_t count;
+public:
+  /*!
+   * \brief HitMap constructor, the map is empty.
+   */
+  HitMap();
+
+  /*!
+   * \brief Remove all the buttons.
+   */
+  void Clear();
+
+  /*!
+   * \brief Add a button, where it is now.
+   *
+   * \param button The button, which mustn't overlap one already added.
+   *
+   * \returns The button's id, or #HIT_NONE if the map is full.
+   */
+  uint8_t Add(Button& button);
+
+  /*!
+   * \brief Build the map from a screen's Control table.
+   *
+   * \param owner The screen.
+   * \param controls The Control table, the ids are the indexes in it.
+   * \param num_controls The number of controls.
+   */
+  template <class Owner>
+  void Build(Owner* owner, const Control<Owner>* controls, uint8_t num_controls)
+  {
+    Clear();
+    for (uint8_t idx=0; idx < num_controls; idx++)
+    {
+      Add(owner->*controls[idx].button);
+    }
+  }
+
+  /*!
+   * \brief Press the button at a position, see Button::Press().
+   *
+   * \param x_pos X position co-ordinate.
+   * \param y_pos Y position co-ordinate.
+   *
+   * \returns The id of the button pressed, or #HIT_NONE if none were.
+   */
+  uint8_t Press(int x_pos, int y_pos);
+};
+
+/*!
+ * \brief The hit map instance, shared by the screens.
+ */
+extern HitMap hit_map;
+
 #endif // DIGITAL_CLOCK_GUI
 
@@ -0,0 +1,228 @@
+#include "Gesture.h"
+
+// Has 'time' been reached, allowing for millis() wrapping.
+static bool reached(uint32_t now, uint32_t time)
+{
+  return (int32_t)(now - time) >= 0;
+}
+
+GestureRecogniser::GestureRecogniser()
+{
+  config.tap_ms = GESTURE_TAP_MS;
+  config.long_press_ms = GESTURE_LONG_PRESS_MS;
+  config.double_tap_ms = GESTURE_DOUBLE_TAP_MS;
+  config.slop_px = GESTURE_SLOP_PX;
+  config.swipe_px = GESTURE_SWIPE_PX;
+  config.swipe_ms = GESTURE_SWIPE_MS;
+  reset();
+}
+
+void GestureRecogniser::setConfig(const GESTURE_CONFIG_T *new_config)
+{
+  config = *new_config;
+  reset();
+}
+
+void GestureRecogniser::reset()
+{
+  down = false;
+  moved = false;
+  long_fired = false;
+  tap_pending = false;
+  queued = false;
+}
+
+bool GestureRecogniser::near(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+{
+  return abs((int32_t)x1 - x0) <= config.slop_px &&
+    abs((int32_t)y1 - y0) <= config.slop_px;
+}
+
+// Reports the pending tap, if there is one, ahead of the gesture just found,
+// which is kept for poll(). Returns whether there is a gesture to report.
+bool GestureRecogniser::tap_first(GESTURE_T *gesture, bool found,
+  uint32_t now_ms)
+{
+  if (!tap_pending)
+    return found;
+
+  tap_pending = false;
+  if (found)
+  {
+    queued = true;
+    queue = *gesture;
+    queue_ms = now_ms;
+  }
+  gesture->type = GESTURE_TAP;
+  gesture->x = tap_x;
+  gesture->y = tap_y;
+  return true;
+}
+
+bool GestureRecogniser::feed(const TOUCH_EVENT_T &event, GESTURE_T *gesture)
+{
+  int32_t dx, dy;
+  uint32_t held;
+
+  switch (event.type)
+  {
+    case TOUCH_PRESS:
+      down = true;
+      moved = false;
+      long_fired = false;
+      down_ms = event.ms;
+      down_x = event.x;
+      down_y = event.y;
+
+      // poll() wasn't called for the gesture kept behind a tap.
+      if (queued)
+      {
+        queued = false;
+        *gesture = queue;
+        return true;
+      }
+
+      // Too late to be the second tap, report the first one poll() missed.
+      if (tap_pending && reached(event.ms, tap_ms + config.double_tap_ms + 1))
+      {
+        tap_pending = false;
+        gesture->type = GESTURE_TAP;
+        gesture->x = tap_x;
+        gesture->y = tap_y;
+        return true;
+      }
+      return false;
+
+    case TOUCH_MOVE:
+      if (down && !near(down_x, down_y, event.x, event.y))
+      {
+        moved = true;
+      }
+      return false;
+
+    case TOUCH_RELEASE:
+      break;
+
+    default:
+      return false;
+  }
+
+  // Release, a release without a press means the press was dropped.
+  if (!down)
+    return false;
+  down = false;
+  if (long_fired)
+    return false;
+
+  dx = (int32_t)event.x - down_x;
+  dy = (int32_t)event.y - down_y;
+  held = event.ms - down_ms;
+  gesture->x = down_x;
+  gesture->y = down_y;
+
+  // Mostly horizontal and quick enough.
+  if (abs(dx) >= config.swipe_px && abs(dx) > 2 * abs(dy) &&
+    held <= config.swipe_ms)
+  {
+    gesture->type = dx < 0 ? GESTURE_SWIPE_LEFT : GESTURE_SWIPE_RIGHT;
+    return tap_first(gesture, true, event.ms);
+  }
+
+  // None of the rest can be the second tap either.
+  if (moved || !near(down_x, down_y, event.x, event.y))
+  {
+    return tap_first(gesture, false, event.ms);
+  }
+
+  // poll() wasn't called in time to see it while still touched.
+  if (held >= config.long_press_ms)
+  {
+    gesture->type = GESTURE_LONG_PRESS;
+    return tap_first(gesture, true, event.ms);
+  }
+
+  if (held > config.tap_ms)
+  {
+    return tap_first(gesture, false, event.ms);
+  }
+
+  if (config.double_tap_ms == 0)
+  {
+    gesture->type = GESTURE_TAP;
+    return true;
+  }
+
+  // A tap still pending is recent enough, the press would have reported it
+  // otherwise, so this is the second tap if it is in the same place.
+  if (tap_pending && near(tap_x, tap_y, down_x, down_y))
+  {
+    tap_pending = false;
+    gesture->type = GESTURE_DOUBLE_TAP;
+    return true;
+  }
+
+  // A tap somewhere else reports the previous one, then waits to see if it is
+  // the first of a double tap itself.
+  bool previous = tap_pending;
+
+  gesture->type = GESTURE_TAP;
+  gesture->x = tap_x;
+  gesture->y = tap_y;
+  tap_pending = true;
+  tap_ms = event.ms;
+  tap_x = down_x;
+  tap_y = down_y;
+  return previous;
+}
+
+bool GestureRecogniser::poll(uint32_t now_ms, GESTURE_T *gesture)
+{
+  if (queued)
+  {
+    queued = false;
+    *gesture = queue;
+    return true;
+  }
+
+  if (down && !moved && !long_fired &&
+    reached(now_ms, down_ms + config.long_press_ms))
+  {
+    long_fired = true;
+    gesture->type = GESTURE_LONG_PRESS;
+    gesture->x = down_x;
+    gesture->y = down_y;
+    return tap_first(gesture, true, now_ms);
+  }
+
+  // Not while touched, it may be the second tap.
+  if (tap_pending && !down &&
+    reached(now_ms, tap_ms + config.double_tap_ms + 1))
+  {
+    tap_pending = false;
+    gesture->type = GESTURE_TAP;
+    gesture->x = tap_x;
+    gesture->y = tap_y;
+    return true;
+  }
+  return false;
+}
+
+bool GestureRecogniser::due(uint32_t *due_ms)
+{
+  if (queued)
+  {
+    *due_ms = queue_ms;
+    return true;
+  }
+  if (down && !moved && !long_fired)
+  {
+    *due_ms = down_ms + config.long_press_ms;
+    return true;
+  }
+  if (tap_pending && !down)
+  {
+    *due_ms = tap_ms + config.double_tap_ms + 1;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,147 @@
+#ifndef GESTURE_
+#define GESTURE_
+/*!
+ * \file
+ *
+ * \brief Gesture recogniser over the touch event stream.
+ *
+ * Turns the press, move and release events from TouchInput.h into taps,
+ * double taps, long presses and horizontal swipes. The timing comes from
+ * the event timestamps, so it doesn't depend on how often the events are
+ * read.
+ *
+ * NOTES:
+ *      - A long press is recognised while the panel is still touched, by
+ *        poll(), so the UI can respond without waiting for the release.
+ *        The release that follows it is ignored.
+ *      - When double taps are enabled a tap is only reported by poll() once
+ *        the double tap time has passed without a second tap.
+ *      - A tap still waiting for a double tap is reported before a swipe
+ *        or long press that follows it. The swipe or long press is then
+ *        reported by the next poll().
+ *      - due() says when poll() next needs to be called.
+ */
+
+#include <Arduino.h>
+
+#include "TouchInput.h"
+
+/*!
+ * \defgroup GESTURE definitions
+ *
+ * Default thresholds, see GESTURE_CONFIG_T.
+ * \{
+ */
+#define GESTURE_TAP_MS (500)            /*!< Longest touch that is a tap. */
+#define GESTURE_LONG_PRESS_MS (1000)    /*!< Shortest long press. */
+#define GESTURE_DOUBLE_TAP_MS (300)     /*!< Longest gap in a double tap. */
+#define GESTURE_SLOP_PX (12)            /*!< Movement allowed in a tap. */
+#define GESTURE_SWIPE_PX (60)           /*!< Shortest swipe. */
+#define GESTURE_SWIPE_MS (600)          /*!< Longest swipe. */
+/*! \} */
+
+/*!
+ * \brief Gesture types.
+ */
+typedef enum _gesture_type {
+  GESTURE_TAP,          /*!< Short touch that didn't move. */
+  GESTURE_DOUBLE_TAP,   /*!< Two taps close together. */
+  GESTURE_LONG_PRESS,   /*!< Long touch that didn't move. */
+  GESTURE_SWIPE_LEFT,   /*!< Quick horizontal movement to the left. */
+  GESTURE_SWIPE_RIGHT   /*!< Quick horizontal movement to the right. */
+} GESTURE_TYPE_T;
+
+/*!
+ * \brief GESTURE_T struct for a recognised gesture.
+ */
+typedef struct _gesture {
+  uint8_t type;         /*!< One of #GESTURE_TYPE_T. */
+  uint16_t x;           /*!< X co-ord the touch started at. */
+  uint16_t y;           /*!< Y co-ord the touch started at. */
+} GESTURE_T;
+
+/*!
+ * \brief GESTURE_CONFIG_T struct for the gesture thresholds.
+ */
+typedef struct _gesture_config {
+  uint16_t tap_ms;          /*!< Longest touch that is a tap. */
+  uint16_t long_press_ms;   /*!< Shortest long press. */
+  uint16_t double_tap_ms;   /*!< Longest gap in a double tap, 0 disables. */
+  uint16_t slop_px;         /*!< Movement allowed in a tap or long press. */
+  uint16_t swipe_px;        /*!< Shortest horizontal movement of a swipe. */
+  uint16_t swipe_ms;        /*!< Longest swipe. */
+} GESTURE_CONFIG_T;
+
+/*!
+ * \brief GestureRecogniser class
+ */
+class GestureRecogniser
+{
+  GESTURE_CONFIG_T config;
+  bool down;                // Panel is touched.
+  bool moved;               // Touch moved further than the slop.
+  bool long_fired;          // Long press already reported.
+  bool tap_pending;         // Tap waiting to see if it is a double tap.
+  uint32_t down_ms;
+  uint16_t down_x, down_y;
+  uint32_t tap_ms;
+  uint16_t tap_x, tap_y;
+  bool queued;              // Gesture kept behind a pending tap.
+  GESTURE_T queue;
+  uint32_t queue_ms;
+
+  bool near(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+  bool tap_first(GESTURE_T *gesture, bool found, uint32_t now_ms);
+public:
+  /*!
+   * \brief Constructor, with the default thresholds.
+   */
+  GestureRecogniser();
+
+  /*!
+   * \brief Set the thresholds.
+   *
+   * \param new_config Pointer to the GESTURE_CONFIG_T struct, copied.
+   */
+  void setConfig(const GESTURE_CONFIG_T *new_config);
+
+  /*!
+   * \brief Forget any touch in progress, e.g. when another screen has been
+   * handling the events.
+   */
+  void reset();
+
+  /*!
+   * \brief Pass the next touch event.
+   *
+   * \param event The touch event.
+   * \param gesture Pointer to the GESTURE_T struct to fill in.
+   *
+   * \result True if the event completed a gesture.
+   */
+  bool feed(const TOUCH_EVENT_T &event, GESTURE_T *gesture);
+
+  /*!
+   * \brief Report the gestures that are recognised by time passing.
+   *
+   * A long press while the panel is touched, a tap once a double tap is no
+   * longer possible, or a gesture that was kept behind a tap.
+   *
+   * \param now_ms millis() now.
+   * \param gesture Pointer to the GESTURE_T struct to fill in.
+   *
+   * \result True if there was a gesture.
+   */
+  bool poll(uint32_t now_ms, GESTURE_T *gesture);
+
+  /*!
+   * \brief When poll() next needs to be called.
+   *
+   * \param due_ms Pointer to where to put the millis() it is due at.
+   *
+   * \result False if it doesn't need to be called until the next event.
+   */
+  bool due(uint32_t *due_ms);
+};
+
+#endif // GESTURE_
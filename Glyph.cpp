@@ -0,0 +1,281 @@
+#include "Glyph.h"
+
+#include <Font7s.h>                 // Font 7 tables, from Adafruit_GFX_AS.
+#include <Font64.h>                 // Font 6 tables, from Adafruit_GFX_AS.
+
+// Line buffer the glyphs are expanded into, sent to the display by DMA.
+static const int GLYPH_BUF_PX = GLYPH_MAX_W * GLYPH_BUF_ROWS;
+static uint16_t glyph_buf[GLYPH_BUF_PX];
+
+static bool glyph_enabled = true;
+static bool delta_enabled = true;
+static GLYPH_STATS_T glyph_stats;
+
+// Extra pixels worth sending to save setting another address window, which
+// is 11 bytes of commands and coordinates.
+static const int WINDOW_COST_PX = 6;
+
+// Finds the run length encoded data for 'c' in font 6 or 7. Returns false if
+// it isn't one of the glyphs drawn here.
+static bool glyph_lookup(
+  char c,
+  int font,
+  const uint8_t **rle,
+  int *width,
+  int *height
+  )
+{
+  if (!((c >= '0' && c <= ':') || c == '.'))
+  {
+    return false;
+  }
+
+  switch (font)
+  {
+    case 6:
+      *rle = chrtbl_f64[c - 32];
+      *width = widtbl_f64[c - 32];
+      *height = chr_hgt_f64;
+      break;
+    case 7:
+      *rle = chrtbl_f7s[c - 32];
+      *width = widtbl_f7s[c - 32];
+      *height = chr_hgt_f7s;
+      break;
+    default:
+      return false;
+  }
+  return *width <= GLYPH_MAX_W;
+}
+
+int glyph_draw(
+  Adafruit_ILI9341_STM* tft,
+  char c,
+  int x,
+  int y,
+  int font,
+  uint16_t fg,
+  uint16_t bg
+  )
+{
+  const uint8_t *rle;
+  int width, height;
+  int remaining;
+  int count = 0;
+
+  if (!glyph_enabled || fg == bg || !glyph_lookup(c, font, &rle, &width, &height))
+  {
+    return 0;
+  }
+
+  tft->setAddrWindow(x, y, x + width - 1, y + height - 1);
+  glyph_stats.windows++;
+  glyph_stats.pixels += width * height;
+
+  // Each byte is a run of 1 to 128 pixels, foreground if bit 7 is set.
+  remaining = width * height;
+  while (remaining > 0)
+  {
+    uint8_t run = *rle++;
+    uint16_t colour = (run & 0x80) ? fg : bg;
+    int len = (run & 0x7F) + 1;
+
+    remaining -= len;
+    while (len--)
+    {
+      glyph_buf[count++] = colour;
+      if (count == GLYPH_BUF_PX)
+      {
+        tft->pushColors(glyph_buf, count, 0);
+        count = 0;
+      }
+    }
+  }
+
+  if (count)
+  {
+    tft->pushColors(glyph_buf, count, 0);
+  }
+  return width;
+}
+
+// Decodes a run length encoded glyph one row at a time, so two glyphs can be
+// compared row by row without expanding either of them.
+typedef struct _glyph_rows {
+  const uint8_t *rle;   // Next run.
+  int width;
+  int left;             // Pixels left in the current run.
+  bool fg;              // The current run is foreground.
+} GLYPH_ROWS_T;
+
+static void rows_begin(GLYPH_ROWS_T *rows, const uint8_t *rle, int width)
+{
+  rows->rle = rle;
+  rows->width = width;
+  rows->left = 0;
+  rows->fg = false;
+}
+
+// The next row as one bit per pixel, bit 0 is the left most pixel.
+static uint64_t rows_next(GLYPH_ROWS_T *rows)
+{
+  uint64_t bits = 0;
+  int col = 0;
+
+  while (col < rows->width)
+  {
+    int len;
+
+    if (!rows->left)
+    {
+      uint8_t run = *rows->rle++;
+
+      rows->fg = (run & 0x80);
+      rows->left = (run & 0x7F) + 1;
+    }
+
+    len = min(rows->left, rows->width - col);
+    if (rows->fg)
+    {
+      bits |= (((uint64_t)1 << len) - 1) << col;
+    }
+    col += len;
+    rows->left -= len;
+  }
+  return bits;
+}
+
+// Sends a rectangle of a glyph, decoding its rows from 'rows', which is
+// where the decoder was at the top row of the rectangle.
+static void send_rect(
+  Adafruit_ILI9341_STM* tft,
+  GLYPH_ROWS_T rows,
+  int x,
+  int y,
+  int x0,
+  int x1,
+  int y0,
+  int y1,
+  uint16_t fg,
+  uint16_t bg
+  )
+{
+  int count = 0;
+
+  tft->setAddrWindow(x + x0, y + y0, x + x1, y + y1);
+  glyph_stats.windows++;
+  glyph_stats.pixels += (x1 - x0 + 1) * (y1 - y0 + 1);
+
+  for (int row=y0; row <= y1; row++)
+  {
+    uint64_t bits = rows_next(&rows);
+
+    for (int col=x0; col <= x1; col++)
+    {
+      glyph_buf[count++] = ((bits >> col) & 1) ? fg : bg;
+      if (count == GLYPH_BUF_PX)
+      {
+        tft->pushColors(glyph_buf, count, 0);
+        count = 0;
+      }
+    }
+  }
+
+  if (count)
+  {
+    tft->pushColors(glyph_buf, count, 0);
+  }
+}
+
+int glyph_draw_delta(
+  Adafruit_ILI9341_STM* tft,
+  char from,
+  char to,
+  int x,
+  int y,
+  int font,
+  uint16_t fg,
+  uint16_t bg
+  )
+{
+  const uint8_t *old_rle, *rle;
+  int old_width, width, old_height, height;
+  GLYPH_ROWS_T old_rows, rows, rect_start;
+  int x0 = 0, x1 = -1, y0 = 0;
+
+  if (!glyph_enabled || !delta_enabled || fg == bg ||
+      !glyph_lookup(from, font, &old_rle, &old_width, &old_height) ||
+      !glyph_lookup(to, font, &rle, &width, &height) ||
+      old_width != width || old_height != height)
+  {
+    return 0;
+  }
+  rows_begin(&old_rows, old_rle, width);
+  rows_begin(&rows, rle, width);
+
+  // Walk down both glyphs together, growing a rectangle around the changed
+  // pixels. A row is added to it if the extra pixels that brings in cost
+  // less than starting a new rectangle, otherwise the rectangle is sent.
+  for (int row=0; row <= height; row++)
+  {
+    GLYPH_ROWS_T row_start = rows;
+    uint64_t diff = 0;
+    int lo = 0, hi = -1;
+
+    if (row < height)
+    {
+      diff = rows_next(&old_rows) ^ rows_next(&rows);
+    }
+
+    if (diff)
+    {
+      lo = __builtin_ctzll(diff);
+      hi = 63 - __builtin_clzll(diff);
+    }
+
+    if (x1 >= x0)
+    {
+      int nx0 = min(x0, lo), nx1 = max(x1, hi);
+      int rect_rows = row - y0;
+      int joined = (nx1 - nx0 + 1) * (rect_rows + 1);
+      int apart = ((x1 - x0 + 1) * rect_rows) + (hi - lo + 1) + WINDOW_COST_PX;
+
+      if (diff && joined <= apart)
+      {
+        x0 = nx0;
+        x1 = nx1;
+        continue;
+      }
+      send_rect(tft, rect_start, x, y, x0, x1, y0, row - 1, fg, bg);
+      x1 = -1;
+    }
+
+    if (diff)
+    {
+      x0 = lo;
+      x1 = hi;
+      y0 = row;
+      rect_start = row_start;
+    }
+  }
+  return width;
+}
+
+void glyph_get_stats(GLYPH_STATS_T *stats, bool reset)
+{
+  *stats = glyph_stats;
+  if (reset)
+  {
+    memset(&glyph_stats, 0, sizeof(glyph_stats));
+  }
+}
+
+void glyph_enable(bool enable)
+{
+  glyph_enabled = enable;
+}
+
+void glyph_enable_delta(bool enable)
+{
+  delta_enabled = enable;
+}
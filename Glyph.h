@@ -0,0 +1,130 @@
+#ifndef GLYPH_
+#define GLYPH_
+/*!
+ * \file
+ *
+ * \brief Fast drawing of the font 6 and font 7 clock glyphs.
+ *
+ * drawChar() sends the font 6 and 7 glyphs to the display one run of pixels
+ * at a time. These functions draw the digits, colon and full stop with a
+ * single address window instead, expanding the glyph into a line buffer that
+ * is sent to the display by DMA.
+ *
+ * NOTES:
+ *      - The glyphs are expanded from the Adafruit_GFX_AS run length encoded
+ *        font tables, which are already in flash, rather than from a second
+ *        pre-expanded copy of the 24 glyphs (over 4KB of flash) that would
+ *        have to be generated from the library's tables.
+ *      - The line buffer is #GLYPH_BUF_ROWS rows of the widest glyph, a
+ *        glyph is sent in 48 / #GLYPH_BUF_ROWS DMA bursts.
+ *      - glyph_draw_delta() changes one glyph into another by only sending
+ *        the rectangles around the pixels that differ, e.g. 8 to 9 is one
+ *        segment rather than the whole 34x48 cell. It decodes both glyphs
+ *        together a row at a time, so neither is expanded in full.
+ */
+
+#include <Adafruit_ILI9341_STM.h>   // STM32 DMA Hardware-specific library
+
+/*!
+ * \defgroup GLYPH definitions
+ * \{
+ */
+#define GLYPH_MAX_W (34)            /*!< Widest glyph - font 7 digit. */
+#define GLYPH_MAX_H (48)            /*!< Tallest glyph - font 6 and 7. */
+#define GLYPH_BUF_ROWS (12)         /*!< Rows in the line buffer. */
+/*! \} */
+
+/*!
+ * \brief Draw a font 6 or font 7 digit, colon or full stop.
+ *
+ * Draws the same pixels as drawChar(), background included.
+ *
+ * \param tft Pointer to ILI9341 screen instance.
+ * \param c Character to draw - '0' to '9', ':' or '.'.
+ * \param x X co-ord of the top left corner.
+ * \param y Y co-ord of the top left corner.
+ * \param font Font size, 6 or 7.
+ * \param fg Foreground colour.
+ * \param bg Background colour, must be different to the foreground.
+ *
+ * \result Width of the glyph drawn, or 0 if it can't be drawn this way and
+ *         drawChar() should be used instead.
+ */
+int glyph_draw(
+  Adafruit_ILI9341_STM* tft,
+  char c,
+  int x,
+  int y,
+  int font,
+  uint16_t fg,
+  uint16_t bg
+  );
+
+/*!
+ * \brief Change a glyph already on the display into another.
+ *
+ * Works out which pixels differ between the two glyphs and only sends those,
+ * as a few rectangles. Adjacent rows are joined into one rectangle when
+ * sending the extra pixels costs less than another address window. The
+ * glyphs must be the same width and drawn in the same colours.
+ *
+ * \param tft Pointer to ILI9341 screen instance.
+ * \param from Character on the display - '0' to '9', ':' or '.'.
+ * \param to Character to change it to.
+ * \param x X co-ord of the top left corner.
+ * \param y Y co-ord of the top left corner.
+ * \param font Font size, 6 or 7.
+ * \param fg Foreground colour.
+ * \param bg Background colour, must be different to the foreground.
+ *
+ * \result Width of the glyph, or 0 if it can't be changed this way and it
+ *         should be drawn in full instead.
+ */
+int glyph_draw_delta(
+  Adafruit_ILI9341_STM* tft,
+  char from,
+  char to,
+  int x,
+  int y,
+  int font,
+  uint16_t fg,
+  uint16_t bg
+  );
+
+/*!
+ * \brief GLYPH_STATS_T struct for the display traffic of the glyph functions.
+ */
+typedef struct _glyph_stats {
+  uint32_t windows;     /*!< Address windows set. */
+  uint32_t pixels;      /*!< Pixels sent. */
+} GLYPH_STATS_T;
+
+/*!
+ * \brief Get the display traffic of glyph_draw() and glyph_draw_delta().
+ *
+ * \param stats Pointer to the GLYPH_STATS_T struct to fill in.
+ * \param reset True to zero the counts after reading them.
+ */
+void glyph_get_stats(GLYPH_STATS_T *stats, bool reset);
+
+/*!
+ * \brief Enable or disable glyph_draw().
+ *
+ * When disabled glyph_draw() always returns 0, so drawChar() is used. For
+ * comparing the two.
+ *
+ * \param enable True to enable.
+ */
+void glyph_enable(bool enable);
+
+/*!
+ * \brief Enable or disable glyph_draw_delta().
+ *
+ * When disabled glyph_draw_delta() always returns 0, so the glyph is drawn
+ * in full. For comparing the two.
+ *
+ * \param enable True to enable.
+ */
+void glyph_enable_delta(bool enable);
+
+#endif // GLYPH_
@@ -0,0 +1,149 @@
+#include "SoftClock.h"
+
+SoftClock softclock;
+
+SoftClock::SoftClock(unsigned long resync_interval_ms)
+: now(0), base_millis(0), sync_millis(0), resync_ms(resync_interval_ms),
+  drift_ms(0), drift_ppm(0), wday_offset(0)
+{ }
+
+// The DS3231 day of week is just a counter, set independently of the date,
+// so keep the offset from the calendar day of week when converting.
+EPOCH_T SoftClock::from_rtc(const TM_T *date_time)
+{
+  EPOCH_T epoch = tm_to_epoch(date_time);
+  TM_T calendar;
+
+  epoch_to_tm(epoch, &calendar);
+  wday_offset = (7 + date_time->tm_wday - calendar.tm_wday) % 7;
+  return epoch;
+}
+
+// Waits for the RTC seconds to count on, reading the registers until they
+// do, and returns millis() at the start of the read that saw it. That is
+// within one burst read (about 2ms at 100kHz) after the edge.
+unsigned long SoftClock::wait_edge(TM_T *date_time)
+{
+  unsigned long start = millis();
+  unsigned long ms;
+  uint8_t sec;
+
+  rtc_refresh();
+  sec = get_date_time(date_time)->tm_sec;
+  do
+  {
+    ms = millis();
+    rtc_refresh();
+    get_date_time(date_time);
+  } while (date_time->tm_sec == sec &&
+    (ms - start) < SOFT_CLOCK_EDGE_TIMEOUT_MS);
+
+  return ms;
+}
+
+// Measures the drift against the RTC time read just after its second
+// started at edge_ms, then starts the software second there too.
+void SoftClock::resync(const TM_T *date_time, unsigned long edge_ms)
+{
+  EPOCH_T rtc_now = from_rtc(date_time);
+
+  advance(edge_ms);
+  drift_ms = (long)epoch_diff(now, rtc_now) * 1000L +
+    (long)(edge_ms - base_millis);
+  if (edge_ms != sync_millis)
+  {
+    drift_ppm = (long)((drift_ms * 1000000LL) / (long)(edge_ms - sync_millis));
+  }
+
+  now = rtc_now;
+  base_millis = sync_millis = edge_ms;
+}
+
+void SoftClock::begin()
+{
+  TM_T rtc;
+  unsigned long ms = wait_edge(&rtc);
+
+  now = from_rtc(&rtc);
+  base_millis = sync_millis = ms;
+}
+
+// Bring the clock up to date with ms, a millis() that isn't before
+// base_millis.
+void SoftClock::advance(unsigned long ms)
+{
+  unsigned long secs = (ms - base_millis) / 1000;
+
+  now += secs;
+  base_millis += secs * 1000;
+}
+
+void SoftClock::sync()
+{
+  TM_T rtc;
+  unsigned long ms = wait_edge(&rtc);
+
+  resync(&rtc, ms);
+}
+
+void SoftClock::align()
+{
+  unsigned long ms = millis();
+
+  // The RTC has just counted on, so this is as good as waiting for it.
+  if ((ms - sync_millis) >= resync_ms)
+  {
+    TM_T rtc;
+
+    rtc_refresh();
+    resync(get_date_time(&rtc), ms);
+    return;
+  }
+
+  advance(ms);
+  // Just past the second boundary, so round to the nearest second.
+  if ((ms - base_millis) >= 500)
+  {
+    now++;
+  }
+  base_millis = ms;
+}
+
+TM_T *SoftClock::get(TM_T *date_time)
+{
+  unsigned long ms = millis();
+
+  if ((ms - sync_millis) >= resync_ms)
+  {
+    sync();
+  }
+  else
+  {
+    advance(ms);
+  }
+  epoch_to_tm(now, date_time);
+  date_time->tm_wday = ((date_time->tm_wday - 1 + wday_offset) % 7) + 1;
+  return date_time;
+}
+
+void SoftClock::set(TM_T *date_time)
+{
+  set_date_time(date_time);
+  now = from_rtc(date_time);
+  base_millis = sync_millis = millis();
+}
+
+void SoftClock::setResyncInterval(unsigned long resync_interval_ms)
+{
+  resync_ms = resync_interval_ms;
+}
+
+long SoftClock::getDrift()
+{
+  return drift_ms;
+}
+
+long SoftClock::getDriftPpm()
+{
+  return drift_ppm;
+}
@@ -0,0 +1,142 @@
+#ifndef SOFT_CLOCK_
+#define SOFT_CLOCK_
+/*!
+ * \file
+ *
+ * \brief Software time keeping, disciplined by the DS3231 RTC.
+ *
+ * The date and time is read from the DS3231 once and then advanced in RAM
+ * from millis(), as seconds since the epoch (see Epoch.h), so reading the 
+ * time costs no I2C transactions. The RTC is
+ * read again every resync interval, at which point the difference between
+ * the two clocks is recorded as the drift of the MCU clock.
+ *
+ * NOTES:
+ *      - The RTC only has one second resolution, so begin() and sync() read
+ *        it until the seconds count on and start the software second there.
+ *        The drift is then measured to a millisecond or two, but they block
+ *        for up to a second, #SOFT_CLOCK_EDGE_TIMEOUT_MS at most.
+ *      - When align() is called on the 1Hz square wave edge (see
+ *        set_square_wave) it does the resyncs instead, without the wait.
+ *      - Years 2000 to 2199 are handled, using the DS3231 century bit.
+ */
+
+#include <Arduino.h>
+
+#include "DS3231_RTC.h"
+#include "Epoch.h"
+
+/*!
+ * \brief Default resync interval - 1 hour.
+ */
+#define SOFT_CLOCK_RESYNC_MS (3600000UL)
+
+/*!
+ * \brief Longest wait for the RTC seconds to count on.
+ */
+#define SOFT_CLOCK_EDGE_TIMEOUT_MS (1100UL)
+
+/*!
+ * \brief SoftClock class
+ *
+ * Keeps a TM_T date and time in RAM, advanced from millis().
+ */
+class SoftClock
+{
+  EPOCH_T now;                // Date and time at the start of the second.
+  unsigned long base_millis;  // millis() at the start of the second.
+  unsigned long sync_millis;  // millis() at the last RTC sync.
+  unsigned long resync_ms;
+  long drift_ms;
+  long drift_ppm;
+  uint8_t wday_offset;        // RTC day of week less the calendar one.
+
+  void advance(unsigned long ms);
+  unsigned long wait_edge(TM_T *date_time);
+  void resync(const TM_T *date_time, unsigned long edge_ms);
+  EPOCH_T from_rtc(const TM_T *date_time);
+public:
+  /*!
+   * \brief Constructor.
+   *
+   * \param resync_interval_ms How often to resync with the RTC in ms.
+   */
+  SoftClock(unsigned long resync_interval_ms = SOFT_CLOCK_RESYNC_MS);
+
+  /*!
+   * \brief Read the date and time from the RTC to start the clock.
+   *
+   * Waits for the RTC seconds to count on, so the software second starts
+   * with the RTC one. Must be called after Wire.begin().
+   */
+  void begin();
+
+  /*!
+   * \brief Resync with the RTC now.
+   *
+   * Waits for the RTC seconds to count on, then records how far the
+   * software clock is from the RTC there as the drift before taking the RTC
+   * date and time.
+   */
+  void sync();
+
+  /*!
+   * \brief Align the software clock with the start of the RTC second.
+   *
+   * Call when the 1Hz square wave indicates the RTC seconds have just
+   * incremented. Sub-second time in the software clock is discarded. If the
+   * resync interval has elapsed the RTC is read and the drift measured here,
+   * rather than by the next get() waiting for the edge.
+   */
+  void align();
+
+  /*!
+   * \brief Get the current date and time.
+   *
+   * Resyncs with the RTC first if the resync interval has elapsed, which
+   * waits for the RTC seconds to count on (see sync()).
+   *
+   * \param date_time Pointer to the TM_T struct which will contain the date
+   *        and time.
+   *
+   * \result The pointer passed as a parameter is returned.
+   */
+  TM_T *get(TM_T *date_time);
+
+  /*!
+   * \brief Set the date and time, in both the software clock and the RTC.
+   *
+   * \param date_time Pointer to the TM_T struct containing the new date and
+   *        time.
+   */
+  void set(TM_T *date_time);
+
+  /*!
+   * \brief Set how often to resync with the RTC.
+   *
+   * \param resync_interval_ms Resync interval in ms.
+   */
+  void setResyncInterval(unsigned long resync_interval_ms);
+
+  /*!
+   * \brief Drift measured at the last resync.
+   *
+   * \result Milliseconds the software clock was ahead (positive) or behind
+   *         (negative) the RTC.
+   */
+  long getDrift();
+
+  /*!
+   * \brief Drift rate measured at the last resync.
+   *
+   * \result Drift of the MCU clock relative to the RTC in parts per million.
+   */
+  long getDriftPpm();
+};
+
+/*!
+ * \brief The software clock instance.
+ */
+extern SoftClock softclock;
+
+#endif // SOFT_CLOCK_
@@ -0,0 +1,182 @@
+#include "TaskScheduler.h"
+
+// Has 'time' been reached, allowing for millis() wrapping.
+static bool reached(uint32_t now, uint32_t time)
+{
+  return (int32_t)(now - time) >= 0;
+}
+
+TaskScheduler::TaskScheduler()
+: count(0)
+{
+  memset((void *)signalled, 0, sizeof(signalled));
+}
+
+uint8_t TaskScheduler::add(
+  TASK_FN_T fn,
+  const char *name,
+  uint32_t period_ms,
+  uint32_t deadline_ms
+  )
+{
+  TASK_T *task;
+
+  if (count == TASK_MAX)
+    return TASK_NONE;
+
+  task = &tasks[count];
+  memset(task, 0, sizeof(*task));
+  task->fn = fn;
+  task->name = name;
+  task->period_ms = period_ms;
+  task->deadline_ms = deadline_ms;
+  task->due = millis() + period_ms;
+  task->timed = (period_ms != TASK_ON_DEMAND);
+  return count++;
+}
+
+void TaskScheduler::setPeriod(uint8_t id, uint32_t period_ms)
+{
+  TASK_T *task = &tasks[id];
+  uint32_t soonest = millis() + period_ms;
+
+  if (task->period_ms == period_ms)
+    return;
+
+  task->period_ms = period_ms;
+  if (period_ms == TASK_ON_DEMAND)
+  {
+    task->timed = false;
+  }
+  else if (!task->timed || reached(task->due, soonest))
+  {
+    task->due = soonest;
+    task->timed = true;
+  }
+}
+
+void TaskScheduler::signal(uint8_t id)
+{
+  if (id >= count)
+    return;
+
+  // Only the first signal before the task runs sets when it was due.
+  if (!signalled[id])
+  {
+    signal_ms[id] = millis();
+    signalled[id] = true;
+  }
+}
+
+void TaskScheduler::wake(uint8_t id, uint32_t delay_ms)
+{
+  tasks[id].due = millis() + delay_ms;
+  tasks[id].timed = true;
+}
+
+// The highest priority task that is due, and when it became due.
+uint8_t TaskScheduler::nextDue(uint32_t now, uint32_t *released)
+{
+  for (uint8_t id=0; id < count; id++)
+  {
+    if (signalled[id])
+    {
+      *released = signal_ms[id];
+      return id;
+    }
+    if (tasks[id].timed && reached(now, tasks[id].due))
+    {
+      *released = tasks[id].due;
+      return id;
+    }
+  }
+  return TASK_NONE;
+}
+
+bool TaskScheduler::run()
+{
+  uint32_t now = millis();
+  uint32_t released;
+  uint32_t start;
+  uint32_t elapsed_us;
+  uint32_t late_ms;
+  uint8_t id = nextDue(now, &released);
+  TASK_T *task;
+
+  if (id == TASK_NONE)
+  {
+    // Nothing to do until an interrupt, at worst the next SysTick.
+#ifdef __arm__
+    asm volatile ("wfi");
+#else
+    delay(1);         // The host build, where time only moves when told to.
+#endif
+    return false;
+  }
+  task = &tasks[id];
+
+  // Cleared before it runs, so a signal while it runs runs it again.
+  signalled[id] = false;
+
+  if (task->timed && reached(now, task->due))
+  {
+    if (task->period_ms == TASK_ON_DEMAND)
+    {
+      task->timed = false;
+    }
+    else
+    {
+      task->due += task->period_ms;
+      if (reached(now, task->due))
+      {
+        task->due = now + task->period_ms;    // Skip the missed releases.
+      }
+    }
+  }
+
+  start = micros();
+  task->fn();
+  elapsed_us = micros() - start;
+  late_ms = millis() - released;
+
+  task->stats.runs++;
+  task->stats.total_us += elapsed_us;
+  task->stats.worst_us = max(task->stats.worst_us, elapsed_us);
+  task->stats.late_ms = max(task->stats.late_ms, late_ms);
+  if (late_ms > task->deadline_ms)
+  {
+    task->stats.misses++;
+  }
+  return true;
+}
+
+void TaskScheduler::getStats(uint8_t id, TASK_STATS_T *stats, bool reset)
+{
+  *stats = tasks[id].stats;
+  if (reset)
+  {
+    memset(&tasks[id].stats, 0, sizeof(tasks[id].stats));
+  }
+}
+
+void TaskScheduler::printStats()
+{
+  for (uint8_t id=0; id < count; id++)
+  {
+    TASK_STATS_T stats;
+
+    getStats(id, &stats, true);
+    Serial.print(tasks[id].name);
+    Serial.print(": ");
+    Serial.print(stats.runs);
+    Serial.print(" runs, ");
+    Serial.print(stats.runs ? stats.total_us / stats.runs : 0);
+    Serial.print("us average, ");
+    Serial.print(stats.worst_us);
+    Serial.print("us worst, ");
+    Serial.print(stats.late_ms);
+    Serial.print("ms latest, ");
+    Serial.print(stats.misses);
+    Serial.println(" missed");
+  }
+}
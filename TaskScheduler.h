@@ -0,0 +1,159 @@
+#ifndef TASK_SCHEDULER_
+#define TASK_SCHEDULER_
+/*!
+ * \file
+ *
+ * \brief Fixed priority cooperative task scheduler.
+ *
+ * Each task is a function that does a little work and returns. A task runs
+ * either every period, or on demand when it is signalled or woken after a
+ * delay. loop() calls run(), which runs the highest priority task that is
+ * due and returns, so a higher priority task never waits behind more than
+ * one lower priority one. When nothing is due the CPU sleeps until the next
+ * interrupt, the 1ms SysTick at the latest.
+ *
+ * NOTES:
+ *      - Priority is the order the tasks are added, the first is highest.
+ *      - A task's deadline is how long after it became due it must have
+ *        finished. Finishing later is counted as a miss, it isn't stopped.
+ *      - A periodic task that overruns skips the releases it missed rather
+ *        than running back to back to catch up.
+ *      - signal() may be called from an interrupt handler.
+ */
+
+#include <Arduino.h>
+
+/*!
+ * \defgroup TASK definitions
+ * \{
+ */
+#define TASK_MAX (8)                /*!< Max number of tasks. */
+#define TASK_ON_DEMAND (0)          /*!< Period of a task that isn't periodic. */
+#define TASK_NONE (0xFF)            /*!< Not a task id. */
+/*! \} */
+
+/*!
+ * \brief Function run by a task.
+ */
+typedef void (*TASK_FN_T)(void);
+
+/*!
+ * \brief TASK_STATS_T struct for how a task has run.
+ */
+typedef struct _task_stats {
+  uint32_t runs;        /*!< Times the task ran. */
+  uint32_t misses;      /*!< Times it finished after its deadline. */
+  uint32_t total_us;    /*!< Total run time in microseconds. */
+  uint32_t worst_us;    /*!< Longest run time in microseconds. */
+  uint32_t late_ms;     /*!< Longest time from due to finished, in ms. */
+} TASK_STATS_T;
+
+/*!
+ * \brief TASK_T struct for a scheduled task.
+ */
+typedef struct _task {
+  TASK_FN_T fn;             /*!< Function to run. */
+  const char *name;         /*!< Name, for printing the stats. */
+  uint32_t period_ms;       /*!< Period, or #TASK_ON_DEMAND. */
+  uint32_t deadline_ms;     /*!< Must finish this long after it is due. */
+  uint32_t due;             /*!< millis() when it is next due. */
+  bool timed;               /*!< True if 'due' is set. */
+  TASK_STATS_T stats;       /*!< How it has run. */
+} TASK_T;
+
+/*!
+ * \brief TaskScheduler class
+ */
+class TaskScheduler
+{
+  TASK_T tasks[TASK_MAX];
+  uint8_t count;
+  // Set by signal(), maybe in an interrupt. Single byte and word writes, so
+  // no read-modify-write that an interrupt could split.
+  volatile bool signalled[TASK_MAX];
+  volatile uint32_t signal_ms[TASK_MAX];
+
+  uint8_t nextDue(uint32_t now, uint32_t *released);
+public:
+  /*!
+   * \brief Constructor.
+   */
+  TaskScheduler();
+
+  /*!
+   * \brief Add a task, at a lower priority than those already added.
+   *
+   * A periodic task is first due one period after it is added.
+   *
+   * \param fn Function the task runs.
+   * \param name Name of the task, not copied.
+   * \param period_ms Period in ms, or #TASK_ON_DEMAND.
+   * \param deadline_ms How long after it is due it must have finished.
+   *
+   * \result The task id, or #TASK_NONE if there are already #TASK_MAX.
+   */
+  uint8_t add(
+    TASK_FN_T fn,
+    const char *name,
+    uint32_t period_ms,
+    uint32_t deadline_ms
+    );
+
+  /*!
+   * \brief Change the period of a task.
+   *
+   * If the new period is shorter the task is due sooner, no later than one
+   * new period from now.
+   *
+   * \param id The task id.
+   * \param period_ms Period in ms, or #TASK_ON_DEMAND to stop it running
+   *        periodically.
+   */
+  void setPeriod(uint8_t id, uint32_t period_ms);
+
+  /*!
+   * \brief Make a task due now.
+   *
+   * May be called from an interrupt handler. Ids of tasks not yet added are
+   * ignored.
+   *
+   * \param id The task id.
+   */
+  void signal(uint8_t id);
+
+  /*!
+   * \brief Make a task due after a delay.
+   *
+   * Replaces when a periodic task is next due.
+   *
+   * \param id The task id.
+   * \param delay_ms Delay in ms.
+   */
+  void wake(uint8_t id, uint32_t delay_ms);
+
+  /*!
+   * \brief Run the highest priority task that is due.
+   *
+   * Call on every iteration of loop(). If no task is due the CPU sleeps
+   * until the next interrupt.
+   *
+   * \result True if a task was run.
+   */
+  bool run();
+
+  /*!
+   * \brief Get how a task has run.
+   *
+   * \param id The task id.
+   * \param stats Pointer to the TASK_STATS_T struct to fill in.
+   * \param reset True to zero the stats after reading them.
+   */
+  void getStats(uint8_t id, TASK_STATS_T *stats, bool reset);
+
+  /*!
+   * \brief Print the stats of every task on the Serial port, then reset them.
+   */
+  void printStats();
+};
+
+#endif // TASK_SCHEDULER_
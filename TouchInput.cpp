@@ -0,0 +1,271 @@
+#include "TouchInput.h"
+
+static XPT2046 *touch_panel = NULL;
+static TOUCH_NOTIFY_T touch_notify = NULL;
+
+// Ring buffer. Only the interrupts write 'head' and only touch_input_read()
+// writes 'tail', so neither needs a lock.
+static TOUCH_EVENT_T queue[TOUCH_QUEUE_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+static volatile uint32_t dropped = 0;
+
+// Set while the panel is touched and the timer is reading it.
+static volatile bool sampling = false;
+static bool pressed = false;             // The press has been queued.
+static uint16_t last_x, last_y;
+static uint8_t last_confidence;
+
+// How the positions are read, set from loop().
+static volatile uint8_t reads = TOUCH_READS;
+static volatile uint8_t filter_shift = TOUCH_FILTER_SHIFT;
+
+// Filtered position, in 1/16ths of a pixel so slow movement isn't lost.
+#define FILTER_FRACTION 4
+static int32_t filter_x, filter_y;
+
+static TOUCH_STATS_T stats;
+
+// Stops the compiler moving memory accesses across it.
+#define COMPILER_BARRIER() asm volatile ("" ::: "memory")
+
+// Queue an event, called from the interrupts only.
+static void push(uint8_t type, uint16_t x, uint16_t y, uint8_t confidence)
+{
+  uint8_t next = (head + 1) & (TOUCH_QUEUE_SIZE - 1);
+  uint8_t used = (head - tail) & (TOUCH_QUEUE_SIZE - 1);
+  TOUCH_EVENT_T *event;
+
+  // The last free slot is kept for a press or release, so the UI doesn't
+  // lose track of whether the panel is touched.
+  if (next == tail || (type == TOUCH_MOVE && used >= TOUCH_QUEUE_SIZE - 2))
+  {
+    dropped++;
+    return;
+  }
+
+  event = &queue[head];
+  event->ms = millis();
+  event->x = x;
+  event->y = y;
+  event->type = type;
+  event->confidence = confidence;
+  COMPILER_BARRIER();         // The event is written before it is queued.
+  head = next;
+
+  if (touch_notify)
+  {
+    touch_notify();
+  }
+}
+
+// Sort a few values, insertion sort is the quickest for so few.
+static void sort(uint16_t *values, uint8_t count)
+{
+  for (uint8_t i=1; i < count; i++)
+  {
+    uint16_t value = values[i];
+    uint8_t j = i;
+
+    for (; j > 0 && values[j-1] > value; j--)
+    {
+      values[j] = values[j-1];
+    }
+    values[j] = value;
+  }
+}
+
+// Read the position several times back to back and take the median. False
+// if too few of the reads agreed with it to trust it.
+static bool read_position(uint16_t *x, uint16_t *y, uint8_t *confidence)
+{
+  uint16_t xs[TOUCH_READS_MAX], ys[TOUCH_READS_MAX];
+  uint16_t sorted_x[TOUCH_READS_MAX], sorted_y[TOUCH_READS_MAX];
+  uint8_t count = reads;
+  uint8_t valid = 0;
+  uint8_t agree = 0;
+  uint32_t start = micros();
+  uint32_t elapsed_us;
+
+  for (uint8_t i=0; i < count; i++)
+  {
+    uint16_t read_x, read_y;
+
+    // 0xFFFF if the touch ended during the reads.
+    touch_panel->getPosition(
+      read_x, read_y, XPT2046::MODE_DFR, TOUCH_CONVERSIONS);
+    if (read_x == 0xFFFF || read_y == 0xFFFF)
+      continue;
+    xs[valid] = sorted_x[valid] = read_x;
+    ys[valid] = sorted_y[valid] = read_y;
+    valid++;
+  }
+
+  if (valid)
+  {
+    sort(sorted_x, valid);
+    sort(sorted_y, valid);
+    *x = sorted_x[valid / 2];
+    *y = sorted_y[valid / 2];
+
+    for (uint8_t i=0; i < valid; i++)
+    {
+      if (abs((int32_t)xs[i] - *x) <= TOUCH_AGREE_PX &&
+        abs((int32_t)ys[i] - *y) <= TOUCH_AGREE_PX)
+      {
+        agree++;
+      }
+    }
+  }
+  *confidence = (uint16_t)agree * 255 / count;
+
+  elapsed_us = micros() - start;
+  stats.positions++;
+  stats.total_us += elapsed_us;
+  stats.worst_us = max(stats.worst_us, elapsed_us);
+
+  // Most of the reads have to agree.
+  if (agree * 2 <= count)
+  {
+    stats.rejected++;
+    return false;
+  }
+  return true;
+}
+
+// Move the filtered position towards x, y and return it.
+static void filter(uint16_t *x, uint16_t *y)
+{
+  filter_x += (((int32_t)*x << FILTER_FRACTION) - filter_x) >> filter_shift;
+  filter_y += (((int32_t)*y << FILTER_FRACTION) - filter_y) >> filter_shift;
+  *x = (filter_x + (1 << (FILTER_FRACTION - 1))) >> FILTER_FRACTION;
+  *y = (filter_y + (1 << (FILTER_FRACTION - 1))) >> FILTER_FRACTION;
+}
+
+// Read the position, queueing the press on the first one that can be
+// trusted and a move each time it changes after that.
+static void sample_position()
+{
+  uint16_t x, y;
+  uint8_t confidence;
+  uint8_t type = TOUCH_MOVE;
+
+  if (!read_position(&x, &y, &confidence))
+    return;
+
+  if (!pressed)
+  {
+    filter_x = (int32_t)x << FILTER_FRACTION;
+    filter_y = (int32_t)y << FILTER_FRACTION;
+    pressed = true;
+    type = TOUCH_PRESS;
+  }
+  else
+  {
+    filter(&x, &y);
+    if (x == last_x && y == last_y)
+      return;
+  }
+
+  last_x = x;
+  last_y = y;
+  last_confidence = confidence;
+  push(type, x, y, confidence);
+}
+
+// Sample timer interrupt, every TOUCH_SAMPLE_US while touched.
+static void touch_sample()
+{
+  if (touch_panel->isTouching())
+  {
+    sample_position();
+    return;
+  }
+
+  Timer4.pause();
+  if (pressed)
+  {
+    push(TOUCH_RELEASE, last_x, last_y, last_confidence);
+  }
+  touch_panel->powerDown();   // Enables PENIRQ again.
+  sampling = false;
+}
+
+// PENIRQ falling edge, the panel has just been touched.
+static void touch_pen_down()
+{
+  if (sampling)
+    return;
+
+  sampling = true;
+  if (!touch_panel->isTouching())
+  {
+    touch_panel->powerDown();
+    sampling = false;
+    return;
+  }
+
+  // If the reads are too noisy the timer tries again.
+  pressed = false;
+  sample_position();
+  Timer4.refresh();
+  Timer4.resume();
+}
+
+void touch_input_begin(XPT2046 *touch, uint8_t irq_pin, TOUCH_NOTIFY_T notify)
+{
+  touch_panel = touch;
+  touch_notify = notify;
+
+  Timer4.pause();
+  Timer4.setPeriod(TOUCH_SAMPLE_US);
+  Timer4.setChannel1Mode(TIMER_OUTPUT_COMPARE);
+  Timer4.setCompare(TIMER_CH1, 1);
+  Timer4.attachCompare1Interrupt(touch_sample);
+
+  pinMode(irq_pin, INPUT);
+  attachInterrupt(irq_pin, touch_pen_down, FALLING);
+}
+
+void touch_input_set_filter(uint8_t new_reads, uint8_t new_filter_shift)
+{
+  reads = constrain(new_reads, 1, TOUCH_READS_MAX);
+  filter_shift = min(new_filter_shift, (uint8_t)(16 - FILTER_FRACTION));
+}
+
+bool touch_input_read(TOUCH_EVENT_T *event)
+{
+  uint8_t first = tail;
+
+  if (first == head)
+    return false;
+
+  COMPILER_BARRIER();         // The event is read after it was queued.
+  *event = queue[first];
+  COMPILER_BARRIER();         // And before its slot is given back.
+  tail = (first + 1) & (TOUCH_QUEUE_SIZE - 1);
+  return true;
+}
+
+uint32_t touch_input_dropped(bool reset)
+{
+  uint32_t count = dropped;
+
+  if (reset)
+  {
+    dropped = 0;
+  }
+  return count;
+}
+
+void touch_input_stats(TOUCH_STATS_T *copy, bool reset)
+{
+  // Updated by the interrupts, so copied with them off.
+  noInterrupts();
+  *copy = stats;
+  if (reset)
+  {
+    memset(&stats, 0, sizeof(stats));
+  }
+  interrupts();
+}
@@ -0,0 +1,138 @@
+#ifndef TOUCH_INPUT_
+#define TOUCH_INPUT_
+/*!
+ * \file
+ *
+ * \brief Interrupt driven touch screen input.
+ *
+ * The XPT2046 pulls its PENIRQ output low when the panel is touched, as long
+ * as it has been powered down with the interrupt enabled. The falling edge
+ * reads the position and queues a press, then a timer reads it every
+ * #TOUCH_SAMPLE_US while the panel is touched, queueing a move when it
+ * changes and a release when the touch ends. The panel isn't read at all
+ * while nobody is touching it, and a tap is queued however short it is.
+ *
+ * Events are timestamped with millis() and queued in a single producer,
+ * single consumer ring buffer. The interrupts are the producer, the UI reads
+ * them with touch_input_read() from loop(), without disabling interrupts.
+ *
+ * NOTES:
+ *      - Only the interrupts use the XPT2046 once touch_input_begin() has
+ *        been called, so SPI2 is never shared between them and loop().
+ *      - The PENIRQ edge is ignored while the panel is being read, the
+ *        conversions make it toggle.
+ *      - The sample timer is Timer 4. It has no output pins in use, the
+ *        beeper uses Timer 1.
+ *      - If the queue is full new events are dropped and counted. The queue
+ *        holds #TOUCH_QUEUE_SIZE - 1 events, 0.3 seconds of moves. Moves
+ *        are dropped one slot earlier, so a release still fits.
+ *
+ * Each position is the median of several reads taken back to back, which
+ * throws away the odd noisy read, then smoothed with a fixed point IIR
+ * filter while the touch continues. The XPT2046 library doesn't read the
+ * pressure, so the confidence of a position is how many of the reads agreed
+ * with the median. A read that too few agreed with is ignored. More reads
+ * cost more time in the interrupt, touch_input_stats() measures it.
+ */
+
+#include <Arduino.h>
+#include <XPT2046.h>                // SPI capacitive touch interface
+
+/*!
+ * \defgroup TOUCH definitions
+ * \{
+ */
+#define TOUCH_QUEUE_SIZE (32)       /*!< Queue size, a power of 2. */
+#define TOUCH_SAMPLE_US (10000)     /*!< Read rate while touched, 100Hz. */
+#define TOUCH_READS (5)             /*!< Default reads per position. */
+#define TOUCH_READS_MAX (9)         /*!< Most reads per position. */
+#define TOUCH_FILTER_SHIFT (1)      /*!< Default IIR filter, see below. */
+#define TOUCH_AGREE_PX (8)          /*!< A read this close to the median agrees. */
+#define TOUCH_CONVERSIONS (2)       /*!< XPT2046 conversions per read. */
+/*! \} */
+
+/*!
+ * \brief Touch event types.
+ */
+typedef enum _touch_event_type {
+  TOUCH_PRESS,          /*!< The panel was touched. */
+  TOUCH_MOVE,           /*!< The touch moved. */
+  TOUCH_RELEASE         /*!< The touch ended, at the last position. */
+} TOUCH_EVENT_TYPE_T;
+
+/*!
+ * \brief TOUCH_EVENT_T struct for a queued touch event.
+ */
+typedef struct _touch_event {
+  uint32_t ms;          /*!< millis() when it happened. */
+  uint16_t x;           /*!< X co-ord of the touch. */
+  uint16_t y;           /*!< Y co-ord of the touch. */
+  uint8_t type;         /*!< One of #TOUCH_EVENT_TYPE_T. */
+  uint8_t confidence;   /*!< 0 to 255, how many reads agreed. */
+} TOUCH_EVENT_T;
+
+/*!
+ * \brief TOUCH_STATS_T struct for the cost of reading the positions.
+ */
+typedef struct _touch_stats {
+  uint32_t positions;   /*!< Positions read. */
+  uint32_t rejected;    /*!< Positions ignored, too few reads agreed. */
+  uint32_t total_us;    /*!< Time spent reading them. */
+  uint32_t worst_us;    /*!< Longest time for one position. */
+} TOUCH_STATS_T;
+
+/*!
+ * \brief Function called from the interrupt when an event is queued.
+ */
+typedef void (*TOUCH_NOTIFY_T)(void);
+
+/*!
+ * \brief Start queueing the touch events.
+ *
+ * The touch panel must have been initialised and powered down, to enable
+ * PENIRQ.
+ *
+ * \param touch Pointer to the XPT2046 touch class.
+ * \param irq_pin Pin PENIRQ is connected to.
+ * \param notify Function called from the interrupt each time an event is
+ *        queued, e.g. to signal a task, or NULL.
+ */
+void touch_input_begin(XPT2046 *touch, uint8_t irq_pin, TOUCH_NOTIFY_T notify);
+
+/*!
+ * \brief Set how each position is read.
+ *
+ * \param reads Reads per position, 1 to #TOUCH_READS_MAX. The median of
+ *        them is used.
+ * \param filter_shift IIR filter, each new position moves the filtered one
+ *        1/2^filter_shift of the way towards it. 0 for no filtering.
+ */
+void touch_input_set_filter(uint8_t reads, uint8_t filter_shift);
+
+/*!
+ * \brief Read the next touch event.
+ *
+ * \param event Pointer to the TOUCH_EVENT_T struct to fill in.
+ *
+ * \result True if there was an event, False if the queue is empty.
+ */
+bool touch_input_read(TOUCH_EVENT_T *event);
+
+/*!
+ * \brief Number of events dropped because the queue was full.
+ *
+ * \param reset True to zero the count after reading it.
+ *
+ * \result The count.
+ */
+uint32_t touch_input_dropped(bool reset);
+
+/*!
+ * \brief Cost of reading the positions.
+ *
+ * \param stats Pointer to the TOUCH_STATS_T struct to fill in.
+ * \param reset True to zero them after reading them.
+ */
+void touch_input_stats(TOUCH_STATS_T *stats, bool reset);
+
+#endif // TOUCH_INPUT_
@@ -1,8 +1,131 @@
 #include "beep.h"
 
-void beepDelay(int delay_ms)
+const BEEP_NOTE_T beep_click[] = {
+  { 2000, 20 },
+  { 0, 0 }
+};
+
+const BEEP_NOTE_T beep_double[] = {
+  { 2000, 60 }, { 0, 60 },
+  { 2000, 60 },
+  { 0, 0 }
+};
+
+// One, two, then three beeps, each time longer and higher.
+const BEEP_NOTE_T beep_alarm[] = {
+  { 1500, 100 }, { 0, 500 },
+  { 1800, 120 }, { 0, 80 },
+  { 1800, 120 }, { 0, 500 },
+  { 2200, 150 }, { 0, 80 },
+  { 2200, 150 }, { 0, 80 },
+  { 2200, 150 }, { 0, 500 },
+  { 2700, 600 },
+  { 0, 0 }
+};
+
+// Note playing, NULL when quiet, and the patterns waiting to play. Only
+// changed by the timer interrupt or with interrupts off.
+static const BEEP_NOTE_T * volatile playing = NULL;
+static const BEEP_NOTE_T *queue[BEEP_QUEUE_SIZE];
+static uint8_t head = 0;
+static uint8_t tail = 0;
+
+// Start a note, or go quiet if there isn't one.
+static void play(const BEEP_NOTE_T *note)
+{
+  uint16_t overflow;
+
+  playing = note;
+  if (!note)
+  {
+    pwmWrite(PWM_PIN, 0);
+    return;
+  }
+
+  if (note->freq)
+  {
+    overflow = Timer1.setPeriod(1000000UL / note->freq);
+    pwmWrite(PWM_PIN, overflow / 2);
+  }
+  else
+  {
+    pwmWrite(PWM_PIN, 0);
+  }
+
+  // The compare interrupt at the end of the period ends the note.
+  overflow = Timer3.setPeriod((uint32_t)note->ms * 1000);
+  Timer3.setCompare(TIMER_CH1, overflow);
+  Timer3.refresh();
+  Timer3.resume();
+}
+
+// Sequencer timer interrupt, the note playing has ended.
+static void beep_note_end()
+{
+  const BEEP_NOTE_T *note = playing;
+
+  Timer3.pause();
+
+  // Stopped after the compare matched but before the interrupt ran.
+  if (!note)
+    return;
+
+  note++;
+  if (!note->ms)
+  {
+    // End of the pattern, on to the next one queued.
+    note = NULL;
+    if (head != tail)
+    {
+      note = queue[tail];
+      tail = (tail + 1) & (BEEP_QUEUE_SIZE - 1);
+    }
+  }
+  play(note);
+}
+
+void beepBegin()
+{
+  pinMode(PWM_PIN, PWM);
+  pwmWrite(PWM_PIN, 0);
+
+  Timer3.pause();
+  Timer3.setChannel1Mode(TIMER_OUTPUT_COMPARE);
+  Timer3.attachCompare1Interrupt(beep_note_end);
+}
+
+void beepPlay(const BEEP_NOTE_T *pattern)
+{
+  uint8_t next;
+
+  if (!pattern || !pattern->ms)
+    return;
+
+  noInterrupts();
+  next = (head + 1) & (BEEP_QUEUE_SIZE - 1);
+  if (!playing)
+  {
+    play(pattern);
+  }
+  else if (next != tail)
+  {
+    queue[head] = pattern;
+    head = next;
+  }
+  interrupts();
+}
+
+void beepStop()
+{
+  noInterrupts();
+  Timer3.pause();
+  Timer3.c_dev()->regs.gen->SR = ~TIMER_SR_CC1IF;   // Drop a pending end.
+  head = tail = 0;
+  play(NULL);
+  interrupts();
+}
+
+bool beepBusy()
 {
-  analogWrite(PWM_PIN, PWM_VALUE);
-  delay(delay_ms);
-  analogWrite(PWM_PIN, 0);
+  return playing != NULL;
 }
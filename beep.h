@@ -1,21 +1,79 @@
 #ifndef BEEP_H_
 #define BEEP_H_
+/*!
+ * \file
+ *
+ * \brief Background tone sequencer for the beeper.
+ *
+ * Plays patterns of notes on #PWM_PIN without waiting for them. Each note
+ * sets the pitch of the PWM and starts a timer, the timer interrupt moves
+ * on to the next note, so beepPlay() returns straight away.
+ *
+ * NOTES:
+ *      - The beeper is driven by Timer 1, its period sets the pitch. The
+ *        notes are timed by Timer 3, which has no output pins in use.
+ *      - Patterns played while one is playing are queued, up to
+ *        #BEEP_QUEUE_SIZE - 1 of them. Any more are dropped.
+ */
 
 #include <arduino.h>
 
-#define PWM_VALUE 200
 #define PWM_PIN 25
 
-static void inline beepOn()
-{
-  analogWrite(PWM_PIN, PWM_VALUE);
-}
+/*!
+ * \defgroup BEEP definitions
+ * \{
+ */
+#define BEEP_QUEUE_SIZE (4)         /*!< Pattern queue size, a power of 2. */
+/*! \} */
 
-static void inline beepOff()
-{
-  analogWrite(PWM_PIN, 0);
-}
+/*!
+ * \brief BEEP_NOTE_T struct for one note of a pattern.
+ *
+ * A pattern is an array of notes ending with one of 0 ms.
+ */
+typedef struct _beep_note {
+  uint16_t freq;        /*!< Pitch in Hz, 0 for a rest. */
+  uint16_t ms;          /*!< Length in ms, 0 ends the pattern. */
+} BEEP_NOTE_T;
 
-void beepDelay(int delay_ms);
+/*!
+ * \brief Short click, for a button press.
+ */
+extern const BEEP_NOTE_T beep_click[];
+
+/*!
+ * \brief Two short beeps.
+ */
+extern const BEEP_NOTE_T beep_double[];
+
+/*!
+ * \brief Alarm melody, getting longer and higher.
+ */
+extern const BEEP_NOTE_T beep_alarm[];
+
+/*!
+ * \brief Set up the beeper pin and the sequencer timer.
+ */
+void beepBegin();
+
+/*!
+ * \brief Play a pattern, after any that are already playing.
+ *
+ * \param pattern The notes, which must stay in memory until played.
+ */
+void beepPlay(const BEEP_NOTE_T *pattern);
+
+/*!
+ * \brief Stop the pattern playing and forget any queued.
+ */
+void beepStop();
+
+/*!
+ * \brief Is a pattern playing.
+ *
+ * \result True if playing.
+ */
+bool beepBusy();
 
 #endif /* BEEP_H_ */
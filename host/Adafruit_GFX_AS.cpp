@@ -0,0 +1,255 @@
+#include "Adafruit_GFX_AS.h"
+
+#include <Font16.h>                 // Font 2 tables, from Adafruit_GFX_AS.
+#include <Font32.h>                 // Font 4 tables, from Adafruit_GFX_AS.
+#include <Font64.h>                 // Font 6 tables, from Adafruit_GFX_AS.
+#include <Font7s.h>                 // Font 7 tables, from Adafruit_GFX_AS.
+
+// Looks up a character in a font. Returns false if the font isn't supported.
+static bool font_lookup(
+  unsigned int uniCode,
+  int size,
+  const uint8_t **data,
+  int *width,
+  int *height
+  )
+{
+  unsigned int idx = uniCode - 32;
+
+  if (uniCode < 32 || idx >= 96)
+    return false;
+
+  switch (size)
+  {
+    case 2:
+      *data = chrtbl_f16[idx];
+      *width = widtbl_f16[idx];
+      *height = chr_hgt_f16;
+      break;
+    case 4:
+      *data = chrtbl_f32[idx];
+      *width = widtbl_f32[idx];
+      *height = chr_hgt_f32;
+      break;
+    case 6:
+      *data = chrtbl_f64[idx];
+      *width = widtbl_f64[idx];
+      *height = chr_hgt_f64;
+      break;
+    case 7:
+      *data = chrtbl_f7s[idx];
+      *width = widtbl_f7s[idx];
+      *height = chr_hgt_f7s;
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+Adafruit_GFX_AS::Adafruit_GFX_AS(int16_t w, int16_t h)
+: WIDTH(w), HEIGHT(h), _width(w), _height(h),
+  textcolor(0xFFFF), textbgcolor(0xFFFF), rotation(0)
+{ }
+
+void Adafruit_GFX_AS::drawFastVLine(int16_t x, int16_t y, int16_t h,
+  uint16_t color)
+{
+  for (int16_t idx=0; idx < h; idx++)
+  {
+    drawPixel(x, y + idx, color);
+  }
+}
+
+void Adafruit_GFX_AS::drawFastHLine(int16_t x, int16_t y, int16_t w,
+  uint16_t color)
+{
+  for (int16_t idx=0; idx < w; idx++)
+  {
+    drawPixel(x + idx, y, color);
+  }
+}
+
+void Adafruit_GFX_AS::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+  uint16_t color)
+{
+  for (int16_t idx=0; idx < w; idx++)
+  {
+    drawFastVLine(x + idx, y, h, color);
+  }
+}
+
+void Adafruit_GFX_AS::fillScreen(uint16_t color)
+{
+  fillRect(0, 0, _width, _height, color);
+}
+
+void Adafruit_GFX_AS::setRotation(uint8_t r)
+{
+  rotation = r & 3;
+  if (rotation & 1)
+  {
+    _width = HEIGHT;
+    _height = WIDTH;
+  }
+  else
+  {
+    _width = WIDTH;
+    _height = HEIGHT;
+  }
+}
+
+void Adafruit_GFX_AS::drawRect(int16_t x, int16_t y, int16_t w, int16_t h,
+  uint16_t color)
+{
+  drawFastHLine(x, y, w, color);
+  drawFastHLine(x, y + h - 1, w, color);
+  drawFastVLine(x, y, h, color);
+  drawFastVLine(x + w - 1, y, h, color);
+}
+
+void Adafruit_GFX_AS::setTextColor(uint16_t c)
+{
+  textcolor = c;
+  textbgcolor = c;
+}
+
+void Adafruit_GFX_AS::setTextColor(uint16_t c, uint16_t bg)
+{
+  textcolor = c;
+  textbgcolor = bg;
+}
+
+int Adafruit_GFX_AS::drawChar(char c, int x, int y, int size)
+{
+  return drawUnicode((uint8_t)c, x, y, size);
+}
+
+int Adafruit_GFX_AS::drawUnicode(unsigned int uniCode, int x, int y, int size)
+{
+  const uint8_t *data;
+  int width, height;
+
+  if (!font_lookup(uniCode, size, &data, &width, &height))
+    return 0;
+
+  if (size == 2)
+  {
+    // Rows of bits, MSB on the left. The width includes a column of gap.
+    int w = (width + 6) / 8;
+
+    if (textcolor != textbgcolor)
+    {
+      setAddrWindow(x, y, x + (w * 8) - 1, y + height - 1);
+    }
+    for (int row=0; row < height; row++)
+    {
+      for (int col=0; col < w; col++)
+      {
+        uint8_t line = *data++;
+
+        for (int bit=0; bit < 8; bit++)
+        {
+          bool set = line & (0x80 >> bit);
+
+          if (textcolor != textbgcolor)
+          {
+            pushColor(set ? textcolor : textbgcolor);
+          }
+          else if (set)
+          {
+            drawPixel(x + (col * 8) + bit, y + row, textcolor);
+          }
+        }
+      }
+    }
+  }
+  else
+  {
+    // Each byte is a run of 1 to 128 pixels, foreground if bit 7 is set.
+    int pixels = width * height;
+    int pos = 0;
+
+    if (textcolor != textbgcolor)
+    {
+      setAddrWindow(x, y, x + width - 1, y + height - 1);
+    }
+    while (pos < pixels)
+    {
+      uint8_t run = *data++;
+      int len = min((run & 0x7F) + 1, pixels - pos);
+
+      if (textcolor != textbgcolor)
+      {
+        for (int idx=0; idx < len; idx++)
+        {
+          pushColor((run & 0x80) ? textcolor : textbgcolor);
+        }
+      }
+      else if (run & 0x80)
+      {
+        // A run can carry on to the next row.
+        int end = pos + len;
+
+        for (int start=pos; start < end; )
+        {
+          int row = start / width;
+          int col = start % width;
+          int count = min(end - start, width - col);
+
+          drawFastHLine(x + col, y + row, count, textcolor);
+          start += count;
+        }
+      }
+      pos += len;
+    }
+  }
+  return width;
+}
+
+int Adafruit_GFX_AS::drawString(const char *string, int poX, int poY, int size)
+{
+  int sumX = 0;
+
+  while (*string)
+  {
+    int xPlus = drawChar(*string++, poX, poY, size);
+
+    sumX += xPlus;
+    poX += xPlus;
+  }
+  return sumX;
+}
+
+int Adafruit_GFX_AS::drawCentreString(const char *string, int dX, int poY,
+  int size)
+{
+  int poX = max(dX - (textWidth(string, size) / 2), 0);
+
+  return drawString(string, poX, poY, size);
+}
+
+int Adafruit_GFX_AS::drawRightString(const char *string, int dX, int poY,
+  int size)
+{
+  int poX = max(dX - textWidth(string, size), 0);
+
+  return drawString(string, poX, poY, size);
+}
+
+int16_t Adafruit_GFX_AS::textWidth(const char *string, int16_t font)
+{
+  int16_t length = 0;
+
+  while (*string)
+  {
+    const uint8_t *data;
+    int width, height;
+
+    if (font_lookup((uint8_t)*string++, font, &data, &width, &height))
+    {
+      length += width;
+    }
+  }
+  return length;
+}
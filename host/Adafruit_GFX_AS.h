@@ -0,0 +1,125 @@
+#ifndef ADAFRUIT_GFX_AS_H_
+#define ADAFRUIT_GFX_AS_H_
+/*!
+ * \file
+ *
+ * \brief Host stand-in for the Adafruit_GFX_AS graphics library.
+ *
+ * The drawing the sketch uses, broken down into calls on the display the
+ * same way the library does it, so that the ILI9341 stand-in counts what
+ * the target would send.
+ *
+ * NOTES:
+ *      - Fonts 2, 4, 6 and 7 are drawn from the library's own font tables,
+ *        see GFX_AS_DIR in the Makefile. Font 1 and text sizes other than 1
+ *        aren't supported.
+ *      - A character drawn with its background is one address window with
+ *        every pixel pushed. Without a background, font 2 is drawn a pixel
+ *        at a time and the run length encoded fonts a run at a time.
+ *      - Strings are const, so the sketch's string literals can be passed.
+ */
+
+#include <Arduino.h>
+
+/*!
+ * \brief Adafruit_GFX_AS class - text and shapes on a display.
+ */
+class Adafruit_GFX_AS
+{
+public:
+  /*!
+   * \brief Adafruit_GFX_AS constructor.
+   *
+   * \param w Width of the display with no rotation.
+   * \param h Height of the display with no rotation.
+   */
+  Adafruit_GFX_AS(int16_t w, int16_t h);
+  virtual ~Adafruit_GFX_AS() {}
+
+  // Done by the display.
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+  virtual void setAddrWindow(
+    uint16_t x0,
+    uint16_t y0,
+    uint16_t x1,
+    uint16_t y1
+    ) = 0;
+  virtual void pushColor(uint16_t color) = 0;
+
+  // Done with drawPixel() unless the display does better.
+  virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  virtual void fillRect(
+    int16_t x,
+    int16_t y,
+    int16_t w,
+    int16_t h,
+    uint16_t color
+    );
+  virtual void fillScreen(uint16_t color);
+  virtual void setRotation(uint8_t r);
+
+  /*!
+   * \brief Draw a rectangle outline as 4 lines.
+   */
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+  /*!
+   * \brief Set the text colour, drawn without a background.
+   */
+  void setTextColor(uint16_t c);
+
+  /*!
+   * \brief Set the text colour and background colour.
+   */
+  void setTextColor(uint16_t c, uint16_t bg);
+
+  /*!
+   * \brief Draw a character.
+   *
+   * \result Width of the character, 0 if the font isn't supported.
+   */
+  int drawChar(char c, int x, int y, int size);
+  int drawUnicode(unsigned int uniCode, int x, int y, int size);
+
+  /*!
+   * \brief Draw a string.
+   *
+   * \result Width of the string.
+   */
+  int drawString(const char *string, int poX, int poY, int size);
+
+  /*!
+   * \brief Draw a string centred on 'dX', but not off the left edge.
+   *
+   * \result Width of the string.
+   */
+  int drawCentreString(const char *string, int dX, int poY, int size);
+
+  /*!
+   * \brief Draw a string ending at 'dX'.
+   *
+   * \result Width of the string.
+   */
+  int drawRightString(const char *string, int dX, int poY, int size);
+
+  /*!
+   * \brief Width of a string in a font.
+   */
+  int16_t textWidth(const char *string, int16_t font);
+
+  int16_t width(void) const { return _width; }
+  int16_t height(void) const { return _height; }
+  uint8_t getRotation(void) const { return rotation; }
+
+protected:
+  const int16_t WIDTH;      // Size with no rotation.
+  const int16_t HEIGHT;
+  int16_t _width;           // Size with the current rotation.
+  int16_t _height;
+  uint16_t textcolor;
+  uint16_t textbgcolor;
+  uint8_t rotation;
+};
+
+#endif // ADAFRUIT_GFX_AS_H_
@@ -0,0 +1,298 @@
+#include "Adafruit_ILI9341_STM.h"
+
+static const char *call_names[TFT_CALLS] = {
+  "drawPixel",
+  "drawFastHLine",
+  "drawFastVLine",
+  "fillRect",
+  "fillScreen",
+  "drawRect",
+  "drawChar",
+  "drawString",
+  "setAddrWindow",
+  "pushColor",
+  "pushColors"
+};
+
+Adafruit_ILI9341_STM::Adafruit_ILI9341_STM(int8_t, int8_t, int8_t)
+: Adafruit_GFX_AS(ILI9341_TFTWIDTH, ILI9341_TFTHEIGHT),
+  win_x0(0), win_y0(0), win_x1(0), win_y1(0), cur_x(0), cur_y(0),
+  depth(0), current(0), call_bytes(0)
+{
+  memset(framebuffer, 0, sizeof(framebuffer));
+  memset(&stats, 0, sizeof(stats));
+}
+
+// Calls made from within another call are counted against the outermost
+// one, which moves simulated time on once it returns.
+void Adafruit_ILI9341_STM::startCall(uint8_t call)
+{
+  if (depth++ == 0)
+  {
+    current = call;
+    call_bytes = 0;
+    stats.total.calls++;
+    stats.call[call].calls++;
+  }
+}
+
+void Adafruit_ILI9341_STM::endCall(void)
+{
+  if (--depth == 0)
+  {
+    host_advance_ns(busTimeNs(call_bytes, ILI9341_SPI_HZ));
+  }
+}
+
+void Adafruit_ILI9341_STM::countWindow(void)
+{
+  stats.total.windows++;
+  stats.total.bytes += ILI9341_WINDOW_BYTES;
+  stats.call[current].windows++;
+  stats.call[current].bytes += ILI9341_WINDOW_BYTES;
+  call_bytes += ILI9341_WINDOW_BYTES;
+}
+
+void Adafruit_ILI9341_STM::countPixels(uint32_t count)
+{
+  stats.total.pixels += count;
+  stats.total.bytes += count * 2;
+  stats.call[current].pixels += count;
+  stats.call[current].bytes += count * 2;
+  call_bytes += count * 2;
+}
+
+// Sets the address window, with the pixels going to its top left corner.
+void Adafruit_ILI9341_STM::window(int16_t x0, int16_t y0, int16_t x1,
+  int16_t y1)
+{
+  win_x0 = x0;
+  win_y0 = y0;
+  win_x1 = x1;
+  win_y1 = y1;
+  cur_x = x0;
+  cur_y = y0;
+  countWindow();
+}
+
+// Writes a pixel to the address window, a row at a time, wrapping back to
+// the top when it is full.
+void Adafruit_ILI9341_STM::push(uint16_t color)
+{
+  if (cur_x >= 0 && cur_x < _width && cur_y >= 0 && cur_y < _height)
+  {
+    framebuffer[(cur_y * _width) + cur_x] = color;
+  }
+  if (++cur_x > win_x1)
+  {
+    cur_x = win_x0;
+    if (++cur_y > win_y1)
+    {
+      cur_y = win_y0;
+    }
+  }
+}
+
+void Adafruit_ILI9341_STM::begin(void)
+{
+  memset(framebuffer, 0, sizeof(framebuffer));
+}
+
+void Adafruit_ILI9341_STM::setRotation(uint8_t r)
+{
+  Adafruit_GFX_AS::setRotation(r);
+}
+
+void Adafruit_ILI9341_STM::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+  startCall(TFT_DRAW_PIXEL);
+  if (x >= 0 && x < _width && y >= 0 && y < _height)
+  {
+    window(x, y, x, y);
+    push(color);
+    countPixels(1);
+  }
+  endCall();
+}
+
+void Adafruit_ILI9341_STM::drawFastVLine(int16_t x, int16_t y, int16_t h,
+  uint16_t color)
+{
+  startCall(TFT_DRAW_VLINE);
+  fillRect(x, y, 1, h, color);
+  endCall();
+}
+
+void Adafruit_ILI9341_STM::drawFastHLine(int16_t x, int16_t y, int16_t w,
+  uint16_t color)
+{
+  startCall(TFT_DRAW_HLINE);
+  fillRect(x, y, w, 1, color);
+  endCall();
+}
+
+void Adafruit_ILI9341_STM::fillRect(int16_t x, int16_t y, int16_t w,
+  int16_t h, uint16_t color)
+{
+  int16_t x1 = min(x + w, (int)_width);
+  int16_t y1 = min(y + h, (int)_height);
+
+  x = max(x, (int16_t)0);
+  y = max(y, (int16_t)0);
+
+  startCall(TFT_FILL_RECT);
+  if (x < x1 && y < y1)
+  {
+    int pixels = (x1 - x) * (y1 - y);
+
+    window(x, y, x1 - 1, y1 - 1);
+    for (int idx=0; idx < pixels; idx++)
+    {
+      push(color);
+    }
+    countPixels(pixels);
+  }
+  endCall();
+}
+
+void Adafruit_ILI9341_STM::fillScreen(uint16_t color)
+{
+  startCall(TFT_FILL_SCREEN);
+  fillRect(0, 0, _width, _height, color);
+  endCall();
+}
+
+void Adafruit_ILI9341_STM::setAddrWindow(uint16_t x0, uint16_t y0,
+  uint16_t x1, uint16_t y1)
+{
+  startCall(TFT_SET_ADDR_WINDOW);
+  window(x0, y0, x1, y1);
+  endCall();
+}
+
+void Adafruit_ILI9341_STM::pushColor(uint16_t color)
+{
+  startCall(TFT_PUSH_COLOR);
+  push(color);
+  countPixels(1);
+  endCall();
+}
+
+void Adafruit_ILI9341_STM::pushColors(void *colorBuffer, uint16_t nr_pixels,
+  uint8_t)
+{
+  const uint16_t *colors = (const uint16_t *)colorBuffer;
+
+  startCall(TFT_PUSH_COLORS);
+  for (uint16_t idx=0; idx < nr_pixels; idx++)
+  {
+    push(colors[idx]);
+  }
+  countPixels(nr_pixels);
+  endCall();
+}
+
+void Adafruit_ILI9341_STM::drawRect(int16_t x, int16_t y, int16_t w,
+  int16_t h, uint16_t color)
+{
+  startCall(TFT_DRAW_RECT);
+  Adafruit_GFX_AS::drawRect(x, y, w, h, color);
+  endCall();
+}
+
+int Adafruit_ILI9341_STM::drawChar(char c, int x, int y, int size)
+{
+  int width;
+
+  startCall(TFT_DRAW_CHAR);
+  width = Adafruit_GFX_AS::drawChar(c, x, y, size);
+  endCall();
+  return width;
+}
+
+int Adafruit_ILI9341_STM::drawString(const char *string, int poX, int poY,
+  int size)
+{
+  int width;
+
+  startCall(TFT_DRAW_STRING);
+  width = Adafruit_GFX_AS::drawString(string, poX, poY, size);
+  endCall();
+  return width;
+}
+
+int Adafruit_ILI9341_STM::drawCentreString(const char *string, int dX,
+  int poY, int size)
+{
+  int width;
+
+  startCall(TFT_DRAW_STRING);
+  width = Adafruit_GFX_AS::drawCentreString(string, dX, poY, size);
+  endCall();
+  return width;
+}
+
+int Adafruit_ILI9341_STM::drawRightString(const char *string, int dX,
+  int poY, int size)
+{
+  int width;
+
+  startCall(TFT_DRAW_STRING);
+  width = Adafruit_GFX_AS::drawRightString(string, dX, poY, size);
+  endCall();
+  return width;
+}
+
+uint16_t Adafruit_ILI9341_STM::color565(uint8_t r, uint8_t g, uint8_t b)
+{
+  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+uint16_t Adafruit_ILI9341_STM::readPixel(int16_t x, int16_t y) const
+{
+  if (x < 0 || x >= _width || y < 0 || y >= _height)
+    return 0;
+
+  return framebuffer[(y * _width) + x];
+}
+
+void Adafruit_ILI9341_STM::getStats(TFT_STATS_T *stats_out, bool reset)
+{
+  *stats_out = stats;
+  if (reset)
+  {
+    memset(&stats, 0, sizeof(stats));
+  }
+}
+
+bool Adafruit_ILI9341_STM::writePPM(const char *path) const
+{
+  FILE *file = fopen(path, "wb");
+
+  if (!file)
+    return false;
+
+  fprintf(file, "P6\n%d %d\n255\n", _width, _height);
+  for (int idx=0; idx < _width * _height; idx++)
+  {
+    uint16_t pixel = framebuffer[idx];
+    uint8_t rgb[3];
+
+    // Scale each component to 8 bits, so white is 255.
+    rgb[0] = ((pixel >> 11) * 255) / 31;
+    rgb[1] = (((pixel >> 5) & 0x3F) * 255) / 63;
+    rgb[2] = ((pixel & 0x1F) * 255) / 31;
+    fwrite(rgb, 1, sizeof(rgb), file);
+  }
+  return fclose(file) == 0;
+}
+
+const char *Adafruit_ILI9341_STM::callName(uint8_t call)
+{
+  return (call < TFT_CALLS) ? call_names[call] : "?";
+}
+
+uint64_t Adafruit_ILI9341_STM::busTimeNs(uint32_t bytes, uint32_t clock_hz)
+{
+  return ((uint64_t)bytes * 8 * 1000000000ULL) / clock_hz;
+}
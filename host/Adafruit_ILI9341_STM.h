@@ -0,0 +1,206 @@
+#ifndef ADAFRUIT_ILI9341_STM_H_
+#define ADAFRUIT_ILI9341_STM_H_
+/*!
+ * \file
+ *
+ * \brief Host stand-in for the Adafruit_ILI9341_STM display library.
+ *
+ * Draws into a 320x240 RGB565 framebuffer instead of the display, and
+ * counts what every call would have sent on the SPI bus. The framebuffer
+ * can be saved as a PPM image.
+ *
+ * NOTES:
+ *      - An address window is the column, row and memory write commands and
+ *        their parameters, #ILI9341_WINDOW_BYTES bytes. Each pixel is 2
+ *        bytes. Commands sent by begin() and setRotation() aren't counted.
+ *      - The costs are counted against the call the sketch made, e.g. the
+ *        windows and pixels of each character of a drawString() are counted
+ *        against drawString().
+ *      - Each call moves simulated time on by how long the bytes it sent
+ *        keep the bus busy at #ILI9341_SPI_HZ. The time taken between bytes
+ *        and by the CPU isn't included.
+ *      - Lines and fills are clipped to the screen. The pixels of a window
+ *        that are off the screen are counted but not drawn.
+ *      - The framebuffer is kept the way round the current rotation has it,
+ *        the panel's own scan order isn't modelled.
+ */
+
+#include <Adafruit_GFX_AS.h>
+
+/*!
+ * \defgroup ILI9341 definitions
+ * \{
+ */
+#define ILI9341_TFTWIDTH (240)      /*!< Width with no rotation. */
+#define ILI9341_TFTHEIGHT (320)     /*!< Height with no rotation. */
+#define ILI9341_WINDOW_BYTES (11)   /*!< SPI bytes to set an address window. */
+#define ILI9341_SPI_HZ (36000000UL) /*!< SPI1 clock, 72MHz / 2. */
+/*! \} */
+
+/*!
+ * \defgroup ILI9341_COLOURS RGB565 colours
+ * \{
+ */
+#define ILI9341_BLACK       0x0000
+#define ILI9341_NAVY        0x000F
+#define ILI9341_DARKGREEN   0x03E0
+#define ILI9341_DARKCYAN    0x03EF
+#define ILI9341_MAROON      0x7800
+#define ILI9341_PURPLE      0x780F
+#define ILI9341_OLIVE       0x7BE0
+#define ILI9341_LIGHTGREY   0xC618
+#define ILI9341_DARKGREY    0x7BEF
+#define ILI9341_BLUE        0x001F
+#define ILI9341_GREEN       0x07E0
+#define ILI9341_CYAN        0x07FF
+#define ILI9341_RED         0xF800
+#define ILI9341_MAGENTA     0xF81F
+#define ILI9341_YELLOW      0xFFE0
+#define ILI9341_WHITE       0xFFFF
+#define ILI9341_ORANGE      0xFD20
+#define ILI9341_GREENYELLOW 0xAFE5
+#define ILI9341_PINK        0xF81F
+/*! \} */
+
+/*!
+ * \brief The calls the costs are counted against.
+ */
+typedef enum _tft_call {
+  TFT_DRAW_PIXEL,
+  TFT_DRAW_HLINE,
+  TFT_DRAW_VLINE,
+  TFT_FILL_RECT,
+  TFT_FILL_SCREEN,
+  TFT_DRAW_RECT,
+  TFT_DRAW_CHAR,
+  TFT_DRAW_STRING,              /*!< drawString() and the centred and right
+                                     aligned strings. */
+  TFT_SET_ADDR_WINDOW,
+  TFT_PUSH_COLOR,
+  TFT_PUSH_COLORS,
+  TFT_CALLS                     /*!< Number of calls counted. */
+} TFT_CALL_T;
+
+/*!
+ * \brief TFT_COST_T struct for what calls sent on the SPI bus.
+ */
+typedef struct _tft_cost {
+  uint32_t calls;               /*!< Calls made. */
+  uint32_t windows;             /*!< Address windows set. */
+  uint32_t pixels;              /*!< Pixels written. */
+  uint32_t bytes;               /*!< Bytes sent on the SPI bus. */
+} TFT_COST_T;
+
+/*!
+ * \brief TFT_STATS_T struct for the costs of each call and in total.
+ */
+typedef struct _tft_stats {
+  TFT_COST_T total;             /*!< All the calls. */
+  TFT_COST_T call[TFT_CALLS];   /*!< Each call, indexed by #TFT_CALL_T. */
+} TFT_STATS_T;
+
+/*!
+ * \brief Adafruit_ILI9341_STM class - an ILI9341 display in memory.
+ */
+class Adafruit_ILI9341_STM : public Adafruit_GFX_AS
+{
+  uint16_t framebuffer[ILI9341_TFTWIDTH * ILI9341_TFTHEIGHT];
+  int16_t win_x0, win_y0, win_x1, win_y1;
+  int16_t cur_x, cur_y;
+  TFT_STATS_T stats;
+  uint8_t depth;                // Calls made from within a call.
+  uint8_t current;              // Outermost call.
+  uint32_t call_bytes;          // Bytes sent by the outermost call.
+
+  void startCall(uint8_t call);
+  void endCall(void);
+  void countWindow(void);
+  void countPixels(uint32_t count);
+  void window(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+  void push(uint16_t color);
+
+public:
+  /*!
+   * \brief Adafruit_ILI9341_STM constructor, the pins aren't used.
+   */
+  Adafruit_ILI9341_STM(int8_t cs, int8_t dc, int8_t rst = -1);
+
+  /*!
+   * \brief Initialise the display, clearing the framebuffer to black.
+   */
+  void begin(void);
+
+  void setRotation(uint8_t r);
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void fillScreen(uint16_t color);
+  void setAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+  void pushColor(uint16_t color);
+
+  /*!
+   * \brief Write pixels to the address window.
+   *
+   * \param colorBuffer The RGB565 pixels.
+   * \param nr_pixels Number of pixels.
+   * \param async Ignored, the pixels are written before it returns.
+   */
+  void pushColors(void *colorBuffer, uint16_t nr_pixels, uint8_t async = 0);
+
+  // Counted against the call, see TFT_CALL_T.
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  int drawChar(char c, int x, int y, int size);
+  int drawString(const char *string, int poX, int poY, int size);
+  int drawCentreString(const char *string, int dX, int poY, int size);
+  int drawRightString(const char *string, int dX, int poY, int size);
+
+  /*!
+   * \brief Convert 8 bit red, green and blue to RGB565.
+   */
+  static uint16_t color565(uint8_t r, uint8_t g, uint8_t b);
+
+  /*!
+   * \brief Read a pixel from the framebuffer.
+   *
+   * \result The RGB565 colour, or 0 if it is off the screen.
+   */
+  uint16_t readPixel(int16_t x, int16_t y) const;
+
+  /*!
+   * \brief Read what the calls have cost on the SPI bus.
+   *
+   * \param stats_out Pointer to the TFT_STATS_T struct which will contain
+   *        the costs since they were last reset.
+   * \param reset True to reset the costs once they have been read.
+   */
+  void getStats(TFT_STATS_T *stats_out, bool reset);
+
+  /*!
+   * \brief Save the framebuffer as a binary PPM image.
+   *
+   * \param path File to write.
+   *
+   * \result True if it was written.
+   */
+  bool writePPM(const char *path) const;
+
+  /*!
+   * \brief Name of a call, for printing the costs.
+   *
+   * \param call One of #TFT_CALL_T.
+   */
+  static const char *callName(uint8_t call);
+
+  /*!
+   * \brief Time the SPI bus is busy sending some bytes.
+   *
+   * \param bytes Bytes sent, 8 clocks each.
+   * \param clock_hz The SPI clock rate e.g. #ILI9341_SPI_HZ.
+   *
+   * \result Bus time in nanoseconds.
+   */
+  static uint64_t busTimeNs(uint32_t bytes, uint32_t clock_hz);
+};
+
+#endif // ADAFRUIT_ILI9341_STM_H_
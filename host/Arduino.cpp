@@ -0,0 +1,143 @@
+#include "Arduino.h"
+
+HostSerial Serial;
+
+// Simulated time since the start.
+static uint64_t now_ns = 0;
+
+unsigned long millis(void)
+{
+  return (unsigned long)(now_ns / 1000000ULL);
+}
+
+unsigned long micros(void)
+{
+  return (unsigned long)(now_ns / 1000ULL);
+}
+
+void delay(unsigned long ms)
+{
+  now_ns += ms * 1000000ULL;
+}
+
+void delayMicroseconds(uint32_t us)
+{
+  now_ns += us * 1000ULL;
+}
+
+uint64_t host_time_ns(void)
+{
+  return now_ns;
+}
+
+void host_advance_ns(uint64_t ns)
+{
+  now_ns += ns;
+}
+
+void HostSerial::print(const char *str)
+{
+  fputs(str, stdout);
+}
+
+void HostSerial::print(char c)
+{
+  putchar(c);
+}
+
+void HostSerial::print(long val, int base)
+{
+  if (base == DEC)
+    printf("%ld", val);
+  else
+    print((unsigned long)val, base);
+}
+
+void HostSerial::print(unsigned long val, int base)
+{
+  printf(base == HEX ? "%lX" : "%lu", val);
+}
+
+void HostSerial::print(double val, int digits)
+{
+  printf("%.*f", digits, val);
+}
+
+// Pin state, only so that digitalRead() reads back what was written.
+static uint8_t pin_modes[HOST_PINS];
+static uint8_t pin_values[HOST_PINS];
+static voidFuncPtr pin_handlers[HOST_PINS];
+
+void pinMode(uint8_t pin, WiringPinMode mode)
+{
+  if (pin < HOST_PINS)
+  {
+    pin_modes[pin] = mode;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  if (pin < HOST_PINS)
+  {
+    pin_values[pin] = val ? HIGH : LOW;
+  }
+}
+
+uint32_t digitalRead(uint8_t pin)
+{
+  if (pin >= HOST_PINS)
+    return LOW;
+
+  switch (pin_modes[pin])
+  {
+    case OUTPUT:
+    case OUTPUT_OPEN_DRAIN:
+      return pin_values[pin];
+    default:
+      return HIGH;
+  }
+}
+
+void pwmWrite(uint8_t, uint16_t)
+{ }
+
+void analogWrite(uint8_t, int)
+{ }
+
+void attachInterrupt(uint8_t pin, voidFuncPtr handler, ExtIntTriggerMode)
+{
+  if (pin < HOST_PINS)
+  {
+    pin_handlers[pin] = handler;
+  }
+}
+
+void detachInterrupt(uint8_t pin)
+{
+  if (pin < HOST_PINS)
+  {
+    pin_handlers[pin] = NULL;
+  }
+}
+
+HardwareTimer Timer1(1);
+HardwareTimer Timer2(2);
+HardwareTimer Timer3(3);
+HardwareTimer Timer4(4);
+
+HardwareTimer::HardwareTimer(uint8_t)
+: prescaler(1), overflow(0xFFFF), running(false), compare1(NULL)
+{
+  reg_map.SR = 0;
+  dev.regs.gen = &reg_map;
+}
+
+uint16_t HardwareTimer::setPeriod(uint32_t microseconds)
+{
+  uint32_t cycles = microseconds * CYCLES_PER_MICROSECOND;
+
+  prescaler = (uint16_t)((cycles >> 16) + 1);
+  overflow = (uint16_t)((cycles + (prescaler / 2)) / prescaler);
+  return overflow;
+}
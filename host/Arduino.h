@@ -0,0 +1,232 @@
+#ifndef ARDUINO_H_
+#define ARDUINO_H_
+/*!
+ * \file
+ *
+ * \brief Host stand-in for the Arduino STM32 core.
+ *
+ * Just enough of the core for the sketch's modules to build and run on
+ * Linux, see the Makefile in this directory.
+ *
+ * NOTES:
+ *      - Time is simulated. millis() and micros() only move on when delay(),
+ *        delayMicroseconds() or host_advance_ns() are called, or a transfer
+ *        is made on the host Wire, so every run gives the same results.
+ *      - Serial writes to stdout.
+ *      - Pins, PWM and timers only keep their settings. Timer and pin
+ *        interrupts are attached but never fired.
+ *      - Only the declarations C can use are made to C files, such as the
+ *        Adafruit_GFX_AS font tables.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define HIGH (1)
+#define LOW (0)
+
+#define DEC (10)
+#define HEX (16)
+
+#define CYCLES_PER_MICROSECOND (72)
+
+typedef uint8_t byte;
+typedef void (*voidFuncPtr)(void);
+
+#ifdef __cplusplus
+
+#ifndef min
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define abs(x) ((x) > 0 ? (x) : -(x))
+#define constrain(amt, low, high) \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+/*!
+ * \brief Milliseconds of simulated time since the start.
+ */
+unsigned long millis(void);
+
+/*!
+ * \brief Microseconds of simulated time since the start.
+ */
+unsigned long micros(void);
+
+/*!
+ * \brief Move simulated time on by 'ms' milliseconds.
+ */
+void delay(unsigned long ms);
+
+/*!
+ * \brief Move simulated time on by 'us' microseconds.
+ */
+void delayMicroseconds(uint32_t us);
+
+/*!
+ * \brief Interrupts are never taken on the host, so these do nothing.
+ */
+static inline void noInterrupts(void) {}
+static inline void interrupts(void) {}
+
+/*!
+ * \brief Simulated time since the start, in nanoseconds.
+ */
+uint64_t host_time_ns(void);
+
+/*!
+ * \brief Move simulated time on by 'ns' nanoseconds.
+ */
+void host_advance_ns(uint64_t ns);
+
+/*!
+ * \brief HostSerial class, the Serial port on stdout.
+ */
+class HostSerial
+{
+public:
+  void begin(unsigned long) {}
+  void flush(void) { fflush(stdout); }
+
+  void print(const char *str);
+  void print(char c);
+  void print(long val, int base=DEC);
+  void print(unsigned long val, int base=DEC);
+  void print(int val, int base=DEC) { print((long)val, base); }
+  void print(unsigned int val, int base=DEC) { print((unsigned long)val, base); }
+  void print(double val, int digits=2);
+
+  void println(void) { print("\n"); }
+  template<class T> void println(T val) { print(val); println(); }
+  template<class T> void println(T val, int format)
+  {
+    print(val, format);
+    println();
+  }
+};
+
+extern HostSerial Serial;
+
+/*!
+ * \brief Pin modes, as WiringPinMode.
+ */
+typedef enum WiringPinMode {
+  OUTPUT,
+  OUTPUT_OPEN_DRAIN,
+  INPUT,
+  INPUT_ANALOG,
+  INPUT_PULLUP,
+  INPUT_PULLDOWN,
+  INPUT_FLOATING,
+  PWM,
+  PWM_OPEN_DRAIN
+} WiringPinMode;
+
+/*!
+ * \brief Pin interrupt edges, as ExtIntTriggerMode.
+ */
+typedef enum ExtIntTriggerMode {
+  RISING,
+  FALLING,
+  CHANGE
+} ExtIntTriggerMode;
+
+#define HOST_PINS (44)              /*!< Pins on the Maple Mini. */
+
+void pinMode(uint8_t pin, WiringPinMode mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+
+/*!
+ * \brief Read a pin, the last value written or HIGH if it is an input.
+ */
+uint32_t digitalRead(uint8_t pin);
+
+void pwmWrite(uint8_t pin, uint16_t duty_cycle);
+void analogWrite(uint8_t pin, int duty_cycle);
+void attachInterrupt(uint8_t pin, voidFuncPtr handler, ExtIntTriggerMode mode);
+void detachInterrupt(uint8_t pin);
+
+/*!
+ * \defgroup TIMER definitions, as libmaple.
+ * \{
+ */
+#define TIMER_CH1 (1)
+#define TIMER_CH2 (2)
+#define TIMER_CH3 (3)
+#define TIMER_CH4 (4)
+#define TIMER_SR_CC1IF (1U << 1)
+/*! \} */
+
+/*!
+ * \brief Timer modes, as timer_mode.
+ */
+typedef enum timer_mode {
+  TIMER_DISABLED,
+  TIMER_PWM,
+  TIMER_OUTPUT_COMPARE
+} timer_mode;
+
+/*!
+ * \brief The timer registers the sketch uses.
+ */
+typedef struct timer_gen_reg_map {
+  volatile uint32_t SR;         /*!< Status register. */
+} timer_gen_reg_map;
+
+/*!
+ * \brief timer_dev struct, a timer's registers.
+ */
+typedef struct timer_dev {
+  union {
+    timer_gen_reg_map *gen;     /*!< General purpose timer registers. */
+  } regs;
+} timer_dev;
+
+/*!
+ * \brief HardwareTimer class, a timer that keeps its settings.
+ */
+class HardwareTimer
+{
+  timer_gen_reg_map reg_map;
+  timer_dev dev;
+  uint16_t prescaler;
+  uint16_t overflow;
+  bool running;
+  voidFuncPtr compare1;
+public:
+  HardwareTimer(uint8_t timer_num);
+
+  void pause(void) { running = false; }
+  void resume(void) { running = true; }
+  void refresh(void) {}
+  void setChannel1Mode(timer_mode) {}
+  void setCompare(int, uint16_t) {}
+  void attachCompare1Interrupt(voidFuncPtr handler) { compare1 = handler; }
+  void detachCompare1Interrupt(void) { compare1 = NULL; }
+  timer_dev *c_dev(void) { return &dev; }
+
+  /*!
+   * \brief Set the period as libmaple does, from the 72MHz clock.
+   *
+   * \result The overflow value for the period.
+   */
+  uint16_t setPeriod(uint32_t microseconds);
+
+  /*!
+   * \brief Is the timer running.
+   */
+  bool isRunning(void) const { return running; }
+};
+
+extern HardwareTimer Timer1;
+extern HardwareTimer Timer2;
+extern HardwareTimer Timer3;
+extern HardwareTimer Timer4;
+
+#endif // __cplusplus
+
+#endif // ARDUINO_H_
@@ -0,0 +1,326 @@
+#include "DS3231_Emulator.h"
+
+static const uint64_t NS_PER_SECOND = 1000000000ULL;
+static const int64_t AGING_PER_LSB = 10000000;  // 0.1ppm.
+
+// Control Register (0x0E) bits.
+static const uint8_t CTRL_CONV = 0x20;
+static const uint8_t CTRL_RS = 0x18;
+static const uint8_t CTRL_INTCN = 0x04;
+
+// Status Register (0x0F) bits.
+static const uint8_t STAT_OSF = 0x80;
+static const uint8_t STAT_EN32KHZ = 0x08;
+static const uint8_t STAT_BSY = 0x04;
+static const uint8_t STAT_FLAGS = 0x83;     // OSF, A2F and A1F.
+
+// Bits of each register that can be written, the rest read as 0. The
+// temperature registers can't be written at all.
+static const uint8_t WRITABLE[DS3231_REGS] = {
+  0x7F, 0x7F, 0x7F, 0x07, 0x3F, 0x9F, 0xFF,     // Time and date.
+  0xFF, 0xFF, 0xFF, 0xFF,                       // Alarm 1.
+  0xFF, 0xFF, 0xFF,                             // Alarm 2.
+  0xFF, 0x8B, 0xFF,                             // Control, Status, Aging.
+  0x00, 0x00                                    // Temperature.
+};
+
+// Days in each month, February is fixed up for leap years.
+static const uint8_t MONTH_DAYS[12] = {
+  31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+};
+
+static uint8_t bcd2dec(uint8_t val)
+{
+  return (val >> 4) * 10 + (val & 0x0F);
+}
+
+static uint8_t dec2bcd(uint8_t val)
+{
+  return ((val / 10) << 4) | (val % 10);
+}
+
+// Counts the BCD register 'val' on from 'first' to 'last' and back round.
+// Returns true when it wraps.
+static bool count_bcd(uint8_t *val, uint8_t mask, uint8_t first, uint8_t last)
+{
+  uint8_t dec = bcd2dec(*val & mask);
+  bool wrap = dec >= last;
+
+  *val = (*val & ~mask) | dec2bcd(wrap ? first : dec + 1);
+  return wrap;
+}
+
+DS3231Emulator::DS3231Emulator()
+{
+  powerOn();
+}
+
+void DS3231Emulator::powerOn(void)
+{
+  memset(regs, 0, sizeof(regs));
+  regs[0x03] = 0x01;
+  regs[0x04] = 0x01;
+  regs[0x05] = 0x01;
+  regs[0x0E] = CTRL_INTCN | CTRL_RS;
+  regs[0x0F] = STAT_OSF | STAT_EN32KHZ;
+  pointer = 0;
+  ambient = 25 * 4;
+  synced_ns = host_time_ns();
+  second_ns = 0;
+  aging_ns = 0;
+  conv_countdown = DS3231_CONV_PERIOD_S;
+
+  // The first conversion is at power on.
+  conv_ns = 0;
+  endConversion();
+}
+
+// Runs the oscillator up to the current simulated time, a second or the end
+// of a conversion at a time. A positive aging offset slows it, the part of a
+// nanosecond it gains or loses is kept for the next time.
+void DS3231Emulator::sync(void)
+{
+  uint64_t now = host_time_ns();
+  uint64_t elapsed = now - synced_ns;
+  int64_t aging = (int64_t)elapsed * -(int8_t)regs[0x10] + aging_ns;
+
+  synced_ns = now;
+  elapsed += aging / AGING_PER_LSB;
+  aging_ns = aging % AGING_PER_LSB;
+  while (elapsed)
+  {
+    uint64_t step = NS_PER_SECOND - second_ns;
+
+    if (conv_ns && conv_ns < step)
+      step = conv_ns;
+    if (elapsed < step)
+      step = elapsed;
+
+    elapsed -= step;
+    second_ns += step;
+    if (conv_ns)
+    {
+      conv_ns -= step;
+      if (!conv_ns)
+        endConversion();
+    }
+    if (second_ns == NS_PER_SECOND)
+    {
+      second_ns = 0;
+      tick();
+    }
+  }
+}
+
+// Counts the hours on, returning true at midnight. In 12 hour mode (bit 6)
+// the PM bit (bit 5) changes as the hour goes from 11 to 12.
+bool DS3231Emulator::countHours(void)
+{
+  if (!(regs[0x02] & 0x40))
+    return count_bcd(&regs[0x02], 0x3F, 0, 23);
+
+  bool eleven = (regs[0x02] & 0x1F) == 0x11;
+
+  count_bcd(&regs[0x02], 0x1F, 1, 12);
+  if (!eleven)
+    return false;
+  regs[0x02] ^= 0x20;
+  return !(regs[0x02] & 0x20);
+}
+
+// Counts the day of week, date, month and year on at midnight. The DS3231
+// treats every year divisible by 4 as a leap year, and toggles the Century
+// bit when the year goes from 99 to 00.
+void DS3231Emulator::countDate(void)
+{
+  uint8_t month = regs[0x05] & 0x1F;
+  uint8_t month_days = MONTH_DAYS[(bcd2dec(month) + 11) % 12];
+
+  if (month == 0x02 && (bcd2dec(regs[0x06]) % 4) == 0)
+    month_days++;
+
+  count_bcd(&regs[0x03], 0x07, 1, 7);
+  if (count_bcd(&regs[0x04], 0x3F, 1, month_days) &&
+    count_bcd(&regs[0x05], 0x1F, 1, 12) &&
+    count_bcd(&regs[0x06], 0xFF, 0, 99))
+  {
+    regs[0x05] ^= 0x80;
+  }
+}
+
+// One second on, carrying into each register in turn.
+void DS3231Emulator::tick(void)
+{
+  if (count_bcd(&regs[0x00], 0x7F, 0, 59) &&
+    count_bcd(&regs[0x01], 0x7F, 0, 59) &&
+    countHours())
+  {
+    countDate();
+  }
+
+  checkAlarms();
+  if (!--conv_countdown)
+  {
+    conv_countdown = DS3231_CONV_PERIOD_S;
+    startConversion();
+  }
+}
+
+// Alarm 1 compares registers 0x07-0x0A with 0x00-0x04 every second, Alarm 2
+// compares 0x0B-0x0D with 0x01-0x04 at 00 seconds. A set AxMx bit (bit 7)
+// leaves that field out. The DY/DT bit (bit 6 of the last alarm register)
+// compares the day register rather than the date.
+void DS3231Emulator::checkAlarms(void)
+{
+  for (uint8_t alarm=0; alarm < 2; alarm++)
+  {
+    const uint8_t *match = &regs[alarm ? 0x0B : 0x07];
+    bool matched = true;
+
+    if (alarm)
+    {
+      matched = (regs[0x00] == 0);
+    }
+    else
+    {
+      matched = (*match & 0x80) || (*match & 0x7F) == regs[0x00];
+      match++;
+    }
+
+    matched = matched &&
+      ((match[0] & 0x80) || (match[0] & 0x7F) == regs[0x01]) &&
+      ((match[1] & 0x80) || (match[1] & 0x7F) == regs[0x02]);
+
+    if (!(match[2] & 0x80))
+    {
+      if (match[2] & 0x40)
+        matched = matched && (match[2] & 0x0F) == regs[0x03];
+      else
+        matched = matched && (match[2] & 0x3F) == regs[0x04];
+    }
+
+    if (matched)
+      regs[0x0F] |= (1 << alarm);
+  }
+}
+
+// Automatic conversions only set BSY, a forced one also keeps CONV set until
+// it is complete.
+void DS3231Emulator::startConversion(void)
+{
+  if (!conv_ns)
+  {
+    regs[0x0F] |= STAT_BSY;
+    conv_ns = DS3231_CONV_MS * 1000000ULL;
+  }
+}
+
+// 10 bit two's complement in quarter degrees, the upper 8 bits in 0x11 and
+// the lower 2 in bits 7-6 of 0x12.
+void DS3231Emulator::endConversion(void)
+{
+  regs[0x11] = (uint8_t)(ambient >> 2);
+  regs[0x12] = (uint8_t)((ambient & 0x03) << 6);
+  regs[0x0E] &= ~CTRL_CONV;
+  regs[0x0F] &= ~STAT_BSY;
+}
+
+void DS3231Emulator::writeReg(uint8_t reg, uint8_t val)
+{
+  uint8_t old = regs[reg];
+
+  val &= WRITABLE[reg];
+  switch (reg)
+  {
+    // The countdown chain restarts, so the next second is a whole one away.
+    case 0x00:
+      second_ns = 0;
+      regs[reg] = val;
+      break;
+
+    // CONV can't be cleared while a conversion it started is running.
+    case 0x0E:
+      if (conv_ns && (old & CTRL_CONV))
+        val |= CTRL_CONV;
+      regs[reg] = val;
+      if (val & CTRL_CONV)
+        startConversion();
+      break;
+
+    // OSF, A2F and A1F can only be cleared. BSY is read only.
+    case 0x0F:
+      regs[reg] = (old & val & STAT_FLAGS) | (old & STAT_BSY) |
+        (val & STAT_EN32KHZ);
+      break;
+
+    default:
+      regs[reg] = (old & ~WRITABLE[reg]) | val;
+      break;
+  }
+}
+
+uint8_t DS3231Emulator::reg(uint8_t num)
+{
+  sync();
+  return regs[num];
+}
+
+void DS3231Emulator::setReg(uint8_t num, uint8_t val)
+{
+  sync();
+  regs[num] = val;
+}
+
+void DS3231Emulator::setAmbient(int16_t quarters)
+{
+  sync();
+  ambient = quarters;
+}
+
+bool DS3231Emulator::intSqw(void)
+{
+  uint8_t rate;
+
+  sync();
+  if (regs[0x0E] & CTRL_INTCN)
+  {
+    return !(regs[0x0E] & regs[0x0F] & 0x03);
+  }
+
+  // 1Hz, 1.024kHz, 4.096kHz or 8.192kHz. Low for the first half of each
+  // period, so the 1Hz falling edge is when the seconds count on.
+  switch (regs[0x0E] & CTRL_RS)
+  {
+    case 0x00:  rate = 0;   break;
+    case 0x08:  rate = 10;  break;
+    case 0x10:  rate = 12;  break;
+    default:    rate = 13;  break;
+  }
+  return ((second_ns << rate) * 2 / NS_PER_SECOND) & 1;
+}
+
+// The first byte of a write sets the register pointer, any more are written
+// from there on.
+void DS3231Emulator::i2cWrite(const uint8_t *data, uint8_t len)
+{
+  sync();
+  if (!len)
+    return;
+
+  pointer = *data++ % DS3231_REGS;
+  while (--len)
+  {
+    writeReg(pointer, *data++);
+    pointer = (pointer + 1) % DS3231_REGS;
+  }
+}
+
+void DS3231Emulator::i2cRead(uint8_t *data, uint8_t len)
+{
+  sync();
+  while (len--)
+  {
+    *data++ = regs[pointer];
+    pointer = (pointer + 1) % DS3231_REGS;
+  }
+}
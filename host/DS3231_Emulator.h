@@ -0,0 +1,116 @@
+#ifndef DS3231_EMULATOR_
+#define DS3231_EMULATOR_
+/*!
+ * \file
+ *
+ * \brief Register level emulator of the DS3231 Real-Time Clock.
+ *
+ * Attached to the host Wire at 0x68, it answers the driver in DS3231_RTC.h
+ * as the chip would, so the driver can be tested and benchmarked on Linux.
+ *
+ * Emulated:
+ *      - The register pointer, which auto-increments and wraps from 0x12
+ *        to 0x00, and the read-only and unused bits of each register.
+ *      - The oscillator, kept in step with simulated time. Each second the
+ *        BCD time and date count on, in 24 or 12 hour mode, with the days of
+ *        each month, leap years and the century bit. The aging offset makes
+ *        it run slow (positive) or fast (negative) by 0.1ppm per LSB.
+ *      - Alarm 1 and Alarm 2 with the AxMx mask and DY/DT bits, setting
+ *        A1F/A2F. Writing the seconds register resets the countdown chain.
+ *      - The Status Register flags, which can only be cleared by writing 0.
+ *        OSF is set at power on.
+ *      - Temperature conversions every 64 seconds and when CONV is set, BSY
+ *        for #DS3231_CONV_MS while converting, then the result in 0x11-0x12.
+ *      - The INT/SQW pin, for the alarms or the square wave.
+ *
+ * NOTES:
+ *      - The chip is always on Vcc, so EOSC and BBSQW have no effect.
+ *      - The oscillator is otherwise exact, temperature doesn't change it.
+ *      - As on the chip, every year divisible by 4 is a leap year, so 2100
+ *        has a 29th of February.
+ */
+
+#include <Wire.h>
+
+/*!
+ * \defgroup DS3231_EMULATOR definitions
+ * \{
+ */
+#define DS3231_ADDRESS (0x68)       /*!< I2C address. */
+#define DS3231_REGS (0x13)          /*!< Registers 0x00 to 0x12. */
+#define DS3231_CONV_MS (200)        /*!< Longest conversion time. */
+#define DS3231_CONV_PERIOD_S (64)   /*!< Automatic conversion period. */
+/*! \} */
+
+/*!
+ * \brief DS3231Emulator class
+ */
+class DS3231Emulator : public I2CDevice
+{
+  uint8_t regs[DS3231_REGS];
+  uint8_t pointer;
+  int16_t ambient;              // Temperature in quarter degrees.
+  uint64_t synced_ns;           // host_time_ns() caught up to.
+  uint64_t second_ns;           // Into the current second.
+  int64_t aging_ns;             // Gained or lost, in 0.1ppm of a ns.
+  uint64_t conv_ns;             // Left of a conversion, 0 if none.
+  uint8_t conv_countdown;       // Seconds to the next automatic one.
+
+  void sync(void);
+  bool countHours(void);
+  void countDate(void);
+  void tick(void);
+  void checkAlarms(void);
+  void startConversion(void);
+  void endConversion(void);
+  void writeReg(uint8_t reg, uint8_t val);
+public:
+  /*!
+   * \brief Constructor, in the power on state at the current time.
+   */
+  DS3231Emulator();
+
+  /*!
+   * \brief Return to the power on state.
+   *
+   * 01/01/00, day 1, 00:00:00 with the alarms clear, INTCN set, OSF set and
+   * the temperature converted.
+   */
+  void powerOn(void);
+
+  /*!
+   * \brief Read a register directly, without a bus transfer.
+   *
+   * \param num Register 0x00 to 0x12.
+   */
+  uint8_t reg(uint8_t num);
+
+  /*!
+   * \brief Write a register directly, without a bus transfer or any of the
+   * side effects of a write from the bus.
+   *
+   * \param num Register 0x00 to 0x12.
+   * \param val The value.
+   */
+  void setReg(uint8_t num, uint8_t val);
+
+  /*!
+   * \brief Set the temperature the next conversion measures.
+   *
+   * \param quarters Temperature in quarter degrees centigrade.
+   */
+  void setAmbient(int16_t quarters);
+
+  /*!
+   * \brief Level of the active low INT/SQW pin.
+   *
+   * \result Low (false) while an enabled alarm flag is set, or the square
+   *         wave when INTCN is clear.
+   */
+  bool intSqw(void);
+
+  virtual void i2cWrite(const uint8_t *data, uint8_t len);
+  virtual void i2cRead(uint8_t *data, uint8_t len);
+};
+
+#endif // DS3231_EMULATOR_
@@ -0,0 +1,13 @@
+#ifndef SPI_H_
+#define SPI_H_
+/*!
+ * \file
+ *
+ * \brief Host stand-in for the SPI library.
+ *
+ * Only included by the sketch, the display and touch stand-ins don't use it.
+ */
+
+#include <Arduino.h>
+
+#endif // SPI_H_
@@ -0,0 +1,120 @@
+#include "Wire.h"
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+{
+  device_count = 0;
+  clock_hz = 100000UL;
+  memset(&stats, 0, sizeof(stats));
+  tx_len = 0;
+  rx_len = 0;
+  rx_next = 0;
+}
+
+void TwoWire::attach(uint8_t address, I2CDevice *device)
+{
+  if (device_count < WIRE_MAX_DEVICES)
+  {
+    devices[device_count].address = address;
+    devices[device_count].device = device;
+    device_count++;
+  }
+}
+
+I2CDevice *TwoWire::find(uint8_t address)
+{
+  for (uint8_t idx=0; idx < device_count; idx++)
+  {
+    if (devices[idx].address == address)
+      return devices[idx].device;
+  }
+  return NULL;
+}
+
+// Counts a transaction of 'len' bytes after the address byte, and moves time
+// on by as long as it keeps the bus busy.
+void TwoWire::count(uint8_t len)
+{
+  uint64_t ns = busTimeNs(1, 1 + len, clock_hz);
+
+  stats.transactions += 1;
+  stats.bytes += 1 + len;
+  stats.busy_ns += ns;
+  host_advance_ns(ns);
+}
+
+uint64_t TwoWire::busTimeNs(uint32_t transactions, uint32_t bytes, uint32_t hz)
+{
+  uint64_t clocks = (9ULL * bytes) + (2ULL * transactions);
+
+  return (clocks * 1000000000ULL) / hz;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+  tx_address = address;
+  tx_len = 0;
+}
+
+size_t TwoWire::write(uint8_t val)
+{
+  if (tx_len == WIRE_BUFFER_SIZE)
+    return 0;
+  tx_buffer[tx_len++] = val;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t len)
+{
+  size_t written = 0;
+
+  while (written < len && write(data[written]))
+    written++;
+  return written;
+}
+
+uint8_t TwoWire::endTransmission(void)
+{
+  I2CDevice *device = find(tx_address);
+
+  // Without an ACK the master stops after the address byte.
+  if (!device)
+  {
+    count(0);
+    return 2;
+  }
+
+  device->i2cWrite(tx_buffer, tx_len);
+  count(tx_len);
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t len)
+{
+  I2CDevice *device = find(address);
+
+  rx_len = 0;
+  rx_next = 0;
+  if (!device)
+  {
+    count(0);
+    return 0;
+  }
+
+  if (len > WIRE_BUFFER_SIZE)
+    len = WIRE_BUFFER_SIZE;
+  device->i2cRead(rx_buffer, len);
+  rx_len = len;
+  count(len);
+  return len;
+}
+
+void TwoWire::getStats(I2C_BUS_STATS_T *bus_stats, bool reset)
+{
+  *bus_stats = stats;
+  if (reset)
+  {
+    memset(&stats, 0, sizeof(stats));
+  }
+}
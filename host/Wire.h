@@ -0,0 +1,148 @@
+#ifndef WIRE_H_
+#define WIRE_H_
+/*!
+ * \file
+ *
+ * \brief Host stand-in for the Wire I2C library.
+ *
+ * Transfers go to the emulated devices attached to the bus, such as the
+ * DS3231 in DS3231_Emulator.h, instead of to hardware.
+ *
+ * NOTES:
+ *      - Every transfer is counted, a transaction being START to STOP. The
+ *        bytes include the address byte, as RTC_BUS_STATS_T does.
+ *      - Each transfer moves simulated time on by how long it keeps the bus
+ *        busy at the clock set with setClock(), 100kHz by default. Each byte
+ *        is 9 clocks and each START and STOP about a clock.
+ */
+
+#include <Arduino.h>
+
+/*!
+ * \defgroup WIRE definitions
+ * \{
+ */
+#define WIRE_BUFFER_SIZE (32)       /*!< Bytes in a write or a read. */
+#define WIRE_MAX_DEVICES (4)        /*!< Devices that can be attached. */
+/*! \} */
+
+/*!
+ * \brief I2CDevice class, a device that can be attached to the host Wire.
+ */
+class I2CDevice
+{
+public:
+  virtual ~I2CDevice() {}
+
+  /*!
+   * \brief A write transaction addressed to the device.
+   *
+   * \param data The bytes written after the address byte.
+   * \param len Number of bytes, may be 0.
+   */
+  virtual void i2cWrite(const uint8_t *data, uint8_t len) = 0;
+
+  /*!
+   * \brief A read transaction addressed to the device.
+   *
+   * \param data Where to put the bytes read.
+   * \param len Number of bytes the master reads.
+   */
+  virtual void i2cRead(uint8_t *data, uint8_t len) = 0;
+};
+
+/*!
+ * \brief I2C_BUS_STATS_T struct for what the bus has carried.
+ */
+typedef struct _i2c_bus_stats {
+  uint32_t transactions;        /*!< START to STOP transfers. */
+  uint32_t bytes;               /*!< Bytes, including the address bytes. */
+  uint64_t busy_ns;             /*!< Time the bus was busy. */
+} I2C_BUS_STATS_T;
+
+/*!
+ * \brief TwoWire class
+ */
+class TwoWire
+{
+  struct {
+    uint8_t address;
+    I2CDevice *device;
+  } devices[WIRE_MAX_DEVICES];
+  uint8_t device_count;
+
+  uint32_t clock_hz;
+  I2C_BUS_STATS_T stats;
+
+  uint8_t tx_address;
+  uint8_t tx_buffer[WIRE_BUFFER_SIZE];
+  uint8_t tx_len;
+  uint8_t rx_buffer[WIRE_BUFFER_SIZE];
+  uint8_t rx_len;
+  uint8_t rx_next;
+
+  I2CDevice *find(uint8_t address);
+  void count(uint8_t len);
+public:
+  TwoWire();
+
+  void begin(void) {}
+  void setClock(uint32_t hz) { clock_hz = hz; }
+  void beginTransmission(uint8_t address);
+  void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+  size_t write(uint8_t val);
+  size_t write(const uint8_t *data, size_t len);
+
+  /*!
+   * \result 0 if the device acknowledged, 2 if there was no device at the
+   *         address.
+   */
+  uint8_t endTransmission(void);
+
+  /*!
+   * \result The number of bytes read, 0 if no device at the address.
+   */
+  uint8_t requestFrom(uint8_t address, uint8_t len);
+  uint8_t requestFrom(int address, int len)
+  {
+    return requestFrom((uint8_t)address, (uint8_t)len);
+  }
+  int available(void) { return rx_len - rx_next; }
+  int read(void) { return rx_next < rx_len ? rx_buffer[rx_next++] : -1; }
+
+  /*!
+   * \brief Put a device on the bus.
+   *
+   * \param address Its 7-bit I2C address.
+   * \param device The device, which must outlive its use on the bus.
+   */
+  void attach(uint8_t address, I2CDevice *device);
+
+  /*!
+   * \brief Remove every device from the bus.
+   */
+  void detachAll(void) { device_count = 0; }
+
+  /*!
+   * \brief Read what the bus has carried.
+   *
+   * \param bus_stats Pointer to the I2C_BUS_STATS_T struct to fill in.
+   * \param reset True to reset the counts once they have been read.
+   */
+  void getStats(I2C_BUS_STATS_T *bus_stats, bool reset);
+
+  /*!
+   * \brief Time some traffic keeps the bus busy at a clock rate.
+   *
+   * \param transactions Number of transactions.
+   * \param bytes Number of bytes, including address bytes.
+   * \param hz The I2C clock, e.g. #I2C_STANDARD_HZ or #I2C_FAST_HZ.
+   *
+   * \result The time in nanoseconds.
+   */
+  static uint64_t busTimeNs(uint32_t transactions, uint32_t bytes, uint32_t hz);
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H_
@@ -0,0 +1,56 @@
+#ifndef XPT2046_H_
+#define XPT2046_H_
+/*!
+ * \file
+ *
+ * \brief Host stand-in for the XPT2046 touch panel library.
+ *
+ * The panel is never touched, so isTouching() is always false and the
+ * positions read are the centre of the screen.
+ */
+
+#include <Arduino.h>
+
+/*!
+ * \brief XPT2046 class, an untouched touch panel.
+ */
+class XPT2046
+{
+  uint16_t width;
+  uint16_t height;
+public:
+  enum rotation_t : uint8_t { ROT0, ROT90, ROT180, ROT270 };
+  enum adc_ref_t : uint8_t { MODE_SER, MODE_DFR };
+
+  XPT2046(uint8_t, uint8_t, uint8_t = 1) : width(0), height(0) {}
+
+  void begin(uint16_t w, uint16_t h) { width = w; height = h; }
+  void setCalibration(uint16_t, uint16_t, uint16_t, uint16_t) {}
+  void setRotation(rotation_t) {}
+  bool isTouching(void) const { return false; }
+  void powerDown(void) const {}
+
+  void getPosition(
+    uint16_t &x,
+    uint16_t &y,
+    adc_ref_t = MODE_SER,
+    uint8_t = 0xff
+    ) const
+  {
+    x = width / 2;
+    y = height / 2;
+  }
+
+  void getRaw(
+    uint16_t &vi,
+    uint16_t &vj,
+    adc_ref_t = MODE_SER,
+    uint8_t = 0xff
+    ) const
+  {
+    vi = 0;
+    vj = 0;
+  }
+};
+
+#endif // XPT2046_H_
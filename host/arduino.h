@@ -0,0 +1,3 @@
+// The core is included as <arduino.h> by some of the sketch, which works on
+// a case insensitive file system.
+#include "Arduino.h"
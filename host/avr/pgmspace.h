@@ -0,0 +1,19 @@
+#ifndef PGMSPACE_H_
+#define PGMSPACE_H_
+/*!
+ * \file
+ *
+ * \brief Host stand-in for avr/pgmspace.h, for the Adafruit_GFX_AS fonts.
+ *
+ * Flash is just memory on the host, as it is on the STM32.
+ */
+
+#include <stdint.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+#endif // PGMSPACE_H_
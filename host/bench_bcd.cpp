@@ -0,0 +1,116 @@
+// Date/time BCD codec microbenchmark.
+//
+// Compares rtc_decode_date_time and rtc_encode_date_time with converting the
+// 7 registers byte by byte with the bcd2dec/dec2bcd helpers, as
+// get_date_time and set_date_time used to. Timed with the host's monotonic
+// clock, not the simulated one.
+
+#include <time.h>
+#include <Arduino.h>
+#include "../DS3231_RTC.h"
+
+static const long BCD_LOOPS = 10000000;
+static const int BCD_BLOCKS = 64;
+
+static volatile uint8_t bcd_sink;      // Stops the results being optimised out.
+
+// The byte by byte BCD conversion, for comparison.
+static uint8_t bcd2dec(char mask, char val)
+{
+  val = val & mask;
+  return (uint8_t)((val >> 4) * 10) + (val & 0xF);
+}
+
+static char dec2bcd(uint8_t val)
+{
+  return (char)(((val/10) << 4) | val % 10);
+}
+
+__attribute__((noinline))
+static void bytewise_decode(const uint8_t *regs, TM_T *date_time)
+{
+  uint8_t *ptr = (uint8_t *)date_time;
+
+  for (int idx=0; idx < 7; idx++)
+  {
+    *ptr++ = bcd2dec( 0x7F, regs[idx] );
+  }
+}
+
+__attribute__((noinline))
+static void bytewise_encode(const TM_T *date_time, uint8_t *regs)
+{
+  regs[0] = dec2bcd(date_time->tm_sec);
+  regs[1] = dec2bcd(date_time->tm_min);
+  regs[2] = dec2bcd(date_time->tm_hour);
+  regs[3] = date_time->tm_wday;
+  regs[4] = dec2bcd(date_time->tm_mday);
+  regs[5] = dec2bcd(date_time->tm_mon);
+  regs[6] = dec2bcd(date_time->tm_year);
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Time 'BCD_LOOPS' calls of each over 'BCD_BLOCKS' different dates and
+// times, and print the time per call in ns.
+static void bench_codec(
+  const char *name,
+  void (* volatile decode)(const uint8_t *, TM_T *),
+  void (* volatile encode)(const TM_T *, uint8_t *)
+  )
+{
+  static uint8_t regs[BCD_BLOCKS][7];
+  static TM_T times[BCD_BLOCKS];
+  uint64_t decode_ns, encode_ns;
+  uint64_t start;
+
+  for (int idx=0; idx < BCD_BLOCKS; idx++)
+  {
+    times[idx].tm_sec = (idx * 7) % 60;
+    times[idx].tm_min = (idx * 13) % 60;
+    times[idx].tm_hour = idx % 24;
+    times[idx].tm_wday = 1 + idx % 7;
+    times[idx].tm_mday = 1 + idx % 31;
+    times[idx].tm_mon = 1 + idx % 12;
+    times[idx].tm_year = (idx * 3) % 100;
+    times[idx].tm_century = 0;
+    rtc_encode_date_time(&times[idx], regs[idx]);
+  }
+
+  start = now_ns();
+  for (long idx=0; idx < BCD_LOOPS; idx++)
+  {
+    TM_T date_time;
+
+    decode(regs[idx % BCD_BLOCKS], &date_time);
+    bcd_sink = date_time.tm_sec;
+  }
+  decode_ns = now_ns() - start;
+
+  start = now_ns();
+  for (long idx=0; idx < BCD_LOOPS; idx++)
+  {
+    uint8_t out[7];
+
+    encode(&times[idx % BCD_BLOCKS], out);
+    bcd_sink = out[0];
+  }
+  encode_ns = now_ns() - start;
+
+  printf("%-20s decode %5.2fns, encode %5.2fns\n", name,
+    (double)decode_ns / BCD_LOOPS, (double)encode_ns / BCD_LOOPS);
+}
+
+int main(void)
+{
+  printf("BCD date/time benchmark, per call\n");
+  bench_codec("byte by byte", bytewise_decode, bytewise_encode);
+  bench_codec("rtc_decode/encode", rtc_decode_date_time, rtc_encode_date_time);
+  return 0;
+}
@@ -0,0 +1,101 @@
+// What one DisplayMain() call costs on the display SPI bus and the RTC I2C
+// bus, in each display mode.
+//
+// Runs the sketch's setup() against the emulated DS3231 and the framebuffer
+// display, then for each mode calls DisplayMain() as the sketch does when
+// it redraws everything, and with the time left as it is, as it does when
+// the mode is changed. Prints the SPI costs of each display call, the
+// display list's own estimate of them and the I2C transfers, and saves
+// each screen as display_<mode>.ppm.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_ILI9341_STM.h>
+#include "DS3231_Emulator.h"
+#include "../DS3231_RTC.h"
+#include "../DisplayList.h"
+
+// From DigitalClock.ino.
+extern Adafruit_ILI9341_STM tft;
+void setup(void);
+void DisplayMain(uint8_t mode, bool display_time);
+
+static DS3231Emulator rtc;
+
+static const char *mode_names[] = { "alarm1", "alarm2", "date", "temp" };
+static const uint8_t MODES = sizeof(mode_names) / sizeof(mode_names[0]);
+
+static void print_cost(const char *name, const TFT_COST_T &cost)
+{
+  printf("  %-20s %6u %8u %8u %8u %8llu\n", name, cost.calls, cost.windows,
+    cost.pixels, cost.bytes,
+    (unsigned long long)Adafruit_ILI9341_STM::busTimeNs(cost.bytes,
+      TFT_SPI_HZ) / 1000);
+}
+
+// One DisplayMain() call and what it cost.
+static void bench_display_main(uint8_t mode, bool display_time)
+{
+  TFT_STATS_T stats;
+  DL_COST_T dl_cost;
+  I2C_BUS_STATS_T i2c;
+
+  tft.getStats(&stats, true);
+  displaylist.getCost(&dl_cost, true);
+  Wire.getStats(&i2c, true);
+
+  DisplayMain(mode, display_time);
+
+  tft.getStats(&stats, true);
+  displaylist.getCost(&dl_cost, true);
+  Wire.getStats(&i2c, true);
+
+  printf("DisplayMain(%s%s)\n", mode_names[mode],
+    display_time ? "" : ", time left");
+  printf("  %-20s %6s %8s %8s %8s %8s\n", "call", "calls", "windows",
+    "pixels", "bytes", "us@36M");
+  for (uint8_t call=0; call < TFT_CALLS; call++)
+  {
+    if (stats.call[call].calls)
+    {
+      print_cost(Adafruit_ILI9341_STM::callName(call), stats.call[call]);
+    }
+  }
+  print_cost("total", stats.total);
+  printf("  display list estimate: %u ops, %u executed, %u windows, "
+    "%u pixels, %u bytes, %uus\n", dl_cost.recorded, dl_cost.executed,
+    dl_cost.windows, dl_cost.pixels, dl_cost.bytes,
+    dl_bus_time_us(&dl_cost, TFT_SPI_HZ));
+  printf("  I2C: %u transactions, %u bytes, %lluus@100k\n", i2c.transactions,
+    i2c.bytes, (unsigned long long)TwoWire::busTimeNs(i2c.transactions,
+      i2c.bytes, I2C_STANDARD_HZ) / 1000);
+}
+
+int main(void)
+{
+  char path[32];
+
+  // Saturday 15 June 2019, 12:34:56, 23.5C.
+  rtc.setReg(0x00, 0x56);
+  rtc.setReg(0x01, 0x34);
+  rtc.setReg(0x02, 0x12);
+  rtc.setReg(0x03, 7);
+  rtc.setReg(0x04, 0x15);
+  rtc.setReg(0x05, 0x06);
+  rtc.setReg(0x06, 0x19);
+  rtc.setAmbient(23 * 4 + 2);
+  Wire.attach(DS3231_ADDRESS, &rtc);
+
+  setup();
+  printf("\n");
+
+  for (uint8_t mode=0; mode < MODES; mode++)
+  {
+    bench_display_main(mode, true);
+    snprintf(path, sizeof(path), "display_%s.ppm", mode_names[mode]);
+    tft.writePPM(path);
+    bench_display_main(mode, false);
+    printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,85 @@
+// Bus cost of each DS3231 driver API, against the emulated DS3231.
+//
+// For each API prints the I2C transactions and bytes it used and how long
+// that keeps the bus busy at 100kHz and 400kHz. The reads are run with the
+// shadow copy fresh, so all but rtc_refresh cost nothing, then again with it
+// stale.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "DS3231_Emulator.h"
+#include "../DS3231_RTC.h"
+
+static DS3231Emulator rtc;
+
+// Shared state for the API calls being benchmarked.
+static TM_T bench_tm;
+static TEMP_T bench_temp;
+static ALARM_T bench_alarm;
+static uint8_t bench_enabled;
+static uint8_t bench_triggered;
+
+static void call_refresh() { rtc_refresh(); }
+static void call_get_date_time() { get_date_time(&bench_tm); }
+static void call_get_temp() { get_temp(&bench_temp); }
+static void call_get_alarm_time() { get_alarm_time(ALARM1, &bench_alarm); }
+static void call_get_alarm_status()
+{
+  get_alarm_status(&bench_enabled, &bench_triggered);
+}
+static void call_convert_temp() { rtc_convert_temp(); }
+static void call_set_date_time() { set_date_time(&bench_tm); }
+static void call_set_alarm_time() { set_alarm_time(ALARM1, &bench_alarm); }
+static void call_set_alarm_on() { set_alarm(ALARM1, true); }
+static void call_set_alarm_off() { set_alarm(ALARM1, false); }
+static void call_clear_alarm() { clear_alarm(ALARM_MASK); }
+static void call_square_wave() { set_square_wave(false); }
+
+// Run one API and print what it cost on the bus. 'wait_ms' passes before it
+// is called, so the shadow or temperature cache can go stale.
+static void bench_call(const char *name, void (*call)(void),
+  unsigned long wait_ms=0)
+{
+  I2C_BUS_STATS_T stats;
+
+  delay(wait_ms);
+  Wire.getStats(&stats, true);
+  call();
+  Wire.getStats(&stats, true);
+
+  printf("%-24s %6u %6u %8llu %8llu\n", name, stats.transactions, stats.bytes,
+    (unsigned long long)TwoWire::busTimeNs(stats.transactions, stats.bytes,
+      I2C_STANDARD_HZ) / 1000,
+    (unsigned long long)TwoWire::busTimeNs(stats.transactions, stats.bytes,
+      I2C_FAST_HZ) / 1000);
+}
+
+int main(void)
+{
+  Wire.begin();
+  Wire.attach(DS3231_ADDRESS, &rtc);
+
+  printf("%-24s %6s %6s %8s %8s\n", "RTC API", "trans", "bytes", "us@100k",
+    "us@400k");
+
+  // Reads - from the shadow, then with it stale.
+  bench_call("rtc_refresh", call_refresh);
+  bench_call("get_date_time", call_get_date_time);
+  bench_call("get_temp", call_get_temp);
+  bench_call("get_temp (cached)", call_get_temp);
+  bench_call("get_alarm_time", call_get_alarm_time);
+  bench_call("get_alarm_status", call_get_alarm_status);
+  bench_call("get_date_time (stale)", call_get_date_time, RTC_SHADOW_TTL_MS);
+  bench_call("get_temp (stale)", call_get_temp, RTC_TEMP_PERIOD_MS);
+
+  // Writes, using the values just read.
+  bench_call("set_date_time", call_set_date_time);
+  bench_call("set_alarm_time", call_set_alarm_time);
+  bench_call("set_alarm on", call_set_alarm_on);
+  bench_call("set_alarm off", call_set_alarm_off);
+  bench_call("clear_alarm", call_clear_alarm);
+  bench_call("set_square_wave", call_square_wave);
+  bench_call("rtc_convert_temp", call_convert_temp, DS3231_CONV_MS);
+
+  return 0;
+}
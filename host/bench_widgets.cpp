@@ -0,0 +1,258 @@
+// Widget rendering benchmark, on the framebuffer display.
+//
+// Updates each widget from a fixed sequence, so runs can be compared:
+//      - DisplayTimeWidget, DisplayDateFullWidget and DisplayDateWidget a
+//        day of seconds, then 2 minutes over a month and a year rollover.
+//      - DisplayTempWidget 15C to 35C and back in quarter degrees.
+//      - DisplayAlarmWidget every minute of the day.
+//      - SetTime, SetDate and SetDayOfWeek drawn once.
+//
+// For each prints the address windows, pixels and SPI bytes sent, and the
+// average and worst time an update keeps the SPI bus busy at 36MHz. The
+// CPU time isn't included, the host can't measure what the target takes.
+
+#include <Arduino.h>
+#include <Adafruit_ILI9341_STM.h>
+#include "../DateTime.h"
+#include "../DisplayList.h"
+#include "../Epoch.h"
+
+static Adafruit_ILI9341_STM tft(0, 0);
+
+
+// One update of a widget being benchmarked, for step 'idx' of a case.
+typedef void (*BENCH_STEP_T)(void *widget, EPOCH_T start, uint32_t idx);
+
+// Run 'steps' updates of a widget and print what they cost on the bus, and
+// the average and worst bus time of an update.
+static void bench_case(
+  const char *name,
+  void *widget,
+  BENCH_STEP_T step,
+  EPOCH_T start,
+  uint32_t steps
+  )
+{
+  uint64_t total = 0;
+  uint64_t worst = 0;
+  TFT_STATS_T stats;
+
+  tft.getStats(&stats, true);
+  for (uint32_t idx=0; idx < steps; idx++)
+  {
+    uint64_t begin = host_time_ns();
+    uint64_t elapsed;
+
+    step(widget, start, idx);
+    elapsed = host_time_ns() - begin;
+    total += elapsed;
+    worst = max(worst, elapsed);
+  }
+  tft.getStats(&stats, true);
+
+  printf("%-28s %6u %9u %10u %11u %8llu %8llu\n", name, steps,
+    stats.total.windows, stats.total.pixels, stats.total.bytes,
+    (unsigned long long)(total / steps / 1000),
+    (unsigned long long)(worst / 1000));
+}
+
+// Epoch of a date and time in the 21st century.
+static EPOCH_T bench_epoch(
+  uint8_t year,
+  uint8_t mon,
+  uint8_t mday,
+  uint8_t hour,
+  uint8_t min,
+  uint8_t sec
+  )
+{
+  TM_T date_time;
+
+  memset(&date_time, 0, sizeof(date_time));
+  date_time.tm_year = year;
+  date_time.tm_mon = mon;
+  date_time.tm_mday = mday;
+  date_time.tm_hour = hour;
+  date_time.tm_min = min;
+  date_time.tm_sec = sec;
+  return tm_to_epoch(&date_time);
+}
+
+static void step_time(void *widget, EPOCH_T start, uint32_t idx)
+{
+  TM_T now;
+
+  ((DisplayTimeWidget *)widget)->Update(*epoch_to_tm(start + idx, &now));
+}
+
+static void step_date_full(void *widget, EPOCH_T start, uint32_t idx)
+{
+  TM_T now;
+
+  ((DisplayDateFullWidget *)widget)->Update(*epoch_to_tm(start + idx, &now));
+}
+
+static void step_date(void *widget, EPOCH_T start, uint32_t idx)
+{
+  TM_T now;
+
+  ((DisplayDateWidget *)widget)->Update(*epoch_to_tm(start + idx, &now));
+}
+
+// Temperatures rising from 15C to 35C and back, a quarter degree a step.
+static void step_temp(void *widget, EPOCH_T, uint32_t idx)
+{
+  uint32_t quarters = idx % 160;
+  TEMP_T temperature;
+
+  if (quarters >= 80)
+  {
+    quarters = 160 - quarters;
+  }
+  quarters += 60;
+  temperature.temp_degrees = quarters / 4;
+  temperature.temp_quarters = quarters % 4;
+  temperature.temp_half = (temperature.temp_quarters >= 2) ? 5 : 0;
+  ((DisplayTempWidget *)widget)->Update(temperature);
+}
+
+// Alarm times a minute apart, a step for every minute of the day.
+static void step_alarm(void *widget, EPOCH_T, uint32_t idx)
+{
+  ALARM_T alarm;
+
+  memset(&alarm, 0, sizeof(alarm));
+  alarm.tm_hour = (idx / 60) % 24;
+  alarm.tm_min = idx % 60;
+  alarm.mode = ALARM_MATCH_HOURS;
+  ((DisplayAlarmWidget *)widget)->Update(alarm);
+}
+
+static void step_set_time(void *widget, EPOCH_T start, uint32_t idx)
+{
+  TM_T now;
+
+  ((SetTime *)widget)->Display(*epoch_to_tm(start + idx, &now));
+}
+
+static void step_set_date(void *widget, EPOCH_T start, uint32_t idx)
+{
+  TM_T now;
+
+  ((SetDate *)widget)->Display(*epoch_to_tm(start + idx, &now));
+}
+
+static void step_set_day_of_week(void *widget, EPOCH_T start, uint32_t idx)
+{
+  TM_T now;
+
+  ((SetDayOfWeek *)widget)->Display(*epoch_to_tm(start + idx, &now));
+}
+
+// Each widget is benchmarked in its own function, so only one is on the
+// stack at a time.
+
+static void bench_time_widget(Adafruit_ILI9341_STM* tft)
+{
+  DisplayTimeWidget widget(tft, 0, 0);
+  EPOCH_T day = bench_epoch(19, 6, 15, 0, 0, 0);
+  EPOCH_T month = bench_epoch(19, 1, 31, 23, 59, 0);
+  EPOCH_T year = bench_epoch(19, 12, 31, 23, 59, 0);
+  TM_T now;
+
+  widget.Display(*epoch_to_tm(day, &now));
+  bench_case("DisplayTimeWidget day", &widget, step_time, day, EPOCH_DAY);
+  widget.Display(*epoch_to_tm(month, &now));
+  bench_case("DisplayTimeWidget month", &widget, step_time, month, 120);
+  widget.Display(*epoch_to_tm(year, &now));
+  bench_case("DisplayTimeWidget year", &widget, step_time, year, 120);
+}
+
+static void bench_date_full_widget(Adafruit_ILI9341_STM* tft)
+{
+  DisplayDateFullWidget widget(tft, 0, 120);
+  EPOCH_T day = bench_epoch(19, 6, 15, 0, 0, 0);
+  EPOCH_T month = bench_epoch(19, 1, 31, 23, 59, 0);
+  EPOCH_T year = bench_epoch(19, 12, 31, 23, 59, 0);
+  TM_T now;
+
+  widget.Display(*epoch_to_tm(day, &now));
+  bench_case("DisplayDateFullWidget day", &widget, step_date_full, day,
+             EPOCH_DAY);
+  widget.Display(*epoch_to_tm(month, &now));
+  bench_case("DisplayDateFullWidget month", &widget, step_date_full, month,
+             120);
+  widget.Display(*epoch_to_tm(year, &now));
+  bench_case("DisplayDateFullWidget year", &widget, step_date_full, year,
+             120);
+}
+
+static void bench_date_widget(Adafruit_ILI9341_STM* tft)
+{
+  DisplayDateWidget widget(tft, 0, 120);
+  EPOCH_T day = bench_epoch(19, 6, 15, 0, 0, 0);
+  EPOCH_T month = bench_epoch(19, 1, 31, 23, 59, 0);
+  EPOCH_T year = bench_epoch(19, 12, 31, 23, 59, 0);
+  TM_T now;
+
+  widget.Display(*epoch_to_tm(day, &now));
+  bench_case("DisplayDateWidget day", &widget, step_date, day, EPOCH_DAY);
+  widget.Display(*epoch_to_tm(month, &now));
+  bench_case("DisplayDateWidget month", &widget, step_date, month, 120);
+  widget.Display(*epoch_to_tm(year, &now));
+  bench_case("DisplayDateWidget year", &widget, step_date, year, 120);
+}
+
+static void bench_temp_widget(Adafruit_ILI9341_STM* tft)
+{
+  DisplayTempWidget widget(tft, 0, 120);
+  TEMP_T temperature = { 15, 0, 0 };
+
+  widget.Display(temperature);
+  bench_case("DisplayTempWidget", &widget, step_temp, 0, 320);
+}
+
+static void bench_alarm_widget(Adafruit_ILI9341_STM* tft)
+{
+  DisplayAlarmWidget widget(tft, 0, 120);
+  ALARM_T alarm;
+
+  memset(&alarm, 0, sizeof(alarm));
+  alarm.mode = ALARM_MATCH_HOURS;
+  widget.Display(ALARM1, 1, alarm);
+  bench_case("DisplayAlarmWidget", &widget, step_alarm, 0, 24 * 60);
+}
+
+static void bench_setup_screens(Adafruit_ILI9341_STM* tft)
+{
+  EPOCH_T day = bench_epoch(19, 6, 15, 12, 34, 56);
+
+  {
+    SetTime widget(tft);
+    bench_case("SetTime", &widget, step_set_time, day, 1);
+  }
+  {
+    SetDate widget(tft);
+    bench_case("SetDate", &widget, step_set_date, day, 1);
+  }
+  {
+    SetDayOfWeek widget(tft);
+    bench_case("SetDayOfWeek", &widget, step_set_day_of_week, day, 1);
+  }
+}
+
+int main(void)
+{
+  tft.begin();
+  tft.setRotation(3);
+
+  printf("%-28s %6s %9s %10s %11s %8s %8s\n", "Widget case", "steps",
+    "windows", "pixels", "bytes", "avg us", "worst us");
+  bench_time_widget(&tft);
+  bench_date_full_widget(&tft);
+  bench_date_widget(&tft);
+  bench_temp_widget(&tft);
+  bench_alarm_widget(&tft);
+  bench_setup_screens(&tft);
+  return 0;
+}
@@ -0,0 +1,362 @@
+// Tests of the alarm scheduler against the emulated DS3231.
+//
+// The scheduler runs as the sketch runs it: service() once a second from
+// the software clock, with the queued RTC writes finished in between. After
+// each step the emulator's Alarm 1 registers are checked against the top of
+// the heap.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "DS3231_Emulator.h"
+#include "../DS3231_RTC.h"
+#include "../SoftClock.h"
+#include "../AlarmScheduler.h"
+
+static DS3231Emulator rtc;
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+#define CHECK_EQ(a, b) check_eq((long)(a), (long)(b), #a, #b, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+  checks++;
+  if (!ok)
+  {
+    failures++;
+    printf("test_alarms.cpp:%d: CHECK(%s) failed\n", line, what);
+  }
+}
+
+static void check_eq(long a, long b, const char *what_a, const char *what_b,
+  int line)
+{
+  checks++;
+  if (a != b)
+  {
+    failures++;
+    printf("test_alarms.cpp:%d: %s == %s failed, %ld != %ld\n",
+      line, what_a, what_b, a, b);
+  }
+}
+
+static TM_T make_tm(uint8_t century, uint8_t year, uint8_t mon, uint8_t mday,
+  uint8_t wday, uint8_t hour, uint8_t min, uint8_t sec)
+{
+  TM_T tm;
+
+  tm.tm_sec = sec;
+  tm.tm_min = min;
+  tm.tm_hour = hour;
+  tm.tm_wday = wday;
+  tm.tm_mday = mday;
+  tm.tm_mon = mon;
+  tm.tm_year = year;
+  tm.tm_century = century;
+  return tm;
+}
+
+// The alarms fired, in order.
+static uint8_t fired[8];
+static uint8_t fired_count;
+static TM_T fired_at;
+
+static void alarm_fired(uint8_t id)
+{
+  if (fired_count < sizeof(fired))
+  {
+    fired[fired_count] = id;
+  }
+  fired_count++;
+  softclock.get(&fired_at);
+}
+
+static AlarmScheduler alarms(alarm_fired);
+
+static uint8_t bcd(uint8_t val)
+{
+  return ((val / 10) << 4) | (val % 10);
+}
+
+// Finishes the queued writes, as the RTC task does.
+static void run_queue(void)
+{
+  while (rtc_service());
+}
+
+// Sets the time, in the RTC and the software clock, and forgets the alarms
+// fired so far. Returns half way into the second.
+static TM_T set_time(const TM_T &tm)
+{
+  TM_T now = tm;
+
+  softclock.set(&now);
+  delay(500);
+  fired_count = 0;
+  return tm;
+}
+
+// Moves on a second at a time, half way into each, servicing the alarms.
+static TM_T step(uint16_t seconds)
+{
+  TM_T now;
+
+  for (uint16_t idx=0; idx < seconds; idx++)
+  {
+    delay(1000);
+    rtc_refresh();
+    alarms.service(softclock.get(&now));
+    run_queue();
+  }
+  return now;
+}
+
+// Alarm 1 matches the date, hour, minute and second 0 of the top of the
+// heap, and is enabled while there is one.
+static void check_programmed(int line)
+{
+  const SOFT_ALARM_T *top = alarms.next();
+
+  run_queue();
+  if (!top)
+  {
+    check_eq(rtc.reg(0x0E) & ALARM1, 0, "A1IE", "0", line);
+    return;
+  }
+
+  TM_T fire;
+
+  epoch_to_tm(top->next, &fire);
+  check_eq(rtc.reg(0x07), 0x00, "A1 seconds", "0", line);
+  check_eq(rtc.reg(0x08), bcd(top->min), "A1 minutes", "min", line);
+  check_eq(rtc.reg(0x09), bcd(top->hour), "A1 hours", "hour", line);
+  check_eq(rtc.reg(0x0A), bcd(fire.tm_mday), "A1 date", "mday", line);
+  check_eq(rtc.reg(0x0E) & ALARM1, ALARM1, "A1IE", "ALARM1", line);
+}
+
+static void test_add_remove(void)
+{
+  // Monday 1 January 2024, 08:00:00.
+  TM_T now = set_time(make_tm(0, 24, 1, 1, 1, 8, 0, 0));
+  uint8_t nine, half_eight, quarter_past;
+
+  CHECK(alarms.next() == NULL);
+  check_programmed(__LINE__);
+
+  nine = alarms.add(9, 0, ALARM_EVERY_DAY, true, &now);
+  CHECK_EQ(alarms.next()->id, nine);
+  check_programmed(__LINE__);
+
+  // Each nearer one goes to the top, and is programmed.
+  half_eight = alarms.add(8, 30, ALARM_EVERY_DAY, true, &now);
+  CHECK_EQ(alarms.next()->id, half_eight);
+  check_programmed(__LINE__);
+  quarter_past = alarms.add(8, 15, ALARM_WEEKDAYS, false, &now);
+  CHECK_EQ(alarms.next()->id, quarter_past);
+  check_programmed(__LINE__);
+
+  // A later one leaves the top alone.
+  CHECK(alarms.add(23, 59, ALARM_EVERY_DAY, true, &now) != 0);
+  CHECK_EQ(alarms.next()->id, quarter_past);
+  check_programmed(__LINE__);
+
+  // Removing the top brings up the next nearest.
+  CHECK(alarms.remove(quarter_past));
+  CHECK(!alarms.remove(quarter_past));
+  CHECK_EQ(alarms.next()->id, half_eight);
+  check_programmed(__LINE__);
+  CHECK(alarms.remove(half_eight));
+  CHECK_EQ(alarms.next()->id, nine);
+  check_programmed(__LINE__);
+
+  // Earlier today is tomorrow.
+  quarter_past = alarms.add(7, 15, ALARM_EVERY_DAY, true, &now);
+  CHECK_EQ(alarms.next()->id, nine);
+  check_programmed(__LINE__);
+
+  while (alarms.next())
+  {
+    alarms.remove(alarms.next()->id);
+  }
+  check_programmed(__LINE__);
+}
+
+static void test_week_days(void)
+{
+  // Monday 1 January 2024, 08:00:00.
+  TM_T now = set_time(make_tm(0, 24, 1, 1, 1, 8, 0, 0));
+  TM_T fire;
+  uint8_t id;
+
+  // The weekend is Saturday the 6th.
+  id = alarms.add(7, 0, ALARM_WEEKEND, true, &now);
+  epoch_to_tm(alarms.next()->next, &fire);
+  CHECK_EQ(fire.tm_mday, 6);
+  CHECK_EQ(fire.tm_hour, 7);
+  check_programmed(__LINE__);
+  alarms.remove(id);
+
+  // Sunday only, from Sunday after the time, is a week on.
+  now = set_time(make_tm(0, 24, 1, 7, 7, 8, 0, 0));
+  id = alarms.add(7, 0, ALARM_SUNDAY, true, &now);
+  epoch_to_tm(alarms.next()->next, &fire);
+  CHECK_EQ(fire.tm_mday, 14);
+  check_programmed(__LINE__);
+  alarms.remove(id);
+
+  // Weekdays from Friday evening is Monday, over the month end.
+  now = set_time(make_tm(0, 24, 5, 31, 5, 20, 0, 0));
+  id = alarms.add(6, 30, ALARM_WEEKDAYS, true, &now);
+  epoch_to_tm(alarms.next()->next, &fire);
+  CHECK_EQ(fire.tm_mon, 6);
+  CHECK_EQ(fire.tm_mday, 3);
+  check_programmed(__LINE__);
+  alarms.remove(id);
+
+  // No days at all is taken as every day.
+  id = alarms.add(21, 0, 0, true, &now);
+  epoch_to_tm(alarms.next()->next, &fire);
+  CHECK_EQ(fire.tm_mday, 31);
+  alarms.remove(id);
+  check_programmed(__LINE__);
+}
+
+static void test_firing(void)
+{
+  // Monday 1 January 2024, 08:00:50.
+  TM_T now = set_time(make_tm(0, 24, 1, 1, 1, 8, 0, 50));
+  uint8_t daily, once, later;
+  TM_T fire;
+
+  // Three due in the same second, one repeating and two not.
+  daily = alarms.add(8, 1, ALARM_EVERY_DAY, true, &now);
+  once = alarms.add(8, 1, ALARM_EVERY_DAY, false, &now);
+  later = alarms.add(8, 1, ALARM_EVERY_DAY, false, &now);
+  check_programmed(__LINE__);
+
+  step(9);
+  CHECK_EQ(fired_count, 0);
+  CHECK_EQ(rtc.reg(0x0F) & ALARM1, 0);
+  CHECK(rtc.intSqw());
+
+  // The DS3231 triggers at 08:01:00, pulling INT low, and all three fire
+  // from A1F in that second.
+  delay(1000);
+  CHECK(!rtc.intSqw());
+  rtc_refresh();
+  alarms.service(softclock.get(&now));
+  CHECK_EQ(now.tm_min, 1);
+  CHECK_EQ(now.tm_sec, 0);
+  CHECK_EQ(fired_count, 3);
+  CHECK_EQ(fired_at.tm_sec, 0);
+  CHECK(fired[0] == daily || fired[1] == daily || fired[2] == daily);
+  CHECK(fired[0] == once || fired[1] == once || fired[2] == once);
+  CHECK(fired[0] == later || fired[1] == later || fired[2] == later);
+
+  // A1F is cleared, the one-shots are gone and the repeat is tomorrow.
+  run_queue();
+  CHECK_EQ(rtc.reg(0x0F) & ALARM1, 0);
+  CHECK(rtc.intSqw());
+  CHECK_EQ(alarms.next()->id, daily);
+  epoch_to_tm(alarms.next()->next, &fire);
+  CHECK_EQ(fire.tm_mday, 2);
+  CHECK_EQ(fire.tm_hour, 8);
+  CHECK_EQ(fire.tm_min, 1);
+  check_programmed(__LINE__);
+  CHECK(!alarms.remove(once));
+  CHECK(!alarms.remove(later));
+
+  step(5);
+  CHECK_EQ(fired_count, 3);
+  alarms.remove(daily);
+  check_programmed(__LINE__);
+}
+
+static void test_early_clock(void)
+{
+  // Monday 1 January 2024, 08:00:58.
+  TM_T now = set_time(make_tm(0, 24, 1, 1, 1, 8, 0, 58));
+  TM_T before;
+  uint8_t id;
+
+  id = alarms.add(8, 1, ALARM_EVERY_DAY, true, &now);
+  check_programmed(__LINE__);
+
+  // A1F is set but the software clock is still in the second before, it
+  // fires and is rescheduled for tomorrow rather than straight away again.
+  delay(1500);
+  CHECK_EQ(rtc.reg(0x00), 0x00);
+  before = make_tm(0, 24, 1, 1, 1, 8, 0, 59);
+  rtc_refresh();
+  alarms.service(&before);
+  run_queue();
+  CHECK_EQ(fired_count, 1);
+  CHECK_EQ(fired[0], id);
+  alarms.service(&before);
+  run_queue();
+  CHECK_EQ(fired_count, 1);
+  check_programmed(__LINE__);
+  CHECK_EQ(alarms.next()->next % EPOCH_DAY, 8 * EPOCH_HOUR + EPOCH_MINUTE);
+  alarms.remove(id);
+}
+
+static void test_fallback(void)
+{
+  // Monday 1 January 2024, 08:00:00.
+  TM_T now = set_time(make_tm(0, 24, 1, 1, 1, 8, 0, 0));
+  uint8_t id;
+
+  // The time is set past the alarm, so the DS3231 never triggers. It fires
+  // once it is the grace period late.
+  id = alarms.add(8, 1, ALARM_EVERY_DAY, false, &now);
+  check_programmed(__LINE__);
+  set_time(make_tm(0, 24, 1, 1, 1, 8, 1, 30));
+  step(1);
+  CHECK_EQ(fired_count, 1);
+  CHECK_EQ(fired[0], id);
+  CHECK_EQ(rtc.reg(0x0F) & ALARM1, 0);
+  check_programmed(__LINE__);
+
+  // Without A1F, not before then.
+  id = alarms.add(8, 2, ALARM_EVERY_DAY, false, &now);
+  fired_count = 0;
+  run_queue();
+  rtc.setReg(0x0A, 0x09);       // So Alarm 1 can't match.
+  now = step(28);
+  CHECK_EQ(now.tm_min, 1);
+  CHECK_EQ(now.tm_sec, 59);
+  now = step(ALARM_SCHED_GRACE_S);
+  CHECK_EQ(fired_count, 0);
+  CHECK_EQ(rtc.reg(0x0F) & ALARM1, 0);
+  now = step(1);
+  CHECK_EQ(now.tm_sec, ALARM_SCHED_GRACE_S);
+  CHECK_EQ(fired_count, 1);
+  CHECK_EQ(fired[0], id);
+  check_programmed(__LINE__);
+
+  // A stale A1F with nothing due doesn't fire the top early.
+  now = set_time(make_tm(0, 24, 1, 1, 1, 8, 0, 0));
+  id = alarms.add(9, 0, ALARM_EVERY_DAY, false, &now);
+  rtc.setReg(0x0F, rtc.reg(0x0F) | ALARM1);
+  step(2);
+  CHECK_EQ(fired_count, 0);
+  CHECK_EQ(alarms.next()->id, id);
+  alarms.remove(id);
+}
+
+int main(void)
+{
+  Wire.begin();
+  Wire.attach(DS3231_ADDRESS, &rtc);
+  softclock.begin();
+
+  test_add_remove();
+  test_week_days();
+  test_firing();
+  test_early_clock();
+  test_fallback();
+
+  printf("test_alarms: %d checks, %d failed\n", checks, failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,530 @@
+// Tests of the display drawing against the framebuffer display.
+//
+// Checks what the host display counts for each call, that the glyph
+// functions draw the same pixels as drawChar(), and that an optimised
+// display list draws the same screen as its ops drawn one by one, and that
+// the compositor's fills stay behind its components. None of it depends on
+// the shapes in the font tables, only on their formats.
+
+#include <Arduino.h>
+#include <Adafruit_ILI9341_STM.h>
+#include "../DisplayList.h"
+#include "../Glyph.h"
+#include "../GUI.h"
+
+static Adafruit_ILI9341_STM tft(0, 0);
+static Adafruit_ILI9341_STM direct(0, 0);   // The same drawing, unoptimised.
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+#define CHECK_EQ(a, b) check_eq((long)(a), (long)(b), #a, #b, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+  checks++;
+  if (!ok)
+  {
+    failures++;
+    printf("test_display.cpp:%d: CHECK(%s) failed\n", line, what);
+  }
+}
+
+static void check_eq(long a, long b, const char *what_a, const char *what_b,
+  int line)
+{
+  checks++;
+  if (a != b)
+  {
+    failures++;
+    printf("test_display.cpp:%d: %s == %s failed, %ld != %ld\n",
+      line, what_a, what_b, a, b);
+  }
+}
+
+// The costs of the calls since the last call.
+static TFT_STATS_T costs(Adafruit_ILI9341_STM &screen)
+{
+  TFT_STATS_T stats;
+
+  screen.getStats(&stats, true);
+  return stats;
+}
+
+// Number of pixels in a rectangle that differ between two screens.
+static int differ(Adafruit_ILI9341_STM &a, Adafruit_ILI9341_STM &b,
+  int x, int y, int w, int h)
+{
+  int count = 0;
+
+  for (int row=y; row < y + h; row++)
+  {
+    for (int col=x; col < x + w; col++)
+    {
+      count += a.readPixel(col, row) != b.readPixel(col, row);
+    }
+  }
+  return count;
+}
+
+static int differ(Adafruit_ILI9341_STM &a, Adafruit_ILI9341_STM &b)
+{
+  return differ(a, b, 0, 0, a.width(), a.height());
+}
+
+static void clear(void)
+{
+  tft.fillScreen(ILI9341_BLACK);
+  direct.fillScreen(ILI9341_BLACK);
+  costs(tft);
+  costs(direct);
+}
+
+static void test_screen(void)
+{
+  tft.begin();
+  tft.setRotation(3);
+  CHECK_EQ(tft.width(), 320);
+  CHECK_EQ(tft.height(), 240);
+  direct.begin();
+  direct.setRotation(3);
+
+  tft.fillScreen(ILI9341_WHITE);
+  CHECK_EQ(tft.readPixel(0, 0), ILI9341_WHITE);
+  CHECK_EQ(tft.readPixel(319, 239), ILI9341_WHITE);
+  CHECK_EQ(tft.readPixel(320, 0), 0);
+  CHECK_EQ(tft.readPixel(0, 240), 0);
+
+  tft.setRotation(0);
+  CHECK_EQ(tft.width(), 240);
+  CHECK_EQ(tft.height(), 320);
+  tft.setRotation(3);
+}
+
+static void test_costs(void)
+{
+  TFT_STATS_T stats;
+  uint64_t start;
+  uint16_t pixels[6] = { 1, 2, 3, 4, 5, 6 };
+
+  clear();
+
+  // A fill is one window and its pixels, and takes their bus time.
+  start = host_time_ns();
+  tft.fillRect(10, 20, 30, 4, ILI9341_RED);
+  stats = costs(tft);
+  CHECK_EQ(stats.total.calls, 1);
+  CHECK_EQ(stats.call[TFT_FILL_RECT].calls, 1);
+  CHECK_EQ(stats.total.windows, 1);
+  CHECK_EQ(stats.total.pixels, 120);
+  CHECK_EQ(stats.total.bytes, ILI9341_WINDOW_BYTES + 240);
+  CHECK_EQ(host_time_ns() - start,
+    Adafruit_ILI9341_STM::busTimeNs(ILI9341_WINDOW_BYTES + 240,
+      ILI9341_SPI_HZ));
+  CHECK_EQ(tft.readPixel(10, 20), ILI9341_RED);
+  CHECK_EQ(tft.readPixel(39, 23), ILI9341_RED);
+  CHECK_EQ(tft.readPixel(40, 23), ILI9341_BLACK);
+  CHECK_EQ(tft.readPixel(39, 24), ILI9341_BLACK);
+
+  // Fills are clipped to the screen, and cost nothing when off it.
+  tft.fillRect(-5, -5, 10, 10, ILI9341_RED);
+  stats = costs(tft);
+  CHECK_EQ(stats.total.pixels, 25);
+  tft.fillRect(310, 235, 20, 20, ILI9341_RED);
+  stats = costs(tft);
+  CHECK_EQ(stats.total.pixels, 50);
+  tft.fillRect(320, 0, 10, 10, ILI9341_RED);
+  tft.fillRect(0, 0, 0, 10, ILI9341_RED);
+  tft.drawPixel(-1, 0, ILI9341_RED);
+  stats = costs(tft);
+  CHECK_EQ(stats.total.calls, 3);
+  CHECK_EQ(stats.total.bytes, 0);
+
+  // Lines and outlines are counted against the call that was made.
+  tft.drawFastHLine(0, 100, 50, ILI9341_WHITE);
+  tft.drawFastVLine(0, 100, 50, ILI9341_WHITE);
+  tft.drawRect(100, 100, 10, 5, ILI9341_WHITE);
+  stats = costs(tft);
+  CHECK_EQ(stats.total.calls, 3);
+  CHECK_EQ(stats.call[TFT_DRAW_HLINE].pixels, 50);
+  CHECK_EQ(stats.call[TFT_DRAW_VLINE].pixels, 50);
+  CHECK_EQ(stats.call[TFT_DRAW_RECT].windows, 4);
+  CHECK_EQ(stats.call[TFT_DRAW_RECT].pixels, 30);
+  CHECK_EQ(stats.call[TFT_FILL_RECT].calls, 0);
+  CHECK_EQ(tft.readPixel(104, 102), ILI9341_BLACK);
+  CHECK_EQ(tft.readPixel(109, 104), ILI9341_WHITE);
+
+  // Pixels go to the window a row at a time.
+  tft.setAddrWindow(200, 200, 202, 201);
+  tft.pushColors(pixels, 6);
+  stats = costs(tft);
+  CHECK_EQ(stats.total.windows, 1);
+  CHECK_EQ(stats.total.pixels, 6);
+  CHECK_EQ(stats.call[TFT_SET_ADDR_WINDOW].bytes, ILI9341_WINDOW_BYTES);
+  CHECK_EQ(stats.call[TFT_PUSH_COLORS].bytes, 12);
+  CHECK_EQ(tft.readPixel(202, 200), 3);
+  CHECK_EQ(tft.readPixel(200, 201), 4);
+
+  // A character with a background is one window, without it is drawn a
+  // run or a pixel at a time.
+  tft.setTextColor(ILI9341_WHITE, ILI9341_BLACK);
+  for (int font=2; font <= 7; font++)
+  {
+    int width = tft.drawChar('8', 0, 0, font);
+
+    stats = costs(tft);
+    if (font == 3 || font == 5)
+    {
+      CHECK_EQ(width, 0);
+      CHECK_EQ(stats.total.bytes, 0);
+      continue;
+    }
+    CHECK(width > 0);
+    CHECK_EQ(stats.call[TFT_DRAW_CHAR].windows, 1);
+  }
+  tft.setTextColor(ILI9341_WHITE);
+  tft.drawChar('8', 0, 0, 7);
+  stats = costs(tft);
+  CHECK(stats.call[TFT_DRAW_CHAR].windows > 1);
+  CHECK_EQ(stats.total.calls, 1);
+}
+
+static void test_strings(void)
+{
+  TFT_STATS_T stats;
+  int width;
+
+  clear();
+  tft.setTextColor(ILI9341_WHITE, ILI9341_BLACK);
+  direct.setTextColor(ILI9341_WHITE, ILI9341_BLACK);
+
+  // A string is its characters one after another.
+  width = tft.drawString("12:34", 10, 10, 4);
+  stats = costs(tft);
+  CHECK_EQ(width, tft.textWidth("12:34", 4));
+  CHECK_EQ(stats.total.calls, 1);
+  CHECK_EQ(stats.call[TFT_DRAW_STRING].windows, 5);
+  width = 10;
+  for (const char *c="12:34"; *c; c++)
+  {
+    width += direct.drawChar(*c, width, 10, 4);
+  }
+  CHECK_EQ(differ(tft, direct), 0);
+
+  // Centred strings don't go off the left edge.
+  clear();
+  tft.drawCentreString("SET", 160, 10, 4);
+  direct.drawString("SET", 160 - (direct.textWidth("SET", 4) / 2), 10, 4);
+  CHECK_EQ(differ(tft, direct), 0);
+  tft.drawCentreString("SET DAY OF WEEK", 5, 50, 4);
+  direct.drawString("SET DAY OF WEEK", 0, 50, 4);
+  CHECK_EQ(differ(tft, direct), 0);
+}
+
+// The glyph functions draw the same pixels as drawChar().
+static void test_glyphs(void)
+{
+  static const char glyphs[] = "0123456789:.";
+  const int fonts[] = { 6, 7 };
+
+  glyph_enable(true);
+  glyph_enable_delta(true);
+  direct.setTextColor(ILI9341_WHITE, ILI9341_BLACK);
+
+  for (int font : fonts)
+  {
+    for (const char *c=glyphs; *c; c++)
+    {
+      int width;
+
+      clear();
+      width = glyph_draw(&tft, *c, 20, 30, font, ILI9341_WHITE, ILI9341_BLACK);
+      CHECK_EQ(width, direct.drawChar(*c, 20, 30, font));
+      CHECK_EQ(costs(tft).total.windows, 1);
+      CHECK_EQ(differ(tft, direct), 0);
+
+      // Changing it into each of the others.
+      for (const char *to=glyphs; *to; to++)
+      {
+        glyph_draw(&tft, *c, 20, 30, font, ILI9341_WHITE, ILI9341_BLACK);
+        if (glyph_draw_delta(&tft, *c, *to, 20, 30, font, ILI9341_WHITE,
+                             ILI9341_BLACK))
+        {
+          direct.drawChar(*to, 20, 30, font);
+          CHECK_EQ(differ(tft, direct), 0);
+        }
+      }
+    }
+  }
+
+  // Only the clock glyphs, and only with a background.
+  CHECK_EQ(glyph_draw(&tft, 'A', 0, 0, 7, ILI9341_WHITE, ILI9341_BLACK), 0);
+  CHECK_EQ(glyph_draw(&tft, '1', 0, 0, 4, ILI9341_WHITE, ILI9341_BLACK), 0);
+  CHECK_EQ(glyph_draw(&tft, '1', 0, 0, 7, ILI9341_WHITE, ILI9341_WHITE), 0);
+}
+
+// A Button, a fill hidden by a later one, fills that merge, and glyphs and
+// strings over fills. The display list is drawn on 'tft', the same ops one
+// by one on 'direct'.
+static void test_display_list(void)
+{
+  TFT_STATS_T stats;
+  DL_COST_T cost;
+
+  clear();
+  displaylist.getCost(&cost, true);
+
+  displaylist.Begin(&tft);
+  displaylist.Fill(0, 0, 320, 240, ILI9341_BLACK);
+  displaylist.Fill(20, 20, 100, 40, ILI9341_DARKGREEN);
+  displaylist.Rect(20, 20, 100, 40, ILI9341_WHITE);
+  displaylist.String("Ok", 70, 28, 4, ILI9341_WHITE, ILI9341_DARKGREEN, true);
+  displaylist.Fill(200, 20, 50, 50, ILI9341_RED);
+  displaylist.Fill(190, 10, 80, 80, ILI9341_BLUE);
+  displaylist.Fill(20, 100, 40, 20, ILI9341_RED);
+  displaylist.Fill(60, 100, 40, 20, ILI9341_RED);
+  displaylist.Fill(20, 150, 200, 60, ILI9341_NAVY);
+  displaylist.Glyph('1', 30, 160, 7, ILI9341_WHITE, ILI9341_NAVY);
+  displaylist.GlyphDelta('1', '2', 30, 160, 7, ILI9341_WHITE, ILI9341_NAVY);
+  displaylist.Glyph(':', 70, 160, 6, ILI9341_WHITE, ILI9341_NAVY);
+  displaylist.String("Sa", 100, 170, 2, ILI9341_WHITE, ILI9341_NAVY);
+  displaylist.End();
+
+  direct.fillRect(0, 0, 320, 240, ILI9341_BLACK);
+  direct.fillRect(20, 20, 100, 40, ILI9341_DARKGREEN);
+  direct.drawRect(20, 20, 100, 40, ILI9341_WHITE);
+  direct.setTextColor(ILI9341_WHITE, ILI9341_DARKGREEN);
+  direct.drawCentreString("Ok", 70, 28, 4);
+  direct.fillRect(200, 20, 50, 50, ILI9341_RED);
+  direct.fillRect(190, 10, 80, 80, ILI9341_BLUE);
+  direct.fillRect(20, 100, 40, 20, ILI9341_RED);
+  direct.fillRect(60, 100, 40, 20, ILI9341_RED);
+  direct.fillRect(20, 150, 200, 60, ILI9341_NAVY);
+  direct.setTextColor(ILI9341_WHITE, ILI9341_NAVY);
+  direct.drawChar('2', 30, 160, 7);
+  direct.drawChar(':', 70, 160, 6);
+  direct.drawString("Sa", 100, 170, 2);
+
+  CHECK_EQ(differ(tft, direct), 0);
+
+  // The optimised list sends less, and its estimate is close.
+  stats = costs(tft);
+  displaylist.getCost(&cost, true);
+  CHECK_EQ(cost.recorded, 13);
+  CHECK(cost.executed < cost.recorded);
+  CHECK(stats.total.bytes < costs(direct).total.bytes);
+  CHECK_EQ(cost.windows, stats.total.windows);
+  CHECK(cost.pixels <= stats.total.pixels);
+  CHECK(cost.pixels + 256 >= stats.total.pixels);
+}
+
+// Lists only draw at the outermost End(), and lists longer than the display
+// list are drawn in parts.
+static void test_list_nesting(void)
+{
+  clear();
+  displaylist.Begin(&tft);
+  displaylist.Begin(&tft);
+  displaylist.Fill(0, 0, 10, 10, ILI9341_RED);
+  displaylist.End();
+  CHECK_EQ(costs(tft).total.calls, 0);
+  CHECK_EQ(tft.readPixel(0, 0), ILI9341_BLACK);
+  displaylist.End();
+  CHECK_EQ(costs(tft).total.calls, 1);
+  CHECK_EQ(tft.readPixel(0, 0), ILI9341_RED);
+
+  clear();
+  displaylist.Begin(&tft);
+  for (int idx=0; idx < (DL_SIZE * 2) + 5; idx++)
+  {
+    uint16_t colour = (idx & 1) ? ILI9341_RED : ILI9341_BLUE;
+
+    displaylist.Fill(idx * 3, idx * 2, 20, 20, colour);
+    direct.fillRect(idx * 3, idx * 2, 20, 20, colour);
+  }
+  displaylist.End();
+  CHECK_EQ(differ(tft, direct), 0);
+}
+
+// Random lists of overlapping ops draw the same screen optimised as drawn one
+// by one, whatever is hidden, merged or reordered.
+static void test_list_random(void)
+{
+  static const uint16_t colours[] = {
+    ILI9341_BLACK, ILI9341_WHITE, ILI9341_RED, ILI9341_DARKGREEN
+  };
+  static const char *strings[] = { "Mo", "12", "Sat", "Ok", "Jan 1st" };
+  static const int fonts[] = { 2, 4, 6, 7 };
+  uint32_t seed = 12345;
+  int failed = 0;
+
+  for (int list=0; list < 200; list++)
+  {
+    int ops = 1 + (list % DL_SIZE);
+
+    clear();
+    displaylist.Begin(&tft);
+    for (int idx=0; idx < ops; idx++)
+    {
+      int x, y, w, h, fg, bg, font;
+
+      seed = (seed * 1103515245) + 12345;
+      x = (seed >> 8) % 280;
+      y = (seed >> 16) % 200;
+      w = 1 + ((seed >> 4) % 60);
+      h = 1 + ((seed >> 12) % 40);
+      fg = colours[(seed >> 20) & 3];
+      bg = colours[(seed >> 22) & 3];
+      font = fonts[(seed >> 24) & 3];
+
+      switch ((seed >> 28) & 3)
+      {
+        case 0:
+          displaylist.Fill(x, y, w, h, fg);
+          direct.fillRect(x, y, w, h, fg);
+          break;
+        case 1:
+          // An outline round a fill, as Button draws.
+          displaylist.Fill(x, y, w, h, bg);
+          displaylist.Rect(x, y, w, h, fg);
+          direct.fillRect(x, y, w, h, bg);
+          direct.drawRect(x, y, w, h, fg);
+          break;
+        case 2:
+          if (fg == bg)
+            bg = colours[((seed >> 22) + 1) & 3];
+          displaylist.Glyph('0' + (seed % 11), x, y, font, fg, bg);
+          direct.setTextColor(fg, bg);
+          direct.drawChar('0' + (seed % 11), x, y, font);
+          break;
+        default:
+          displaylist.String(strings[seed % 5], x, y, font, fg, bg);
+          direct.setTextColor(fg, bg);
+          direct.drawString(strings[seed % 5], x, y, font);
+          break;
+      }
+    }
+    displaylist.End();
+    failed += differ(tft, direct) != 0;
+  }
+  CHECK_EQ(failed, 0);
+}
+
+// A list with only fills and outlines is costed exactly.
+static void test_fill_costs(void)
+{
+  TFT_STATS_T stats;
+  DL_COST_T cost;
+
+  clear();
+  displaylist.getCost(&cost, true);
+  displaylist.Begin(&tft);
+  for (int idx=0; idx < 60; idx++)
+  {
+    displaylist.Fill((idx * 37) % 300, (idx * 53) % 220, 20, 20,
+                     (idx & 1) ? ILI9341_RED : ILI9341_BLUE);
+    if (idx % 5 == 0)
+    {
+      displaylist.Rect((idx * 37) % 300, (idx * 53) % 220, 20, 20,
+                       ILI9341_WHITE);
+    }
+  }
+  displaylist.End();
+  stats = costs(tft);
+  displaylist.getCost(&cost, true);
+
+  CHECK_EQ(cost.windows, stats.total.windows);
+  CHECK_EQ(cost.pixels, stats.total.pixels);
+  CHECK_EQ(cost.bytes, stats.total.bytes);
+}
+
+// More fills than the compositor holds, all under one component, still leave
+// the component drawn over them.
+static void test_compositor(void)
+{
+  static const int colours[] = { ILI9341_RED, ILI9341_BLUE, ILI9341_GREEN };
+  Label label(&tft, 100, 100, "12:34");
+  int drawn = 0;
+  int kept = 0;
+
+  label.setColor(ILI9341_WHITE, ILI9341_BLACK);
+
+  // The label on its own, on the other screen.
+  clear();
+  label.setScreen(&direct);
+  label.Draw();
+  label.setScreen(&tft);
+
+  compositor.Begin();
+  label.Invalidate();
+  for (int idx=0; idx < GUI_FILL_SIZE + 4; idx++)
+  {
+    compositor.Fill(&tft, 80 + idx * 2, 90, 160, 50, colours[idx % 3]);
+  }
+  compositor.Flush();
+
+  for (int row=0; row < tft.height(); row++)
+  {
+    for (int col=0; col < tft.width(); col++)
+    {
+      if (direct.readPixel(col, row) == ILI9341_WHITE)
+      {
+        drawn++;
+        kept += tft.readPixel(col, row) == ILI9341_WHITE;
+      }
+    }
+  }
+  CHECK(drawn > 0);
+  CHECK_EQ(kept, drawn);
+
+  // And the last fill is on top of the others.
+  CHECK_EQ(tft.readPixel(80 + (GUI_FILL_SIZE + 3) * 2 + 159, 139),
+           colours[(GUI_FILL_SIZE + 3) % 3]);
+}
+
+static void test_ppm(void)
+{
+  const char *path = "test_display.ppm";
+  char header[16];
+  uint8_t rgb[3];
+  FILE *file;
+
+  clear();
+  tft.fillRect(0, 0, 1, 1, ILI9341_WHITE);
+  tft.fillRect(1, 0, 1, 1, ILI9341_RED);
+  CHECK(tft.writePPM(path));
+
+  file = fopen(path, "rb");
+  CHECK(file != NULL);
+  if (!file)
+    return;
+
+  CHECK(fgets(header, sizeof(header), file) && !strcmp(header, "P6\n"));
+  CHECK(fgets(header, sizeof(header), file) && !strcmp(header, "320 240\n"));
+  CHECK(fgets(header, sizeof(header), file) && !strcmp(header, "255\n"));
+  CHECK_EQ(fread(rgb, 1, 3, file), 3);
+  CHECK(rgb[0] == 255 && rgb[1] == 255 && rgb[2] == 255);
+  CHECK_EQ(fread(rgb, 1, 3, file), 3);
+  CHECK(rgb[0] == 255 && rgb[1] == 0 && rgb[2] == 0);
+  fseek(file, 0, SEEK_END);
+  CHECK_EQ(ftell(file), 15 + (320 * 240 * 3));
+  fclose(file);
+  remove(path);
+}
+
+int main(void)
+{
+  test_screen();
+  test_costs();
+  test_strings();
+  test_glyphs();
+  test_display_list();
+  test_list_nesting();
+  test_list_random();
+  test_fill_costs();
+  test_compositor();
+  test_ppm();
+
+  printf("test_display: %d checks, %d failed\n", checks, failures);
+  return failures ? 1 : 0;
+}
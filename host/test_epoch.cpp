@@ -0,0 +1,223 @@
+// Tests of the epoch conversions against a naive calendar.
+//
+// Every day from 2000-01-01 to 2199-12-31 is counted through one at a time
+// with the Gregorian rules, and converted both ways.
+
+#include <Arduino.h>
+#include "../Epoch.h"
+
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+#define CHECK_EQ(a, b) check_eq((long)(a), (long)(b), #a, #b, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+  checks++;
+  if (!ok)
+  {
+    failures++;
+    printf("test_epoch.cpp:%d: CHECK(%s) failed\n", line, what);
+  }
+}
+
+static void check_eq(long a, long b, const char *what_a, const char *what_b,
+  int line)
+{
+  checks++;
+  if (a != b)
+  {
+    failures++;
+    printf("test_epoch.cpp:%d: %s == %s failed, %ld != %ld\n",
+      line, what_a, what_b, a, b);
+  }
+}
+
+static TM_T make_tm(uint8_t century, uint8_t year, uint8_t mon, uint8_t mday,
+  uint8_t wday, uint8_t hour, uint8_t min, uint8_t sec)
+{
+  TM_T tm;
+
+  tm.tm_sec = sec;
+  tm.tm_min = min;
+  tm.tm_hour = hour;
+  tm.tm_wday = wday;
+  tm.tm_mday = mday;
+  tm.tm_mon = mon;
+  tm.tm_year = year;
+  tm.tm_century = century;
+  return tm;
+}
+
+static void check_tm(const TM_T &tm, const TM_T &expected, int line)
+{
+  check(memcmp(&tm, &expected, sizeof(tm)) == 0, "date and time", line);
+  if (memcmp(&tm, &expected, sizeof(tm)))
+  {
+    printf("  got %d%02d-%02d-%02d (%d) %02d:%02d:%02d\n",
+      20 + tm.tm_century, tm.tm_year, tm.tm_mon, tm.tm_mday, tm.tm_wday,
+      tm.tm_hour, tm.tm_min, tm.tm_sec);
+    printf("  expected %d%02d-%02d-%02d (%d) %02d:%02d:%02d\n",
+      20 + expected.tm_century, expected.tm_year, expected.tm_mon,
+      expected.tm_mday, expected.tm_wday, expected.tm_hour, expected.tm_min,
+      expected.tm_sec);
+  }
+}
+
+// The naive calendar.
+static bool naive_leap(int year)
+{
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static int naive_month_days(int year, int month)
+{
+  static const int days[12] = {
+    31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+  };
+
+  return days[month - 1] + ((month == 2 && naive_leap(year)) ? 1 : 0);
+}
+
+// A different time of day for each day, so every field is exercised.
+static TM_T naive_tm(int year, int month, int mday, int wday, uint32_t day)
+{
+  uint32_t secs = (day * 7919UL) % EPOCH_DAY;
+
+  return make_tm(year / 100 - 20, year % 100, month, mday, wday,
+    secs / 3600, (secs / 60) % 60, secs % 60);
+}
+
+static void test_every_day(void)
+{
+  int year = 2000;
+  int month = 1;
+  int mday = 1;
+  int wday = 6;                 // 2000-01-01 was a Saturday.
+  uint32_t day = 0;
+  uint32_t bad_days = 0;
+
+  while (year < 2200)
+  {
+    TM_T expected = naive_tm(year, month, mday, wday, day);
+    EPOCH_T epoch = (EPOCH_T)day * EPOCH_DAY + (day * 7919UL) % EPOCH_DAY;
+    TM_T tm;
+
+    epoch_to_tm(epoch, &tm);
+    if (tm_to_epoch(&expected) != epoch ||
+      memcmp(&tm, &expected, sizeof(tm)) != 0)
+    {
+      if (bad_days++ < 5)
+      {
+        check_tm(tm, expected, __LINE__);
+        CHECK_EQ(tm_to_epoch(&expected), epoch);
+      }
+    }
+
+    if (mday == 1)
+    {
+      CHECK_EQ(days_in_month(month, year % 100, year / 100 - 20),
+        naive_month_days(year, month));
+      if (month == 1)
+      {
+        CHECK_EQ(is_leap_year(year % 100, year / 100 - 20),
+          naive_leap(year));
+      }
+    }
+
+    day++;
+    wday = (wday % 7) + 1;
+    if (++mday > naive_month_days(year, month))
+    {
+      mday = 1;
+      if (++month > 12)
+      {
+        month = 1;
+        year++;
+      }
+    }
+  }
+
+  CHECK_EQ(bad_days, 0);
+  CHECK_EQ(day, 73049);
+}
+
+static void test_bounds(void)
+{
+  TM_T first = make_tm(0, 0, 1, 1, 6, 0, 0, 0);
+  TM_T last = make_tm(1, 99, 12, 31, 2, 23, 59, 59);
+  TM_T tm;
+
+  CHECK(tm_to_epoch(&first) == 0);
+  check_tm(*epoch_to_tm(0, &tm), first, __LINE__);
+
+  // 73049 days, which needs more than 32 bits of seconds.
+  CHECK(tm_to_epoch(&last) == 73049ULL * EPOCH_DAY - 1);
+  check_tm(*epoch_to_tm(73049ULL * EPOCH_DAY - 1, &tm), last, __LINE__);
+
+  // The century, and 2100 isn't a leap year.
+  tm = make_tm(0, 99, 12, 31, 4, 23, 59, 59);
+  check_tm(*epoch_to_tm(tm_to_epoch(&tm) + 1, &tm),
+    make_tm(1, 0, 1, 1, 5, 0, 0, 0), __LINE__);
+  tm = make_tm(1, 0, 2, 28, 7, 23, 59, 59);
+  check_tm(*epoch_to_tm(tm_to_epoch(&tm) + 1, &tm),
+    make_tm(1, 0, 3, 1, 1, 0, 0, 0), __LINE__);
+  CHECK(!is_leap_year(0, 1));
+  CHECK(is_leap_year(0, 0));
+  CHECK_EQ(days_in_month(2, 0, 1), 28);
+  CHECK_EQ(days_in_month(2, 0, 0), 29);
+}
+
+static void test_add_diff(void)
+{
+  TM_T from = make_tm(0, 20, 2, 28, 5, 12, 0, 0);
+  TM_T to = make_tm(0, 20, 3, 1, 7, 12, 0, 0);
+  TM_T tm;
+  EPOCH_T epoch = tm_to_epoch(&from);
+
+  // Over the leap day, both ways.
+  CHECK_EQ(epoch_diff(tm_to_epoch(&to), epoch), 2 * EPOCH_DAY);
+  CHECK_EQ(epoch_diff(epoch, tm_to_epoch(&to)), -2 * (long)EPOCH_DAY);
+  check_tm(*epoch_to_tm(epoch_add(epoch, 2 * EPOCH_DAY), &tm), to,
+    __LINE__);
+  check_tm(*epoch_to_tm(epoch_add(tm_to_epoch(&to), -2 * (int32_t)EPOCH_DAY),
+    &tm), from, __LINE__);
+
+  // And none in 2100.
+  from = make_tm(1, 0, 2, 28, 7, 12, 0, 0);
+  to = make_tm(1, 0, 3, 1, 1, 12, 0, 0);
+  CHECK_EQ(epoch_diff(tm_to_epoch(&to), tm_to_epoch(&from)), EPOCH_DAY);
+
+  // Back over the century and a year on.
+  from = make_tm(1, 0, 1, 1, 5, 0, 0, 30);
+  check_tm(*epoch_to_tm(epoch_add(tm_to_epoch(&from), -60), &tm),
+    make_tm(0, 99, 12, 31, 4, 23, 59, 30), __LINE__);
+  check_tm(*epoch_to_tm(epoch_add(tm_to_epoch(&from), 365 * EPOCH_DAY),
+    &tm), make_tm(1, 1, 1, 1, 6, 0, 0, 30), __LINE__);
+
+  // A week on is the same day of the week, and the difference is exact
+  // across the whole range up to 68 years.
+  for (uint32_t day=0; day < 73049 - 24856; day += 997)
+  {
+    EPOCH_T start = (EPOCH_T)day * EPOCH_DAY + 12345;
+    TM_T week;
+
+    epoch_to_tm(start, &tm);
+    epoch_to_tm(epoch_add(start, EPOCH_WEEK), &week);
+    CHECK_EQ(week.tm_wday, tm.tm_wday);
+    CHECK_EQ(epoch_diff(epoch_add(start, 0x7FFFFFFF), start), 0x7FFFFFFF);
+    CHECK_EQ(epoch_diff(start, epoch_add(start, 0x7FFFFFFF)),
+      -0x7FFFFFFFL);
+  }
+}
+
+int main(void)
+{
+  test_every_day();
+  test_bounds();
+  test_add_diff();
+
+  printf("test_epoch: %d checks, %d failed\n", checks, failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,310 @@
+// Tests of the gesture recogniser against touch event sequences.
+//
+// The events carry their own timestamps and poll() is passed the time, so
+// none of it waits on the simulated millis().
+
+#include <Arduino.h>
+#include "../Gesture.h"
+
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK_EQ(a, b) check_eq((long)(a), (long)(b), #a, #b, __LINE__)
+
+// What feed() and poll() return when there is no gesture.
+#define NONE (-1)
+
+static void check_eq(long a, long b, const char *what_a, const char *what_b,
+  int line)
+{
+  checks++;
+  if (a != b)
+  {
+    failures++;
+    printf("test_gesture.cpp:%d: %s == %s failed, %ld != %ld\n",
+      line, what_a, what_b, a, b);
+  }
+}
+
+static GestureRecogniser gestures;
+static GESTURE_T gesture;
+
+// Feeds one event, returning the gesture type or NONE.
+static int feed(uint8_t type, uint32_t ms, uint16_t x, uint16_t y)
+{
+  TOUCH_EVENT_T event;
+
+  event.ms = ms;
+  event.x = x;
+  event.y = y;
+  event.type = type;
+  event.confidence = 255;
+  return gestures.feed(event, &gesture) ? gesture.type : NONE;
+}
+
+static int poll(uint32_t ms)
+{
+  return gestures.poll(ms, &gesture) ? gesture.type : NONE;
+}
+
+// When poll() is next due, or NONE.
+static long due(void)
+{
+  uint32_t due_ms;
+
+  return gestures.due(&due_ms) ? (long)due_ms : NONE;
+}
+
+// Starts each test with the default thresholds and nothing in progress.
+static void start(void)
+{
+  GestureRecogniser fresh;
+
+  gestures = fresh;
+}
+
+static void test_tap(void)
+{
+  GESTURE_CONFIG_T config = {
+    GESTURE_TAP_MS, GESTURE_LONG_PRESS_MS, 0, GESTURE_SLOP_PX,
+    GESTURE_SWIPE_PX, GESTURE_SWIPE_MS
+  };
+
+  // Reported by poll() once a double tap is no longer possible, where the
+  // touch started.
+  start();
+  CHECK_EQ(feed(TOUCH_PRESS, 1000, 100, 100), NONE);
+  CHECK_EQ(due(), 1000 + GESTURE_LONG_PRESS_MS);
+  CHECK_EQ(feed(TOUCH_MOVE, 1050, 105, 95), NONE);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1100, 104, 96), NONE);
+  CHECK_EQ(due(), 1100 + GESTURE_DOUBLE_TAP_MS + 1);
+  CHECK_EQ(poll(1100 + GESTURE_DOUBLE_TAP_MS), NONE);
+  CHECK_EQ(poll(1100 + GESTURE_DOUBLE_TAP_MS + 1), GESTURE_TAP);
+  CHECK_EQ(gesture.x, 100);
+  CHECK_EQ(gesture.y, 100);
+  CHECK_EQ(due(), NONE);
+  CHECK_EQ(poll(5000), NONE);
+
+  // Or by the next press, if poll() wasn't called in time.
+  CHECK_EQ(feed(TOUCH_PRESS, 6000, 10, 20), NONE);
+  CHECK_EQ(feed(TOUCH_RELEASE, 6100, 10, 20), NONE);
+  CHECK_EQ(feed(TOUCH_PRESS, 7000, 200, 200), GESTURE_TAP);
+  CHECK_EQ(gesture.x, 10);
+  CHECK_EQ(gesture.y, 20);
+
+  // Too long a touch isn't a tap, nor one that moved and came back.
+  start();
+  feed(TOUCH_PRESS, 1000, 100, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1000 + GESTURE_TAP_MS + 1, 100, 100), NONE);
+  CHECK_EQ(due(), NONE);
+  feed(TOUCH_PRESS, 3000, 100, 100);
+  feed(TOUCH_MOVE, 3050, 100 + GESTURE_SLOP_PX + 1, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, 3100, 100, 100), NONE);
+  CHECK_EQ(due(), NONE);
+
+  // With double taps disabled it is reported on the release.
+  start();
+  gestures.setConfig(&config);
+  feed(TOUCH_PRESS, 1000, 100, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1100, 100, 100), GESTURE_TAP);
+  CHECK_EQ(due(), NONE);
+}
+
+static void test_double_tap(void)
+{
+  // Two taps close together, reported on the second release.
+  start();
+  feed(TOUCH_PRESS, 1000, 100, 100);
+  feed(TOUCH_RELEASE, 1100, 100, 100);
+  CHECK_EQ(feed(TOUCH_PRESS, 1100 + GESTURE_DOUBLE_TAP_MS, 105, 105), NONE);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1500, 105, 105), GESTURE_DOUBLE_TAP);
+  CHECK_EQ(gesture.x, 105);
+  CHECK_EQ(due(), NONE);
+  CHECK_EQ(poll(5000), NONE);
+
+  // A second tap too late reports the first on its press and waits itself.
+  start();
+  feed(TOUCH_PRESS, 1000, 100, 100);
+  feed(TOUCH_RELEASE, 1100, 100, 100);
+  CHECK_EQ(feed(TOUCH_PRESS, 1100 + GESTURE_DOUBLE_TAP_MS + 1, 100, 100),
+    GESTURE_TAP);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1500, 100, 100), NONE);
+  CHECK_EQ(poll(1500 + GESTURE_DOUBLE_TAP_MS + 1), GESTURE_TAP);
+
+  // A second tap somewhere else reports the first on its release.
+  start();
+  feed(TOUCH_PRESS, 1000, 100, 100);
+  feed(TOUCH_RELEASE, 1100, 100, 100);
+  feed(TOUCH_PRESS, 1200, 200, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1300, 200, 100), GESTURE_TAP);
+  CHECK_EQ(gesture.x, 100);
+  CHECK_EQ(poll(1300 + GESTURE_DOUBLE_TAP_MS + 1), GESTURE_TAP);
+  CHECK_EQ(gesture.x, 200);
+}
+
+static void test_long_press(void)
+{
+  // Reported by poll() while still touched, and the release ignored.
+  start();
+  feed(TOUCH_PRESS, 1000, 100, 100);
+  CHECK_EQ(poll(1000 + GESTURE_LONG_PRESS_MS - 1), NONE);
+  feed(TOUCH_MOVE, 1500, 100 + GESTURE_SLOP_PX, 100);
+  CHECK_EQ(poll(1000 + GESTURE_LONG_PRESS_MS), GESTURE_LONG_PRESS);
+  CHECK_EQ(gesture.x, 100);
+  CHECK_EQ(due(), NONE);
+  CHECK_EQ(poll(3000), NONE);
+  CHECK_EQ(feed(TOUCH_RELEASE, 3000, 100, 100), NONE);
+  CHECK_EQ(due(), NONE);
+
+  // Or on the release, if poll() wasn't called in time.
+  start();
+  feed(TOUCH_PRESS, 1000, 100, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1000 + GESTURE_LONG_PRESS_MS, 100, 100),
+    GESTURE_LONG_PRESS);
+  CHECK_EQ(due(), NONE);
+
+  // Not once it has moved.
+  start();
+  feed(TOUCH_PRESS, 1000, 100, 100);
+  feed(TOUCH_MOVE, 1100, 100, 100 + GESTURE_SLOP_PX + 1);
+  CHECK_EQ(due(), NONE);
+  CHECK_EQ(poll(3000), NONE);
+  CHECK_EQ(feed(TOUCH_RELEASE, 3000, 100, 100), NONE);
+}
+
+static void test_swipes(void)
+{
+  // Left and right, reported on the release where the touch started.
+  start();
+  feed(TOUCH_PRESS, 1000, 200, 100);
+  feed(TOUCH_MOVE, 1100, 170, 102);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1200, 200 - GESTURE_SWIPE_PX, 110),
+    GESTURE_SWIPE_LEFT);
+  CHECK_EQ(gesture.x, 200);
+  CHECK_EQ(gesture.y, 100);
+  CHECK_EQ(due(), NONE);
+
+  feed(TOUCH_PRESS, 2000, 100, 100);
+  feed(TOUCH_MOVE, 2100, 150, 98);
+  CHECK_EQ(feed(TOUCH_RELEASE, 2000 + GESTURE_SWIPE_MS, 190, 90),
+    GESTURE_SWIPE_RIGHT);
+  CHECK_EQ(gesture.x, 100);
+
+  // Too short, too slow or too steep.
+  feed(TOUCH_PRESS, 3000, 100, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, 3100, 100 + GESTURE_SWIPE_PX - 1, 100), NONE);
+  feed(TOUCH_PRESS, 4000, 100, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, 4000 + GESTURE_SWIPE_MS + 1, 200, 100), NONE);
+  feed(TOUCH_PRESS, 5000, 100, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, 5100, 200, 150), NONE);
+  CHECK_EQ(due(), NONE);
+}
+
+// A tap still waiting for a double tap is reported ahead of whatever comes
+// next, rather than lost.
+static void test_tap_then(void)
+{
+  // A swipe, kept for the next poll().
+  start();
+  feed(TOUCH_PRESS, 1000, 50, 60);
+  feed(TOUCH_RELEASE, 1100, 50, 60);
+  feed(TOUCH_PRESS, 1200, 100, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1400, 200, 100), GESTURE_TAP);
+  CHECK_EQ(gesture.x, 50);
+  CHECK_EQ(gesture.y, 60);
+  CHECK_EQ(due(), 1400);
+  CHECK_EQ(poll(1400), GESTURE_SWIPE_RIGHT);
+  CHECK_EQ(gesture.x, 100);
+  CHECK_EQ(due(), NONE);
+  CHECK_EQ(poll(5000), NONE);
+
+  // Or for the next press, if poll() wasn't called.
+  start();
+  feed(TOUCH_PRESS, 1000, 150, 60);
+  feed(TOUCH_RELEASE, 1100, 150, 60);
+  feed(TOUCH_PRESS, 1200, 200, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1400, 100, 100), GESTURE_TAP);
+  CHECK_EQ(feed(TOUCH_PRESS, 2000, 10, 10), GESTURE_SWIPE_LEFT);
+  CHECK_EQ(gesture.x, 200);
+  CHECK_EQ(feed(TOUCH_RELEASE, 2100, 10, 10), NONE);
+  CHECK_EQ(poll(2100 + GESTURE_DOUBLE_TAP_MS + 1), GESTURE_TAP);
+  CHECK_EQ(gesture.x, 10);
+
+  // A long press seen by poll(), the tap first.
+  start();
+  feed(TOUCH_PRESS, 1000, 50, 60);
+  feed(TOUCH_RELEASE, 1100, 50, 60);
+  feed(TOUCH_PRESS, 1200, 50, 60);
+  CHECK_EQ(poll(1200 + GESTURE_LONG_PRESS_MS), GESTURE_TAP);
+  CHECK_EQ(poll(1200 + GESTURE_LONG_PRESS_MS), GESTURE_LONG_PRESS);
+  CHECK_EQ(feed(TOUCH_RELEASE, 3000, 50, 60), NONE);
+  CHECK_EQ(due(), NONE);
+
+  // A long press seen on the release.
+  start();
+  feed(TOUCH_PRESS, 1000, 50, 60);
+  feed(TOUCH_RELEASE, 1100, 50, 60);
+  feed(TOUCH_PRESS, 1200, 50, 60);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1200 + GESTURE_LONG_PRESS_MS, 50, 60),
+    GESTURE_TAP);
+  CHECK_EQ(poll(1200 + GESTURE_LONG_PRESS_MS), GESTURE_LONG_PRESS);
+
+  // A touch that moved, or was too long for a tap, reports just the tap.
+  start();
+  feed(TOUCH_PRESS, 1000, 50, 60);
+  feed(TOUCH_RELEASE, 1100, 50, 60);
+  feed(TOUCH_PRESS, 1200, 50, 60);
+  feed(TOUCH_MOVE, 1300, 50, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, 1400, 50, 100), GESTURE_TAP);
+  CHECK_EQ(due(), NONE);
+  feed(TOUCH_PRESS, 2000, 50, 60);
+  feed(TOUCH_RELEASE, 2100, 50, 60);
+  feed(TOUCH_PRESS, 2200, 50, 60);
+  CHECK_EQ(feed(TOUCH_RELEASE, 2200 + GESTURE_TAP_MS + 1, 50, 60),
+    GESTURE_TAP);
+  CHECK_EQ(due(), NONE);
+}
+
+// millis() wraps every 49.7 days, part way through a gesture.
+static void test_wrap(void)
+{
+  const uint32_t before = 0xFFFFFF00UL;
+
+  start();
+  feed(TOUCH_PRESS, before, 100, 100);
+  CHECK_EQ(due(), (long)(uint32_t)(before + GESTURE_LONG_PRESS_MS));
+  CHECK_EQ(poll(0xFFFFFFFFUL), NONE);
+  CHECK_EQ(poll(before + GESTURE_LONG_PRESS_MS - 1), NONE);
+  CHECK_EQ(poll(before + GESTURE_LONG_PRESS_MS), GESTURE_LONG_PRESS);
+  feed(TOUCH_RELEASE, before + 2000, 100, 100);
+
+  start();
+  feed(TOUCH_PRESS, before + 100, 100, 100);
+  feed(TOUCH_RELEASE, before + 200, 100, 100);
+  CHECK_EQ(poll(0xFFFFFFFFUL), NONE);
+  CHECK_EQ(poll(before + 200 + GESTURE_DOUBLE_TAP_MS), NONE);
+  CHECK_EQ(poll(before + 200 + GESTURE_DOUBLE_TAP_MS + 1), GESTURE_TAP);
+
+  // Double tap and swipe timings over the wrap.
+  start();
+  feed(TOUCH_PRESS, before + 100, 100, 100);
+  feed(TOUCH_RELEASE, before + 200, 100, 100);
+  feed(TOUCH_PRESS, before + 400, 100, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, before + 500, 100, 100), GESTURE_DOUBLE_TAP);
+  feed(TOUCH_PRESS, before + 600, 100, 100);
+  CHECK_EQ(feed(TOUCH_RELEASE, before + 600 + GESTURE_SWIPE_MS, 200, 100),
+    GESTURE_SWIPE_RIGHT);
+}
+
+int main(void)
+{
+  test_tap();
+  test_double_tap();
+  test_long_press();
+  test_swipes();
+  test_tap_then();
+  test_wrap();
+
+  printf("test_gesture: %d checks, %d failed\n", checks, failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,683 @@
+// Tests of the DS3231 driver against the emulated DS3231.
+//
+// The driver keeps its state in statics, so the tests run in order on one
+// emulated chip and each one starts from where the last left it.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "DS3231_Emulator.h"
+#include "../DS3231_RTC.h"
+
+static DS3231Emulator rtc;
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+#define CHECK_EQ(a, b) check_eq((long)(a), (long)(b), #a, #b, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+  checks++;
+  if (!ok)
+  {
+    failures++;
+    printf("test_rtc.cpp:%d: CHECK(%s) failed\n", line, what);
+  }
+}
+
+static void check_eq(long a, long b, const char *what_a, const char *what_b,
+  int line)
+{
+  checks++;
+  if (a != b)
+  {
+    failures++;
+    printf("test_rtc.cpp:%d: %s == %s failed, %ld != %ld\n",
+      line, what_a, what_b, a, b);
+  }
+}
+
+// The bus traffic since the last call.
+static I2C_BUS_STATS_T bus(void)
+{
+  I2C_BUS_STATS_T stats;
+
+  Wire.getStats(&stats, true);
+  return stats;
+}
+
+static TM_T make_tm(uint8_t century, uint8_t year, uint8_t mon, uint8_t mday,
+  uint8_t wday, uint8_t hour, uint8_t min, uint8_t sec)
+{
+  TM_T tm;
+
+  tm.tm_sec = sec;
+  tm.tm_min = min;
+  tm.tm_hour = hour;
+  tm.tm_wday = wday;
+  tm.tm_mday = mday;
+  tm.tm_mon = mon;
+  tm.tm_year = year;
+  tm.tm_century = century;
+  return tm;
+}
+
+static void check_tm(const TM_T &tm, const TM_T &expected, int line)
+{
+  check(memcmp(&tm, &expected, sizeof(tm)) == 0, "date and time", line);
+  if (memcmp(&tm, &expected, sizeof(tm)))
+  {
+    printf("  got %d%02d-%02d-%02d (%d) %02d:%02d:%02d\n",
+      20 + tm.tm_century, tm.tm_year, tm.tm_mon, tm.tm_mday, tm.tm_wday,
+      tm.tm_hour, tm.tm_min, tm.tm_sec);
+  }
+}
+
+// Reads the time from the RTC, not the shadow.
+static TM_T read_time(void)
+{
+  TM_T tm;
+
+  rtc_refresh();
+  get_date_time(&tm);
+  return tm;
+}
+
+// A conversion started straight after power on returns the power on
+// temperature rather than the empty cache.
+static void test_first_temp(void)
+{
+  TEMP_T temp;
+
+  CHECK_EQ(rtc_convert_temp(), 1);
+  get_temp(&temp);
+  CHECK_EQ(temp.temp_degrees, 25);
+  CHECK_EQ(temp.temp_quarters, 0);
+  delay(DS3231_CONV_MS);
+  get_temp(&temp);
+  bus();
+}
+
+static void test_codec(void)
+{
+  uint8_t regs[7];
+  TM_T tm, expected;
+
+  // Every value of every field, with the others at their largest.
+  for (int val=0; val < 100; val++)
+  {
+    for (int field=0; field < 7; field++)
+    {
+      static const uint8_t LAST[7] = { 59, 59, 23, 7, 31, 12, 99 };
+      uint8_t *fields = (uint8_t *)&expected;
+
+      if (val > LAST[field])
+        continue;
+      expected = make_tm(val & 1, 99, 12, 31, 7, 23, 59, 59);
+      fields[field] = val;
+      rtc_encode_date_time(&expected, regs);
+      for (int idx=0; idx < 7; idx++)
+      {
+        CHECK_EQ(regs[idx] & ((idx == 5) ? 0x7F : 0xFF),
+          ((fields[idx] / 10) << 4) | (fields[idx] % 10));
+      }
+      CHECK_EQ(regs[5] >> 7, val & 1);
+
+      rtc_decode_date_time(regs, &tm);
+      check_tm(tm, expected, __LINE__);
+    }
+  }
+
+  // Bits that aren't part of the value are masked out, the Century isn't.
+  regs[0] = 0x80 | 0x59;
+  regs[1] = 0x80 | 0x59;
+  regs[2] = 0xC0 | 0x23;
+  regs[3] = 0xF8 | 0x07;
+  regs[4] = 0xC0 | 0x31;
+  regs[5] = 0xE0 | 0x12;
+  regs[6] = 0x99;
+  rtc_decode_date_time(regs, &tm);
+  check_tm(tm, make_tm(1, 99, 12, 31, 7, 23, 59, 59), __LINE__);
+}
+
+static void test_date_time(void)
+{
+  TM_T tm;
+
+  tm = make_tm(0, 24, 2, 28, 3, 23, 59, 59);
+  set_date_time(&tm);
+  CHECK_EQ(rtc.reg(0x00), 0x59);
+  CHECK_EQ(rtc.reg(0x02), 0x23);
+  CHECK_EQ(rtc.reg(0x05), 0x02);
+  CHECK_EQ(rtc.reg(0x06), 0x24);
+  check_tm(read_time(), tm, __LINE__);
+
+  // Leap year.
+  delay(1000);
+  check_tm(read_time(), make_tm(0, 24, 2, 29, 4, 0, 0, 0), __LINE__);
+
+  tm = make_tm(0, 23, 2, 28, 2, 23, 59, 59);
+  set_date_time(&tm);
+  delay(1000);
+  check_tm(read_time(), make_tm(0, 23, 3, 1, 3, 0, 0, 0), __LINE__);
+
+  tm = make_tm(0, 24, 4, 30, 2, 23, 59, 59);
+  set_date_time(&tm);
+  delay(1000);
+  check_tm(read_time(), make_tm(0, 24, 5, 1, 3, 0, 0, 0), __LINE__);
+
+  // Century.
+  tm = make_tm(0, 99, 12, 31, 4, 23, 59, 59);
+  set_date_time(&tm);
+  delay(1000);
+  check_tm(read_time(), make_tm(1, 0, 1, 1, 5, 0, 0, 0), __LINE__);
+  CHECK_EQ(rtc.reg(0x05), 0x81);
+
+  // Writing the seconds restarts the countdown, so setting the time just
+  // before a second would have ended doesn't count on straight away.
+  tm = make_tm(0, 24, 6, 15, 6, 12, 0, 0);
+  delay(900);
+  set_date_time(&tm);
+  delay(990);
+  check_tm(read_time(), tm, __LINE__);
+  delay(10);
+  CHECK_EQ(rtc.reg(0x00), 0x01);
+
+  // A day of seconds.
+  tm = make_tm(0, 24, 6, 15, 6, 12, 0, 0);
+  set_date_time(&tm);
+  delay(86400UL * 1000);
+  check_tm(read_time(), make_tm(0, 24, 6, 16, 7, 12, 0, 0), __LINE__);
+
+  // 12 hour mode, which only the emulator uses.
+  rtc.setReg(0x02, 0x40 | 0x20 | 0x11);     // 11 PM.
+  rtc.setReg(0x01, 0x59);
+  rtc.setReg(0x00, 0x59);
+  delay(1000);
+  CHECK_EQ(rtc.reg(0x02), 0x40 | 0x12);     // 12 AM.
+  CHECK_EQ(rtc.reg(0x04), 0x17);
+  rtc.setReg(0x02, 0x40 | 0x12);
+  rtc.setReg(0x01, 0x59);
+  rtc.setReg(0x00, 0x59);
+  delay(1000);
+  CHECK_EQ(rtc.reg(0x02), 0x40 | 0x01);     // 1 AM.
+  bus();
+}
+
+static void test_shadow(void)
+{
+  I2C_BUS_STATS_T stats;
+  TM_T tm;
+  ALARM_T alarm;
+  uint8_t enabled, triggered;
+
+  rtc_refresh();
+  stats = bus();
+  CHECK_EQ(stats.transactions, 2);
+  CHECK_EQ(stats.bytes, 2 + 1 + RTC_SHADOW_SIZE);
+
+  get_date_time(&tm);
+  get_alarm_time(ALARM1, &alarm);
+  get_alarm_time(ALARM2, &alarm);
+  get_alarm_status(&enabled, &triggered);
+  CHECK_EQ(bus().transactions, 0);
+
+  delay(RTC_SHADOW_TTL_MS - 1);
+  get_date_time(&tm);
+  CHECK_EQ(bus().transactions, 0);
+  delay(1);
+  get_date_time(&tm);
+  CHECK_EQ(bus().transactions, 2);
+}
+
+static void test_alarm_times(void)
+{
+  static const uint8_t MODES[] = {
+    ALARM_MATCH_NONE, ALARM_MATCH_SECONDS, ALARM_MATCH_MINUTES,
+    ALARM_MATCH_HOURS, ALARM_MATCH_DATE, ALARM_MATCH_DAY
+  };
+  I2C_BUS_STATS_T stats;
+  ALARM_T alarm, got;
+
+  for (uint8_t id=ALARM1; id <= ALARM2; id++)
+  {
+    for (uint8_t idx=0; idx < sizeof(MODES); idx++)
+    {
+      alarm.tm_sec = (id == ALARM1) ? 45 : 0;
+      alarm.tm_min = 30;
+      alarm.tm_hour = 21;
+      alarm.tm_day = (MODES[idx] == ALARM_MATCH_DAY) ? 6 : 28;
+      alarm.mode = MODES[idx];
+      bus();
+      CHECK_EQ(set_alarm_time(id, &alarm), 1);
+      stats = bus();
+      CHECK_EQ(stats.transactions, 1);
+      CHECK_EQ(stats.bytes, (id == ALARM1) ? 6 : 5);
+
+      // Alarm 2 has no A2M1, matching seconds is the same as no match.
+      if (id == ALARM2 && alarm.mode == ALARM_MATCH_SECONDS)
+        alarm.mode = ALARM_MATCH_NONE;
+
+      // From the shadow and from the RTC.
+      CHECK_EQ(get_alarm_time(id, &got), 1);
+      CHECK(memcmp(&got, &alarm, sizeof(got)) == 0);
+      rtc_refresh();
+      CHECK_EQ(get_alarm_time(id, &got), 1);
+      CHECK(memcmp(&got, &alarm, sizeof(got)) == 0);
+    }
+  }
+
+  // Raw registers, Alarm 1 daily at 21:30:45 and Alarm 2 on day 6.
+  alarm.tm_sec = 45;
+  alarm.tm_day = 28;
+  alarm.mode = ALARM_MATCH_HOURS;
+  set_alarm_time(ALARM1, &alarm);
+  CHECK_EQ(rtc.reg(0x07), 0x45);
+  CHECK_EQ(rtc.reg(0x08), 0x30);
+  CHECK_EQ(rtc.reg(0x09), 0x21);
+  CHECK_EQ(rtc.reg(0x0A), 0x80 | 0x28);
+  alarm.tm_day = 6;
+  alarm.mode = ALARM_MATCH_DAY;
+  set_alarm_time(ALARM2, &alarm);
+  CHECK_EQ(rtc.reg(0x0B), 0x30);
+  CHECK_EQ(rtc.reg(0x0C), 0x21);
+  CHECK_EQ(rtc.reg(0x0D), 0x40 | 0x06);
+
+  // Not valid, nothing is written.
+  bus();
+  CHECK_EQ(set_alarm_time(3, &alarm), 0);
+  alarm.mode = 0x05;
+  CHECK_EQ(set_alarm_time(ALARM1, &alarm), 0);
+  CHECK_EQ(get_alarm_time(0, &got), 0);
+  CHECK_EQ(bus().transactions, 0);
+}
+
+// Sets the time, an alarm and enables it, then checks it goes off after
+// 'seconds' and not before.
+static void check_alarm(uint8_t id, const ALARM_T &alarm, const TM_T &start,
+  unsigned long seconds)
+{
+  TM_T tm = start;
+  uint8_t enabled, triggered;
+
+  set_alarm(ALARM1, false);
+  set_alarm(ALARM2, false);
+  set_alarm_time(id, &alarm);
+  set_date_time(&tm);
+  set_alarm(id, true);
+
+  // The transfers take a few ms of the first second.
+  delay(seconds * 1000 - 10);
+  rtc_refresh();
+  get_alarm_status(&enabled, &triggered);
+  CHECK_EQ(enabled, id);
+  CHECK_EQ(triggered & id, 0);
+  CHECK(rtc.intSqw());
+
+  delay(10);
+  rtc_refresh();
+  get_alarm_status(&enabled, &triggered);
+  CHECK_EQ(triggered & id, id);
+  CHECK(!rtc.intSqw());
+}
+
+static void test_alarms(void)
+{
+  ALARM_T alarm;
+  uint8_t enabled, triggered;
+
+  alarm.tm_sec = 15;
+  alarm.tm_min = 30;
+  alarm.tm_hour = 7;
+  alarm.tm_day = 3;
+
+  alarm.mode = ALARM_MATCH_NONE;
+  check_alarm(ALARM1, alarm, make_tm(0, 24, 6, 15, 6, 7, 0, 0), 1);
+  alarm.mode = ALARM_MATCH_SECONDS;
+  check_alarm(ALARM1, alarm, make_tm(0, 24, 6, 15, 6, 7, 0, 0), 15);
+  alarm.mode = ALARM_MATCH_MINUTES;
+  check_alarm(ALARM1, alarm, make_tm(0, 24, 6, 15, 6, 7, 0, 0), 30 * 60 + 15);
+  alarm.mode = ALARM_MATCH_HOURS;
+  check_alarm(ALARM1, alarm, make_tm(0, 24, 6, 15, 6, 7, 30, 10), 5);
+  alarm.mode = ALARM_MATCH_DATE;
+  check_alarm(ALARM1, alarm, make_tm(0, 24, 7, 2, 2, 7, 30, 14), 86401);
+  alarm.mode = ALARM_MATCH_DAY;
+  check_alarm(ALARM1, alarm, make_tm(0, 24, 7, 1, 2, 7, 30, 14), 86401);
+
+  alarm.tm_sec = 0;
+  alarm.mode = ALARM_MATCH_NONE;
+  check_alarm(ALARM2, alarm, make_tm(0, 24, 6, 15, 6, 7, 0, 50), 10);
+  alarm.mode = ALARM_MATCH_MINUTES;
+  check_alarm(ALARM2, alarm, make_tm(0, 24, 6, 15, 6, 7, 29, 58), 2);
+  alarm.mode = ALARM_MATCH_HOURS;
+  check_alarm(ALARM2, alarm, make_tm(0, 24, 6, 15, 6, 6, 30, 0), 3600);
+  alarm.mode = ALARM_MATCH_DAY;
+  check_alarm(ALARM2, alarm, make_tm(0, 24, 7, 1, 2, 7, 29, 59), 86401);
+
+  // Enabling clears a flag that is already set, and doesn't start a
+  // temperature conversion. A disabled alarm's flag is still set when it
+  // matches, but doesn't drive the pin.
+  set_alarm(ALARM2, false);
+  rtc.setReg(0x0F, rtc.reg(0x0F) | ALARM1);
+  set_alarm(ALARM1, true);
+  CHECK_EQ(rtc.reg(0x0F) & ALARM1, 0);
+  CHECK_EQ(rtc.reg(0x0E) & 0x20, 0);
+  CHECK(rtc.intSqw());
+
+  // Disabling leaves the flag.
+  rtc.setReg(0x0F, rtc.reg(0x0F) | ALARM1);
+  set_alarm(ALARM1, false);
+  CHECK_EQ(rtc.reg(0x0F) & ALARM1, ALARM1);
+  CHECK(rtc.intSqw());
+  rtc_refresh();
+  get_alarm_status(&enabled, &triggered);
+  CHECK_EQ(enabled, 0);
+  CHECK_EQ(triggered & ALARM1, ALARM1);
+
+  CHECK_EQ(clear_alarm(ALARM_MASK), 1);
+  CHECK_EQ(rtc.reg(0x0F) & ALARM_MASK, 0);
+  CHECK_EQ(clear_alarm(0), 0);
+  bus();
+}
+
+static void test_temp(void)
+{
+  TEMP_T temp;
+
+  // The next automatic conversion is cached for the period.
+  rtc.setAmbient(30 * 4 + 3);
+  delay(RTC_TEMP_PERIOD_MS + DS3231_CONV_MS);
+  bus();
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 2);
+  CHECK_EQ(temp.temp_degrees, 30);
+  CHECK_EQ(temp.temp_half, 5);
+  CHECK_EQ(temp.temp_quarters, 3);
+
+  delay(RTC_TEMP_PERIOD_MS - 1);
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 0);
+
+  // A forced conversion, the last result until it completes.
+  rtc.setAmbient(22 * 4 + 2);
+  CHECK_EQ(rtc_convert_temp(), 1);
+  CHECK_EQ(rtc.reg(0x0F) & 0x04, 0x04);
+  CHECK_EQ(rtc_convert_temp(), 0);
+  bus();
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 2);
+  CHECK_EQ(temp.temp_degrees, 30);
+
+  delay(DS3231_CONV_MS);
+  CHECK_EQ(rtc.reg(0x0E) & 0x20, 0);
+  get_temp(&temp);
+  CHECK_EQ(temp.temp_degrees, 22);
+  CHECK_EQ(temp.temp_half, 5);
+  CHECK_EQ(temp.temp_quarters, 2);
+  bus();
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 0);
+
+  // An automatic conversion seen in progress is read until it completes,
+  // then cached for the period from then.
+  delay(RTC_TEMP_PERIOD_MS);
+  rtc.setAmbient(18 * 4 + 1);
+  while (!(rtc.reg(0x0F) & 0x04))
+  {
+    delay(10);
+  }
+  bus();
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 2);
+  CHECK_EQ(temp.temp_degrees, 22);
+  delay(DS3231_CONV_MS / 2);
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 2);
+  CHECK_EQ(temp.temp_degrees, 22);
+  delay(DS3231_CONV_MS / 2);
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 2);
+  CHECK_EQ(temp.temp_degrees, 18);
+  CHECK_EQ(temp.temp_quarters, 1);
+
+  // The next one is read on the first call after it completes.
+  rtc.setAmbient(19 * 4);
+  delay(RTC_TEMP_PERIOD_MS - 100);
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 0);
+  delay(100);
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 2);
+  CHECK_EQ(temp.temp_degrees, 19);
+
+  // Read late, the one after that is still read once it completes rather
+  // than a period after the read.
+  rtc.setAmbient(20 * 4);
+  delay(RTC_TEMP_PERIOD_MS + 500);
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 2);
+  rtc.setAmbient(21 * 4);
+  delay(RTC_TEMP_PERIOD_MS - 600);
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 0);
+  CHECK_EQ(temp.temp_degrees, 20);
+  delay(200);
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 2);
+  CHECK_EQ(temp.temp_degrees, 21);
+
+  // A forced conversion doesn't move it off the cycle.
+  CHECK_EQ(rtc_convert_temp(), 1);
+  delay(DS3231_CONV_MS);
+  get_temp(&temp);
+  CHECK_EQ(temp.temp_degrees, 21);
+  bus();
+  rtc.setAmbient(23 * 4);
+  delay(RTC_TEMP_PERIOD_MS - DS3231_CONV_MS - 200);
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 0);
+  delay(200);
+  get_temp(&temp);
+  CHECK_EQ(bus().transactions, 2);
+  CHECK_EQ(temp.temp_degrees, 23);
+}
+
+static void test_square_wave(void)
+{
+  TM_T tm = make_tm(0, 24, 6, 15, 6, 12, 0, 0);
+
+  clear_alarm(ALARM_MASK);
+  CHECK_EQ(set_square_wave(true), 1);
+  CHECK_EQ(rtc.reg(0x0E) & 0x3C, 0);
+  set_date_time(&tm);
+  delay(250);
+  CHECK(!rtc.intSqw());
+  delay(500);
+  CHECK(rtc.intSqw());
+  delay(500);
+  CHECK(!rtc.intSqw());
+  CHECK_EQ(rtc.reg(0x00), 0x01);
+
+  CHECK_EQ(set_square_wave(false), 1);
+  CHECK_EQ(rtc.reg(0x0E) & 0x3C, 0x04);
+  CHECK(rtc.intSqw());
+  bus();
+}
+
+static uint8_t done_ops[8];
+static uint8_t done_count;
+
+static void op_done(const RTC_OP_T *op, int result)
+{
+  CHECK_EQ(result, 1);
+  if (done_count < sizeof(done_ops))
+    done_ops[done_count++] = op->op;
+
+  // The queue has room for another from the callback.
+  if (done_count == 1)
+  {
+    RTC_OP_T refresh;
+
+    refresh.op = RTC_OP_REFRESH;
+    CHECK_EQ(rtc_submit(&refresh, op_done), 1);
+  }
+}
+
+static void test_queue(void)
+{
+  RTC_OP_T op;
+  int steps = 0;
+  TM_T tm;
+
+  done_count = 0;
+  op.op = RTC_OP_SET_DATE_TIME;
+  op.date_time = make_tm(0, 25, 1, 1, 3, 8, 0, 0);
+  CHECK_EQ(rtc_submit(&op, op_done), 1);
+  op.op = RTC_OP_SET_ALARM_TIME;
+  op.alarm_id = ALARM2;
+  op.alarm_time.tm_min = 5;
+  op.alarm_time.tm_hour = 8;
+  op.alarm_time.tm_day = 1;
+  op.alarm_time.mode = ALARM_MATCH_MINUTES;
+  CHECK_EQ(rtc_submit(&op, op_done), 1);
+  op.op = RTC_OP_SET_ALARM;
+  op.enable = true;
+  CHECK_EQ(rtc_submit(&op, op_done), 1);
+  op.op = RTC_OP_SQUARE_WAVE;
+  op.enable = true;
+  CHECK_EQ(rtc_submit(&op, NULL), 1);
+
+  op.op = RTC_OP_CLEAR_ALARM;
+  op.alarm_id = ALARM1;
+  CHECK_EQ(rtc_submit(&op, NULL), 0);       // Full.
+  op.op = RTC_OP_SQUARE_WAVE + 1;
+  CHECK_EQ(rtc_submit(&op, NULL), 0);       // Not an operation.
+
+  // At most one register access, a write or a register read, per call.
+  bus();
+  while (rtc_service())
+  {
+    I2C_BUS_STATS_T stats = bus();
+
+    CHECK(stats.transactions == 1 || stats.transactions == 2);
+    steps++;
+  }
+  CHECK(bus().transactions <= 2);
+  steps++;
+
+  // Date/time 1, alarm time 1, set alarm 4, square wave 2 and refresh 1.
+  CHECK_EQ(steps, 9);
+  CHECK_EQ(done_count, 4);
+  CHECK_EQ(done_ops[0], RTC_OP_SET_DATE_TIME);
+  CHECK_EQ(done_ops[1], RTC_OP_SET_ALARM_TIME);
+  CHECK_EQ(done_ops[2], RTC_OP_SET_ALARM);
+  CHECK_EQ(done_ops[3], RTC_OP_REFRESH);
+
+  check_tm(*get_date_time(&tm), make_tm(0, 25, 1, 1, 3, 8, 0, 0), __LINE__);
+  CHECK_EQ(rtc.reg(0x0C), 0x80 | 0x08);
+  CHECK_EQ(rtc.reg(0x0E) & 0x07, ALARM2);
+  CHECK_EQ(rtc.reg(0x0E) & 0x3C, 0x00);
+  CHECK(!rtc_service());
+  CHECK_EQ(bus().transactions, 0);
+
+  set_square_wave(false);
+  set_alarm(ALARM2, false);
+  bus();
+}
+
+// Each API's bus traffic, and that the driver counts what the bus carries.
+static void test_bus_costs(void)
+{
+  static const struct {
+    const char *name;
+    uint8_t transactions;
+    uint8_t bytes;
+  } COSTS[] = {
+    { "rtc_refresh",        2, 20 },
+    { "set_date_time",      1,  9 },
+    { "set_alarm_time",     1,  6 },
+    { "set_alarm on",       6, 14 },
+    { "set_alarm off",      3,  7 },
+    { "clear_alarm",        3,  7 },
+    { "set_square_wave",    3,  7 },
+    { "rtc_convert_temp",   5, 11 },
+    { "get_temp",           2,  8 },
+  };
+  RTC_BUS_STATS_T driver;
+  I2C_BUS_STATS_T stats;
+  TM_T tm = make_tm(0, 24, 6, 15, 6, 12, 0, 0);
+  ALARM_T alarm = { 0, 12, 0, 1, ALARM_MATCH_HOURS };
+  TEMP_T temp;
+  uint64_t busy_ns = 0;
+  unsigned long start = micros();
+
+  rtc_get_bus_stats(&driver, true);
+  bus();
+  for (uint8_t idx=0; idx < sizeof(COSTS) / sizeof(COSTS[0]); idx++)
+  {
+    switch (idx)
+    {
+      case 0:   rtc_refresh();                      break;
+      case 1:   set_date_time(&tm);                 break;
+      case 2:   set_alarm_time(ALARM1, &alarm);     break;
+      case 3:   set_alarm(ALARM1, true);            break;
+      case 4:   set_alarm(ALARM1, false);           break;
+      case 5:   clear_alarm(ALARM1);                break;
+      case 6:   set_square_wave(false);             break;
+      case 7:   rtc_convert_temp();                 break;
+      case 8:   get_temp(&temp);                    break;
+    }
+    stats = bus();
+    busy_ns += stats.busy_ns;
+    if (stats.transactions != COSTS[idx].transactions ||
+      stats.bytes != COSTS[idx].bytes)
+    {
+      printf("  %s: %u transactions, %u bytes\n", COSTS[idx].name,
+        stats.transactions, stats.bytes);
+    }
+    CHECK_EQ(stats.transactions, COSTS[idx].transactions);
+    CHECK_EQ(stats.bytes, COSTS[idx].bytes);
+    CHECK_EQ(stats.busy_ns,
+      TwoWire::busTimeNs(stats.transactions, stats.bytes, I2C_STANDARD_HZ));
+  }
+
+  // The only time that passed was the bus being busy.
+  CHECK_EQ(micros() - start, busy_ns / 1000);
+
+  rtc_get_bus_stats(&driver, true);
+  CHECK_EQ(driver.transactions, 26);
+  CHECK_EQ(driver.bytes, 89);
+  CHECK_EQ(rtc_bus_time_us(&driver, I2C_STANDARD_HZ),
+    TwoWire::busTimeNs(26, 89, I2C_STANDARD_HZ) / 1000);
+  CHECK_EQ(rtc_bus_time_us(&driver, I2C_FAST_HZ),
+    TwoWire::busTimeNs(26, 89, I2C_FAST_HZ) / 1000);
+  CHECK_EQ(rtc_bus_time_us(&driver, I2C_STANDARD_HZ), 8530);
+  CHECK_EQ(rtc_bus_time_us(&driver, I2C_FAST_HZ), 2132);
+
+  // The shadow's savings.
+  get_date_time(&tm);
+  rtc_get_bus_stats(&driver, true);
+  CHECK_EQ(driver.transactions, 0);
+  CHECK_EQ(driver.saved_transactions, 2);
+  CHECK_EQ(driver.saved_bytes, 10);
+}
+
+int main(void)
+{
+  Wire.begin();
+  Wire.attach(DS3231_ADDRESS, &rtc);
+
+  test_first_temp();
+  test_codec();
+  test_date_time();
+  test_shadow();
+  test_alarm_times();
+  test_alarms();
+  test_temp();
+  test_square_wave();
+  test_queue();
+  test_bus_costs();
+
+  printf("test_rtc: %d checks, %d failed\n", checks, failures);
+  return failures ? 1 : 0;
+}
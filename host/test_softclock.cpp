@@ -0,0 +1,258 @@
+// Tests of the software clock against the emulated DS3231.
+//
+// The clock is the sketch's softclock instance, so the tests run in order
+// and each one starts from where the last left it.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "DS3231_Emulator.h"
+#include "../DS3231_RTC.h"
+#include "../SoftClock.h"
+
+static DS3231Emulator rtc;
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+#define CHECK_EQ(a, b) check_eq((long)(a), (long)(b), #a, #b, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+  checks++;
+  if (!ok)
+  {
+    failures++;
+    printf("test_softclock.cpp:%d: CHECK(%s) failed\n", line, what);
+  }
+}
+
+static void check_eq(long a, long b, const char *what_a, const char *what_b,
+  int line)
+{
+  checks++;
+  if (a != b)
+  {
+    failures++;
+    printf("test_softclock.cpp:%d: %s == %s failed, %ld != %ld\n",
+      line, what_a, what_b, a, b);
+  }
+}
+
+static TM_T make_tm(uint8_t century, uint8_t year, uint8_t mon, uint8_t mday,
+  uint8_t wday, uint8_t hour, uint8_t min, uint8_t sec)
+{
+  TM_T tm;
+
+  tm.tm_sec = sec;
+  tm.tm_min = min;
+  tm.tm_hour = hour;
+  tm.tm_wday = wday;
+  tm.tm_mday = mday;
+  tm.tm_mon = mon;
+  tm.tm_year = year;
+  tm.tm_century = century;
+  return tm;
+}
+
+static void check_tm(const TM_T &tm, const TM_T &expected, int line)
+{
+  check(memcmp(&tm, &expected, sizeof(tm)) == 0, "date and time", line);
+  if (memcmp(&tm, &expected, sizeof(tm)))
+  {
+    printf("  got %d%02d-%02d-%02d (%d) %02d:%02d:%02d\n",
+      20 + tm.tm_century, tm.tm_year, tm.tm_mon, tm.tm_mday, tm.tm_wday,
+      tm.tm_hour, tm.tm_min, tm.tm_sec);
+    printf("  expected %d%02d-%02d-%02d (%d) %02d:%02d:%02d\n",
+      20 + expected.tm_century, expected.tm_year, expected.tm_mon,
+      expected.tm_mday, expected.tm_wday, expected.tm_hour, expected.tm_min,
+      expected.tm_sec);
+  }
+}
+
+// Reads the time from the RTC, not the shadow.
+static TM_T read_time(void)
+{
+  TM_T tm;
+
+  rtc_refresh();
+  get_date_time(&tm);
+  return tm;
+}
+
+// Moves time on until the RTC seconds count on, as the SQW edge would show.
+static void wait_rtc_edge(void)
+{
+  uint8_t sec = rtc.reg(0x00);
+
+  while (rtc.reg(0x00) == sec)
+  {
+    delayMicroseconds(100);
+  }
+}
+
+static void test_begin(void)
+{
+  TM_T tm;
+  TM_T expected = make_tm(0, 19, 6, 15, 7, 12, 34, 56);
+
+  // 300ms into 12:34:57, begin() waits for 12:34:58 to start the software
+  // second.
+  rtc.setReg(0x00, 0x56);
+  rtc.setReg(0x01, 0x34);
+  rtc.setReg(0x02, 0x12);
+  rtc.setReg(0x03, 7);
+  rtc.setReg(0x04, 0x15);
+  rtc.setReg(0x05, 0x06);
+  rtc.setReg(0x06, 0x19);
+  wait_rtc_edge();
+  delay(300);
+  softclock.begin();
+  expected.tm_sec = 58;
+  check_tm(*softclock.get(&tm), expected, __LINE__);
+
+  // Both count on together, checked half way through each second.
+  delay(500);
+  for (uint8_t idx=0; idx < 10; idx++)
+  {
+    check_tm(*softclock.get(&tm), read_time(), __LINE__);
+    delay(1000);
+  }
+}
+
+static void test_carry(void)
+{
+  static const struct {
+    TM_T from;
+    TM_T to;
+    bool rtc_agrees;
+  } carries[] = {
+    // Month, year, leap day and no leap day.
+    { make_tm(0, 21, 4, 30, 5, 23, 59, 59), make_tm(0, 21, 5, 1, 6, 0, 0, 0),
+      true },
+    { make_tm(0, 19, 12, 31, 3, 23, 59, 59), make_tm(0, 20, 1, 1, 4, 0, 0, 0),
+      true },
+    { make_tm(0, 20, 2, 28, 6, 23, 59, 59), make_tm(0, 20, 2, 29, 7, 0, 0, 0),
+      true },
+    { make_tm(0, 20, 2, 29, 7, 23, 59, 59), make_tm(0, 20, 3, 1, 1, 0, 0, 0),
+      true },
+    { make_tm(0, 21, 2, 28, 1, 23, 59, 59), make_tm(0, 21, 3, 1, 2, 0, 0, 0),
+      true },
+    // The century. 2100 isn't a leap year, but the DS3231 thinks it is.
+    { make_tm(0, 99, 12, 31, 5, 23, 59, 59), make_tm(1, 0, 1, 1, 6, 0, 0, 0),
+      true },
+    { make_tm(1, 0, 2, 28, 1, 23, 59, 59), make_tm(1, 0, 3, 1, 2, 0, 0, 0),
+      false },
+    // A day of week set independently of the date carries on from it.
+    { make_tm(0, 24, 1, 31, 7, 23, 59, 59), make_tm(0, 24, 2, 1, 1, 0, 0, 0),
+      true },
+  };
+  TM_T tm;
+
+  for (uint8_t idx=0; idx < sizeof(carries) / sizeof(carries[0]); idx++)
+  {
+    TM_T from = carries[idx].from;
+
+    softclock.set(&from);
+    delay(500);
+    check_tm(*softclock.get(&tm), carries[idx].from, __LINE__);
+    delay(1000);
+    check_tm(*softclock.get(&tm), carries[idx].to, __LINE__);
+    if (carries[idx].rtc_agrees)
+    {
+      check_tm(read_time(), carries[idx].to, __LINE__);
+    }
+  }
+}
+
+static void test_resync(void)
+{
+  I2C_BUS_STATS_T stats;
+  TM_T tm;
+
+  softclock.setResyncInterval(10000);
+  softclock.sync();
+  Wire.getStats(&stats, true);
+
+  // Served from RAM until the interval is up.
+  for (uint8_t idx=0; idx < 9; idx++)
+  {
+    delay(1000);
+    softclock.get(&tm);
+  }
+  Wire.getStats(&stats, true);
+  CHECK_EQ(stats.transactions, 0);
+
+  // Then the RTC is read until its seconds count on, once.
+  delay(1000);
+  softclock.get(&tm);
+  Wire.getStats(&stats, true);
+  CHECK(stats.transactions > 2);
+  delay(1000);
+  softclock.get(&tm);
+  Wire.getStats(&stats, true);
+  CHECK_EQ(stats.transactions, 0);
+  CHECK(softclock.getDrift() >= -2 && softclock.getDrift() <= 2);
+
+  // A second out, e.g. the RTC set by something else. The seconds are moved
+  // on without carrying into the tens.
+  softclock.setResyncInterval(SOFT_CLOCK_RESYNC_MS);
+  do
+  {
+    wait_rtc_edge();
+  } while ((rtc.reg(0x00) & 0x0F) == 9);
+  rtc.setReg(0x00, rtc.reg(0x00) + 1);
+  softclock.sync();
+  CHECK(softclock.getDrift() <= -998 && softclock.getDrift() >= -1002);
+  delay(500);
+  check_tm(*softclock.get(&tm), read_time(), __LINE__);
+}
+
+static void test_drift(void)
+{
+  TM_T tm;
+
+  // The RTC runs 10ppm fast, gaining 36ms an hour on the MCU clock.
+  rtc.setReg(0x10, (uint8_t)-100);
+  softclock.sync();
+  delay(SOFT_CLOCK_RESYNC_MS);
+  softclock.get(&tm);
+  CHECK(softclock.getDrift() >= -38 && softclock.getDrift() <= -34);
+  CHECK(softclock.getDriftPpm() >= -11 && softclock.getDriftPpm() <= -9);
+  delay(500);
+  check_tm(*softclock.get(&tm), read_time(), __LINE__);
+
+  // Running 10ppm slow, measured by align() on the SQW edge.
+  rtc.setReg(0x10, 100);
+  softclock.sync();
+  delay(SOFT_CLOCK_RESYNC_MS - 100);
+  wait_rtc_edge();
+  softclock.align();
+  CHECK(softclock.getDrift() >= 34 && softclock.getDrift() <= 38);
+  CHECK(softclock.getDriftPpm() >= 9 && softclock.getDriftPpm() <= 11);
+  delay(500);
+  check_tm(*softclock.get(&tm), read_time(), __LINE__);
+
+  // Between resyncs align() just keeps the second on the edge.
+  rtc.setReg(0x10, 0);
+  for (uint8_t idx=0; idx < 5; idx++)
+  {
+    wait_rtc_edge();
+    softclock.align();
+    delay(500);
+    check_tm(*softclock.get(&tm), read_time(), __LINE__);
+  }
+}
+
+int main(void)
+{
+  Wire.begin();
+  Wire.attach(DS3231_ADDRESS, &rtc);
+
+  test_begin();
+  test_carry();
+  test_resync();
+  test_drift();
+
+  printf("test_softclock: %d checks, %d failed\n", checks, failures);
+  return failures ? 1 : 0;
+}